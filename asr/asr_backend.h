@@ -0,0 +1,27 @@
+#ifndef ASR_BACKEND_H
+#define ASR_BACKEND_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Anything that turns a finished 16 kHz utterance into text.
+// WhisperASR is the real one; MockASR stands in for load tests.
+class ASRBackend {
+public:
+    virtual ~ASRBackend() = default;
+
+    // Calls callback once per recognized segment, on the calling thread
+    virtual void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) = 0;
+
+    // Same, biased toward the recent dialogue (see DialogueController::asrContext).
+    // Backends that can't use a prompt just transcribe.
+    virtual void transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                                       std::function<void(const std::string&)> callback) {
+        (void)context;
+        transcribe(audio, std::move(callback));
+    }
+};
+
+#endif // ASR_BACKEND_H
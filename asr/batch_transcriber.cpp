@@ -0,0 +1,286 @@
+#include "batch_transcriber.h"
+#include "whisper_stream.h"
+#include "../audio/wav_file.h"
+#include "../utils/json_util.h"
+#include "../utils/perf_monitor.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+std::vector<std::string> normalizedWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::string w;
+    for (char c : text) {
+        unsigned char u = (unsigned char)c;
+        if (std::isalnum(u) || c == '\'') {
+            w += (char)std::tolower(u);
+        } else if (!w.empty()) {
+            words.push_back(w);
+            w.clear();
+        }
+    }
+    if (!w.empty()) words.push_back(w);
+    return words;
+}
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return "";
+    return s.substr(b, s.find_last_not_of(" \t\r\n") - b + 1);
+}
+
+} // namespace
+
+BatchTranscriber::BatchTranscriber(WhisperASR* engine, const Config& cfg) : asr(engine), config(cfg) {
+    int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    if (config.workers <= 0) config.workers = std::max(1, hw / 4);
+    if (config.threads_per_worker <= 0) config.threads_per_worker = std::max(1, hw / config.workers);
+}
+
+bool BatchTranscriber::collect(const std::string& input, std::vector<Item>& items) {
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+        for (const auto& e : fs::recursive_directory_iterator(input, ec)) {
+            if (!e.is_regular_file()) continue;
+            std::string ext = e.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+            if (ext != ".wav" && ext != ".pcm" && ext != ".raw") continue;
+            Item item;
+            item.path = e.path().string();
+            item.id = fs::relative(e.path(), input, ec).generic_string();
+            items.push_back(item);
+        }
+        // Directory order is arbitrary; keep runs comparable
+        std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.id < b.id; });
+        return true;
+    }
+
+    std::ifstream manifest(input);
+    if (!manifest.is_open()) {
+        std::cerr << "[Batch] Could not open " << input << std::endl;
+        return false;
+    }
+    fs::path base = fs::path(input).parent_path();
+    std::string line;
+    while (std::getline(manifest, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        Item item;
+        size_t tab = line.find('\t');
+        item.id = trim(line.substr(0, tab));
+        if (tab != std::string::npos) item.reference = trim(line.substr(tab + 1));
+        fs::path p(item.id);
+        item.path = (p.is_relative() && !fs::exists(p) ? base / p : p).string();
+        items.push_back(item);
+    }
+    return true;
+}
+
+std::vector<BatchTranscriber::Window> BatchTranscriber::plan(const std::vector<Item>& items,
+                                                             const std::vector<double>& seconds) const {
+    // Greedy, in input order: fill the current window until the next file doesn't fit
+    std::vector<Window> windows;
+    double used = 0.0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        bool packable = config.pack && seconds[i] > 0.0 && seconds[i] <= config.pack_max_s;
+        bool fits = used > 0.0 && used + config.gap_s + seconds[i] <= config.window_s;
+        if (packable && fits) {
+            windows.back().items.push_back(i);
+            used += config.gap_s + seconds[i];
+            continue;
+        }
+        windows.push_back(Window{{i}});
+        used = packable ? seconds[i] : 0.0; // 0 = closed to packing
+    }
+    return windows;
+}
+
+void BatchTranscriber::run(const std::vector<Item>& items, const std::function<void(const Result&)>& on_result) {
+    if (items.empty()) return;
+    if (!asr || !asr->ctx) {
+        for (const Item& item : items) {
+            Result r;
+            r.item = item;
+            r.error = "no model loaded";
+            on_result(r);
+        }
+        return;
+    }
+
+    // Headers only: durations for packing (the audio itself is read by the workers)
+    std::vector<double> seconds(items.size(), 0.0);
+    for (size_t i = 0; i < items.size(); ++i) {
+        WavFile wav;
+        if (wav.open(items[i].path)) seconds[i] = wav.seconds();
+    }
+    std::vector<Window> windows = plan(items, seconds);
+    std::cout << "[Batch] " << items.size() << " files in " << windows.size() << " windows, "
+              << config.workers << " workers x " << config.threads_per_worker << " threads" << std::endl;
+
+    std::mutex out_mutex, init_mutex;
+    std::atomic<size_t> next{0};
+    const int gap_samples = (int)(config.gap_s * WavFile::kTargetRate);
+
+    auto worker = [&](int worker_id) {
+        PerfMonitor::getInstance().setThreadName("batch_worker");
+        whisper_state* state = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(init_mutex); // Backend setup isn't meant to race
+            state = whisper_init_state(asr->ctx);
+        }
+        if (!state) {
+            std::cerr << "[Batch] Worker " << worker_id << " could not allocate a whisper state" << std::endl;
+            return;
+        }
+        std::vector<float> pcm, file_pcm;
+        size_t w;
+        while ((w = next++) < windows.size()) {
+            const Window& window = windows[w];
+            std::vector<Result> results(window.items.size());
+            std::vector<std::pair<double, double>> spans; // Each file's [start, end] in the window, seconds
+            pcm.clear();
+
+            auto load_start = Clock::now();
+            for (size_t k = 0; k < window.items.size(); ++k) {
+                Result& r = results[k];
+                r.item = items[window.items[k]];
+                r.window = (int)w;
+                r.packed = (int)window.items.size();
+                r.worker = worker_id;
+
+                WavFile wav;
+                if (!wav.open(r.item.path) || !wav.readFloat(file_pcm)) {
+                    r.error = "could not read audio";
+                    spans.emplace_back(-1.0, -1.0);
+                    continue;
+                }
+                if (!pcm.empty()) pcm.insert(pcm.end(), gap_samples, 0.0f);
+                double start = (double)pcm.size() / WavFile::kTargetRate;
+                pcm.insert(pcm.end(), file_pcm.begin(), file_pcm.end());
+                r.audio_s = (double)file_pcm.size() / WavFile::kTargetRate;
+                spans.emplace_back(start, start + r.audio_s);
+            }
+            double load_ms = msSince(load_start);
+
+            bool packed = window.items.size() > 1;
+            whisper_full_params params = asr->paramsFor(pcm.size());
+            params.n_threads = config.threads_per_worker;
+            params.no_context = true; // Files are unrelated
+            if (packed) {
+                // One segment per word, so each word can be given back to its file
+                params.single_segment = false;
+                params.no_timestamps = false;
+                params.max_tokens = 0;
+                params.token_timestamps = true;
+                params.max_len = 1;
+                params.split_on_word = true;
+            }
+
+            auto asr_start = Clock::now();
+            bool decoded = !pcm.empty() && whisper_full_with_state(asr->ctx, state, params, pcm.data(), (int)pcm.size()) == 0;
+            double asr_ms = msSince(asr_start);
+
+            if (decoded) {
+                int n = whisper_full_n_segments_from_state(state);
+                for (int s = 0; s < n; ++s) {
+                    std::string text = whisper_full_get_segment_text_from_state(state, s);
+                    size_t owner = 0;
+                    if (packed) {
+                        // Timestamps are in 10 ms units; the word's midpoint decides the file
+                        double mid = (whisper_full_get_segment_t0_from_state(state, s) +
+                                      whisper_full_get_segment_t1_from_state(state, s)) / 200.0;
+                        double best = 1e9;
+                        for (size_t k = 0; k < spans.size(); ++k) {
+                            if (spans[k].first < 0) continue;
+                            double d = mid < spans[k].first ? spans[k].first - mid
+                                     : mid > spans[k].second ? mid - spans[k].second : 0.0;
+                            if (d < best) { best = d; owner = k; }
+                        }
+                    }
+                    results[owner].text += text;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(out_mutex);
+            for (Result& r : results) {
+                if (r.error.empty()) {
+                    r.ok = decoded;
+                    if (!decoded) r.error = "whisper_full failed";
+                }
+                r.text = trim(r.text);
+                r.load_ms = load_ms;
+                r.asr_ms = asr_ms;
+                if (!r.item.reference.empty()) r.word_errors = wordErrors(r.item.reference, r.text, &r.ref_words);
+                on_result(r);
+            }
+        }
+        whisper_free_state(state);
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < config.workers; ++i) threads.emplace_back(worker, i);
+    for (auto& t : threads) t.join();
+
+    // Windows no worker got to (every whisper_init_state failed) still get a result each
+    for (size_t w = std::min(next.load(), windows.size()); w < windows.size(); ++w) {
+        for (size_t i : windows[w].items) {
+            Result r;
+            r.item = items[i];
+            r.window = (int)w;
+            r.packed = (int)windows[w].items.size();
+            r.error = "no whisper state";
+            on_result(r);
+        }
+    }
+}
+
+int BatchTranscriber::wordErrors(const std::string& reference, const std::string& hypothesis, int* ref_words) {
+    std::vector<std::string> ref = normalizedWords(reference);
+    std::vector<std::string> hyp = normalizedWords(hypothesis);
+    if (ref_words) *ref_words = (int)ref.size();
+
+    // Levenshtein over words, one row at a time
+    std::vector<int> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) prev[j] = (int)j;
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        cur[0] = (int)i;
+        for (size_t j = 1; j <= hyp.size(); ++j) {
+            int sub = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+            cur[j] = std::min({sub, prev[j] + 1, cur[j - 1] + 1});
+        }
+        std::swap(prev, cur);
+    }
+    return prev[hyp.size()];
+}
+
+std::string BatchTranscriber::resultJson(const Result& r) {
+    std::ostringstream o;
+    o << "{\"id\":\"" << jsonEscape(r.item.id) << "\",\"ok\":" << (r.ok ? "true" : "false")
+      << ",\"text\":\"" << jsonEscape(r.text) << "\",\"audio_s\":" << r.audio_s
+      << ",\"window\":" << r.window << ",\"packed\":" << r.packed << ",\"worker\":" << r.worker
+      << ",\"load_ms\":" << r.load_ms << ",\"asr_ms\":" << r.asr_ms;
+    if (!r.item.reference.empty()) {
+        o << ",\"reference\":\"" << jsonEscape(r.item.reference) << "\",\"word_errors\":" << r.word_errors
+          << ",\"ref_words\":" << r.ref_words;
+    }
+    if (!r.error.empty()) o << ",\"error\":\"" << jsonEscape(r.error) << "\"";
+    o << "}";
+    return o.str();
+}
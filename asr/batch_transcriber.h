@@ -0,0 +1,76 @@
+#ifndef BATCH_TRANSCRIBER_H
+#define BATCH_TRANSCRIBER_H
+
+#include "whisper.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+class WhisperASR;
+
+// Offline transcription of many files (evaluation runs, call-log backfill).
+//
+// Workers each own a whisper_state on the one loaded model, so N files decode
+// at once without N copies of the weights. Short files are packed back to back
+// (with a silence gap) into one 30 s window, since Whisper pays for the full
+// window either way; word timestamps split the text back out per file.
+class BatchTranscriber {
+public:
+    struct Config {
+        int workers = 0;             // 0 = hardware threads / 4
+        int threads_per_worker = 0;  // 0 = hardware threads / workers
+        bool pack = true;
+        double window_s = 30.0;      // Whisper's encoder window
+        double pack_max_s = 10.0;    // Longer files get a window of their own
+        double gap_s = 1.0;          // Silence between packed files
+    };
+
+    struct Item {
+        std::string id;        // Path relative to the input directory, or as listed
+        std::string path;
+        std::string reference; // Optional expected text (enables WER)
+    };
+
+    struct Result {
+        Item item;
+        bool ok = false;
+        std::string error;
+        std::string text;
+        double audio_s = 0.0;
+        int window = -1;       // Files with the same window were decoded together
+        int packed = 1;        // Files in that window
+        int worker = -1;
+        double load_ms = 0.0;
+        double asr_ms = 0.0;   // Whole window's decode time
+        int ref_words = 0;
+        int word_errors = 0;
+    };
+
+    BatchTranscriber(WhisperASR* asr, const Config& config);
+
+    // A directory (every .wav / .pcm / .raw below it) or a manifest: one file per
+    // line, optionally followed by a tab and the reference transcript
+    static bool collect(const std::string& input, std::vector<Item>& items);
+
+    // Blocks until every item is done; on_result is called (serialized) as they finish,
+    // exactly once per item (ok = false if it could not be decoded for any reason)
+    void run(const std::vector<Item>& items, const std::function<void(const Result&)>& on_result);
+
+    const Config& settings() const { return config; }
+
+    // Word-level edit distance after lowercasing and stripping punctuation
+    static int wordErrors(const std::string& reference, const std::string& hypothesis, int* ref_words = nullptr);
+    static std::string resultJson(const Result& r);
+
+private:
+    struct Window {
+        std::vector<size_t> items;
+    };
+
+    WhisperASR* asr;
+    Config config;
+
+    std::vector<Window> plan(const std::vector<Item>& items, const std::vector<double>& seconds) const;
+};
+
+#endif // BATCH_TRANSCRIBER_H
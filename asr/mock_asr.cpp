@@ -0,0 +1,15 @@
+#include "mock_asr.h"
+#include <chrono>
+#include <thread>
+
+MockASR::MockASR(std::vector<std::string> t, double fixed, double per_second)
+    : transcripts(std::move(t)), next(0), fixed_ms(fixed), ms_per_audio_second(per_second) {
+    if (transcripts.empty()) transcripts.push_back("Hello there");
+}
+
+void MockASR::transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) {
+    double audio_s = audio.size() / 16000.0;
+    double delay_ms = fixed_ms + ms_per_audio_second * audio_s;
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(delay_ms * 1000.0)));
+    callback(transcripts[next++ % transcripts.size()]);
+}
@@ -0,0 +1,25 @@
+#ifndef MOCK_ASR_H
+#define MOCK_ASR_H
+
+#include "asr_backend.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Stand-in for WhisperASR: returns canned transcripts (round robin) after a
+// synthetic delay of fixed_ms + ms_per_audio_second * utterance length.
+// Thread-safe, so one instance can serve every session in a load test.
+class MockASR : public ASRBackend {
+public:
+    MockASR(std::vector<std::string> transcripts, double fixed_ms = 150.0, double ms_per_audio_second = 30.0);
+
+    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) override;
+
+private:
+    std::vector<std::string> transcripts;
+    std::atomic<size_t> next;
+    double fixed_ms;
+    double ms_per_audio_second;
+};
+
+#endif // MOCK_ASR_H
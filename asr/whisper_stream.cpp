@@ -1,12 +1,32 @@
 #include "whisper_stream.h"
+#include "../audio/wav_file.h"
+#include <algorithm>
 #include <iostream>
+#include <thread>
 
-WhisperASR::WhisperASR(const std::string& model_path) {
+WhisperASR::WhisperASR(const std::string& model_path) : WhisperASR(model_path, Config()) {}
+
+WhisperASR::WhisperASR(const std::string& model_path, const Config& cfg) : config(cfg) {
     // whisper_init_from_file returns whisper_context*
     ctx = whisper_init_from_file(model_path.c_str());
     if (!ctx) {
         std::cerr << "Failed to initialize whisper context" << std::endl;
     }
+
+    params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    params.n_threads = config.threads > 0 ? config.threads : std::max(1, std::min(8, hw / 2));
+    params.single_segment = config.single_segment;
+    params.no_timestamps = config.no_timestamps;
+    if (!config.temperature_fallback) params.temperature_inc = 0.0f;
+    params.max_tokens = config.max_tokens;
+    params.suppress_nst = config.suppress_nst;
+    params.suppress_blank = true;
+    params.language = config.language.c_str(); // Points into config: set language before constructing
+    params.detect_language = false;
 }
 
 WhisperASR::~WhisperASR() {
@@ -14,6 +34,11 @@ WhisperASR::~WhisperASR() {
 }
 
 void WhisperASR::transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) {
+    transcribeWithContext(audio, "", callback);
+}
+
+void WhisperASR::transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                                       std::function<void(const std::string&)> callback) {
     if (!ctx) return;
 
     // Convert int16 to float normalized -1..1
@@ -21,14 +46,68 @@ void WhisperASR::transcribe(const std::vector<int16_t>& audio, std::function<voi
     for (size_t i = 0; i < audio.size(); i++) {
         pcmf32[i] = (float)audio[i] / 32768.0f;
     }
+    transcribePcm(pcmf32.data(), pcmf32.size(), callback, context);
+}
 
-    params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-    params.print_progress = false;
+const std::vector<whisper_token>& WhisperASR::promptTokens(const std::string& context) {
+    auto it = prompt_cache.find(context);
+    if (it != prompt_cache.end()) return it->second;
+
+    if (prompt_cache.size() >= 64) prompt_cache.clear(); // Old turns' prompts never come back
+    std::vector<whisper_token> tokens(context.size() + 8);
+    int n = whisper_tokenize(ctx, context.c_str(), tokens.data(), (int)tokens.size());
+    tokens.resize(n > 0 ? n : 0);
+    // The end of the context (what was said last) matters most
+    if ((int)tokens.size() > config.max_prompt_tokens) {
+        tokens.erase(tokens.begin(), tokens.end() - config.max_prompt_tokens);
+    }
+    return prompt_cache.emplace(context, std::move(tokens)).first->second;
+}
+
+int WhisperASR::audioCtxFor(size_t samples) const {
+    if (!config.trim_audio_ctx || !ctx) return 0;
+    double seconds = samples / 16000.0;
+    if (seconds > config.trim_max_s) return 0;
+
+    // 50 positions per second of audio, rounded up to 64 (friendlier kernel shapes)
+    int full = whisper_n_audio_ctx(ctx);
+    int needed = (int)(seconds * 50.0 + 0.999) + config.trim_pad_ctx;
+    needed = (needed + 63) / 64 * 64;
+    return needed >= full ? 0 : needed;
+}
+
+whisper_full_params WhisperASR::paramsFor(size_t samples) const {
+    whisper_full_params p = params;
+    p.audio_ctx = audioCtxFor(samples);
+    if (samples > 30 * 16000) {
+        // More than one window: whisper has to seek, and the token cap would cut it short
+        p.single_segment = false;
+        p.max_tokens = 0;
+    }
+    return p;
+}
+
+void WhisperASR::transcribePcm(const float* pcm, size_t samples, std::function<void(const std::string&)> callback,
+                               const std::string& context) {
+    if (!ctx) return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    whisper_full_params p = paramsFor(samples);
+    if (!context.empty() && config.max_prompt_tokens > 0) {
+        const std::vector<whisper_token>& prompt = promptTokens(context);
+        p.prompt_tokens = prompt.empty() ? nullptr : prompt.data();
+        p.prompt_n_tokens = (int)prompt.size();
+    }
     
-    if (whisper_full(ctx, params, pcmf32.data(), pcmf32.size()) != 0) {
+    if (whisper_full(ctx, p, pcm, (int)samples) != 0) {
         std::cerr << "Failed to process audio" << std::endl;
         return;
     }
+    if (p.audio_ctx > 0 && whisper_full_n_segments(ctx) == 0) {
+        // Nothing from the trimmed window: give the full one a chance before reporting silence
+        p.audio_ctx = 0;
+        if (whisper_full(ctx, p, pcm, (int)samples) != 0) return;
+    }
 
     const int n_segments = whisper_full_n_segments(ctx);
     for (int i = 0; i < n_segments; ++i) {
@@ -36,25 +115,19 @@ void WhisperASR::transcribe(const std::vector<int16_t>& audio, std::function<voi
         callback(std::string(text));
     }
 }
-#include <fstream>
+
+bool WhisperASR::load_wav(const std::string& wav_path, std::vector<int16_t>& audio) {
+    WavFile wav;
+    if (!wav.open(wav_path)) return false;
+    return wav.read(audio);
+}
 
 void WhisperASR::transcribe_wav(const std::string& wav_path, std::function<void(const std::string&)> callback) {
     if (!ctx) return;
 
-    std::ifstream file(wav_path, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "[Whisper] Could not open wav file: " << wav_path << std::endl;
-        return;
-    }
-
-    // Skip WAV header (44 bytes for standard RIFF)
-    file.seekg(44, std::ios::beg);
-
-    std::vector<int16_t> audio;
-    int16_t sample;
-    while (file.read(reinterpret_cast<char*>(&sample), sizeof(int16_t))) {
-        audio.push_back(sample);
-    }
-    
-    transcribe(audio, callback);
+    // Straight from the mapped file to the float buffer Whisper takes
+    WavFile wav;
+    std::vector<float> pcm;
+    if (!wav.open(wav_path) || !wav.readFloat(pcm)) return;
+    transcribePcm(pcm.data(), pcm.size(), callback);
 }
@@ -2,20 +2,68 @@
 #define WHISPER_STREAM_H
 
 #include "whisper.h" 
+#include "asr_backend.h"
 #include <string>
 #include <vector>
 #include <functional>
+#include <mutex>
+#include <unordered_map>
 
-class WhisperASR {
+class WhisperASR : public ASRBackend {
 public:
+    struct Config {
+        // Decoding profile for short conversational turns. Built once into
+        // `params`; each field below cuts decoder work on every utterance.
+        int threads = 0;                   // 0 = half the cores (max 8): the LLM and TTS run meanwhile
+        bool single_segment = true;        // One segment per utterance, no seek loop (audio <= 30 s)
+        bool no_timestamps = true;         // Timestamp tokens are decoder steps nobody reads
+        bool temperature_fallback = false; // Re-decoding hotter on low confidence doubles worst-case latency
+        int max_tokens = 128;              // Runaway guard for a single segment (0 = no limit)
+        bool suppress_nst = true;          // Never emit [BLANK_AUDIO], (Video Ad), music notes...
+        std::string language = "en";
+        int max_prompt_tokens = 96;        // Context prompt cap (newest tokens kept); 0 ignores context
+
+        // Whisper encodes a fixed 30 s window; a 1-2 s command is mostly padding.
+        // Trimming runs the encoder on just the utterance (plus a pad) instead.
+        bool trim_audio_ctx = true;
+        double trim_max_s = 10.0; // Longer audio keeps the full window
+        int trim_pad_ctx = 64;    // Extra encoder positions (20 ms each) past the audio
+    };
+
     struct whisper_context* ctx;
     struct whisper_full_params params;
+    Config config;
 
     WhisperASR(const std::string& model_path);
+    WhisperASR(const std::string& model_path, const Config& config);
     ~WhisperASR();
 
-    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback);
+    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) override;
+    void transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                               std::function<void(const std::string&)> callback) override;
     void transcribe_wav(const std::string& wav_path, std::function<void(const std::string&)> callback);
+
+    // 16 kHz mono samples from a wav (or raw .pcm) file, converted if needed
+    // (see WavFile); false if it can't be opened or parsed
+    static bool load_wav(const std::string& wav_path, std::vector<int16_t>& audio);
+
+    // Encoder positions for this much audio (0 = whisper's full window)
+    int audioCtxFor(size_t samples) const;
+    // The profile's params for one call of this length (audio_ctx, long-audio overrides)
+    whisper_full_params paramsFor(size_t samples) const;
+
+    // Transcribes 16 kHz mono float PCM in place (no copy); context becomes the
+    // decoder's initial prompt
+    void transcribePcm(const float* pcm, size_t samples, std::function<void(const std::string&)> callback,
+                       const std::string& context = "");
+
+private:
+    std::mutex mtx; // One whisper_full at a time (finals and endpoint partials share ctx)
+
+    // Tokenized prompts by text (guarded by mtx). The context only changes once
+    // per turn, so nearly every call is a lookup.
+    std::unordered_map<std::string, std::vector<whisper_token>> prompt_cache;
+    const std::vector<whisper_token>& promptTokens(const std::string& context);
 };
 
 
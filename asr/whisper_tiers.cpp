@@ -0,0 +1,104 @@
+#include "whisper_tiers.h"
+#include <iostream>
+#include <sstream>
+
+bool WhisperTiers::Routing::parse(const std::string& spec) {
+    std::stringstream ss(spec);
+    std::string entry;
+    while (std::getline(ss, entry, ',')) {
+        size_t eq = entry.find('=');
+        if (eq == std::string::npos || eq + 1 == entry.size()) return false;
+        std::string use = entry.substr(0, eq);
+        std::string tier = entry.substr(eq + 1);
+        if (use == "final") final_tier = tier;
+        else if (use == "barge_in" || use == "bargein") barge_in = tier;
+        else if (use == "partial") partial = tier;
+        else return false;
+    }
+    return true;
+}
+
+WhisperTiers::WhisperTiers() : WhisperTiers(WhisperASR::Config(), Routing()) {}
+
+WhisperTiers::WhisperTiers(const WhisperASR::Config& cfg, const Routing& routing) : config(cfg), route(routing) {
+    for (int i = 0; i < (int)Use::Count; ++i) {
+        views[i].tiers = this;
+        views[i].use = (Use)i;
+    }
+}
+
+bool WhisperTiers::load(const std::string& tier, const std::string& model_path) {
+    // Load outside the lock: the other tiers keep serving meanwhile
+    std::shared_ptr<WhisperASR> asr = std::make_shared<WhisperASR>(model_path, config);
+    if (!asr->ctx) {
+        std::cerr << "[ASR] Could not load tier '" << tier << "' from " << model_path << std::endl;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        models[tier] = asr; // A replaced model is freed by its last in-flight call
+    }
+    std::cout << "[ASR] Tier '" << tier << "' loaded: " << model_path << std::endl;
+    return true;
+}
+
+void WhisperTiers::unload(const std::string& tier) {
+    std::lock_guard<std::mutex> lock(mtx);
+    models.erase(tier);
+}
+
+bool WhisperTiers::loaded(const std::string& tier) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return models.count(tier) > 0;
+}
+
+void WhisperTiers::setRouting(const Routing& routing) {
+    std::lock_guard<std::mutex> lock(mtx);
+    route = routing;
+}
+
+WhisperTiers::Routing WhisperTiers::routing() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return route;
+}
+
+std::map<std::string, std::shared_ptr<WhisperASR>>::const_iterator WhisperTiers::resolve(Use use) const {
+    const std::string& tier = use == Use::BargeIn ? route.barge_in
+                            : use == Use::Partial ? route.partial : route.final_tier;
+    auto it = models.find(tier);
+    if (it == models.end()) it = models.find(route.final_tier);
+    if (it == models.end()) it = models.begin();
+    return it;
+}
+
+std::shared_ptr<WhisperASR> WhisperTiers::model(Use use) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = resolve(use);
+    return it == models.end() ? nullptr : it->second;
+}
+
+std::string WhisperTiers::describeRouting() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string out;
+    for (int i = 0; i < (int)Use::Count; ++i) {
+        auto it = resolve((Use)i);
+        if (i) out += ' ';
+        out += std::string(useName((Use)i)) + "=" + (it == models.end() ? "(none)" : it->first);
+    }
+    return out;
+}
+
+const char* WhisperTiers::useName(Use use) {
+    switch (use) {
+        case Use::Final: return "final";
+        case Use::BargeIn: return "barge_in";
+        case Use::Partial: return "partial";
+        default: return "?";
+    }
+}
+
+void WhisperTiers::View::transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                                               std::function<void(const std::string&)> callback) {
+    std::shared_ptr<WhisperASR> asr = tiers->model(use);
+    if (asr) asr->transcribeWithContext(audio, context, std::move(callback));
+}
@@ -0,0 +1,81 @@
+#ifndef WHISPER_TIERS_H
+#define WHISPER_TIERS_H
+
+#include "whisper_stream.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Several Whisper models loaded side by side ("tiny", "medium", ...), each with
+// its own context and lock, so a barge-in check never queues behind a
+// medium-model decode of an ordinary turn.
+//
+// Callers ask for a use, not a model: backend(Use) is an ASRBackend that
+// resolves the routed tier on every call. Tiers can be (re)loaded or dropped
+// while running; calls in flight keep the old model alive until they return.
+class WhisperTiers {
+public:
+    enum class Use {
+        Final,   // Transcript of a turn the agent will answer
+        BargeIn, // Speech over the agent: only needs interrupt vs. backchannel
+        Partial, // End-of-turn scoring at each pause
+        Count
+    };
+
+    // Tier name per use. A use whose tier isn't loaded falls back to the
+    // Final tier, then to any loaded one.
+    struct Routing {
+        std::string final_tier = "medium";
+        std::string barge_in = "tiny";
+        std::string partial = "tiny";
+
+        // "final=medium,barge_in=tiny,partial=medium"; false on a bad entry
+        bool parse(const std::string& spec);
+    };
+
+    WhisperTiers();
+    WhisperTiers(const WhisperASR::Config& config, const Routing& routing);
+
+    // Loads (or replaces) a tier; false, leaving any old model in place, if the file won't load
+    bool load(const std::string& tier, const std::string& model_path);
+    void unload(const std::string& tier);
+    bool loaded(const std::string& tier) const;
+
+    void setRouting(const Routing& routing);
+    Routing routing() const;
+
+    // Model currently serving a use (null when nothing is loaded). Hold the
+    // pointer for the duration of the call.
+    std::shared_ptr<WhisperASR> model(Use use) const;
+    ASRBackend* backend(Use use) { return &views[(int)use]; }
+
+    // "final=medium barge_in=tiny partial=tiny", after fallbacks
+    std::string describeRouting() const;
+
+    static const char* useName(Use use);
+
+private:
+    class View : public ASRBackend {
+    public:
+        WhisperTiers* tiers = nullptr;
+        Use use = Use::Final;
+
+        void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) override {
+            transcribeWithContext(audio, "", std::move(callback));
+        }
+        void transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                                   std::function<void(const std::string&)> callback) override;
+    };
+
+    WhisperASR::Config config;
+    mutable std::mutex mtx; // Guards models and route (never held during a decode)
+    std::map<std::string, std::shared_ptr<WhisperASR>> models;
+    Routing route;
+    View views[(int)Use::Count];
+
+    // Loaded tier serving a use, or models.end() (mtx held)
+    std::map<std::string, std::shared_ptr<WhisperASR>>::const_iterator resolve(Use use) const;
+};
+
+#endif // WHISPER_TIERS_H
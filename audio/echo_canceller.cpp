@@ -0,0 +1,237 @@
+#include "echo_canceller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AEC_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AEC_NEON 1
+#endif
+
+namespace {
+
+const int kHoldBlocks = 8;      // Keep adaptation frozen this long after double talk (~128 ms)
+const int kRelearnBlocks = 62;  // ~1 s of "double talk" is an echo path change (barge-in stops playback well before)
+
+// Spectra are split real / imaginary arrays padded to a multiple of 4, so the
+// bin loops below map one-to-one onto 4-wide vector lanes.
+
+// y += a * b
+void complexMac(const float* ar, const float* ai, const float* br, const float* bi,
+                float* yr, float* yi, int n) {
+    int k = 0;
+#if defined(AEC_SSE)
+    for (; k + 4 <= n; k += 4) {
+        __m128 a_r = _mm_loadu_ps(ar + k), a_i = _mm_loadu_ps(ai + k);
+        __m128 b_r = _mm_loadu_ps(br + k), b_i = _mm_loadu_ps(bi + k);
+        __m128 re = _mm_sub_ps(_mm_mul_ps(a_r, b_r), _mm_mul_ps(a_i, b_i));
+        __m128 im = _mm_add_ps(_mm_mul_ps(a_r, b_i), _mm_mul_ps(a_i, b_r));
+        _mm_storeu_ps(yr + k, _mm_add_ps(_mm_loadu_ps(yr + k), re));
+        _mm_storeu_ps(yi + k, _mm_add_ps(_mm_loadu_ps(yi + k), im));
+    }
+#elif defined(AEC_NEON)
+    for (; k + 4 <= n; k += 4) {
+        float32x4_t a_r = vld1q_f32(ar + k), a_i = vld1q_f32(ai + k);
+        float32x4_t b_r = vld1q_f32(br + k), b_i = vld1q_f32(bi + k);
+        float32x4_t re = vmlsq_f32(vmulq_f32(a_r, b_r), a_i, b_i);
+        float32x4_t im = vmlaq_f32(vmulq_f32(a_r, b_i), a_i, b_r);
+        vst1q_f32(yr + k, vaddq_f32(vld1q_f32(yr + k), re));
+        vst1q_f32(yi + k, vaddq_f32(vld1q_f32(yi + k), im));
+    }
+#endif
+    for (; k < n; ++k) {
+        yr[k] += ar[k] * br[k] - ai[k] * bi[k];
+        yi[k] += ar[k] * bi[k] + ai[k] * br[k];
+    }
+}
+
+// w += conj(x) * g (filter gradient step)
+void conjMac(const float* xr, const float* xi, const float* gr, const float* gi,
+             float* wr, float* wi, int n) {
+    int k = 0;
+#if defined(AEC_SSE)
+    for (; k + 4 <= n; k += 4) {
+        __m128 x_r = _mm_loadu_ps(xr + k), x_i = _mm_loadu_ps(xi + k);
+        __m128 g_r = _mm_loadu_ps(gr + k), g_i = _mm_loadu_ps(gi + k);
+        __m128 re = _mm_add_ps(_mm_mul_ps(x_r, g_r), _mm_mul_ps(x_i, g_i));
+        __m128 im = _mm_sub_ps(_mm_mul_ps(x_r, g_i), _mm_mul_ps(x_i, g_r));
+        _mm_storeu_ps(wr + k, _mm_add_ps(_mm_loadu_ps(wr + k), re));
+        _mm_storeu_ps(wi + k, _mm_add_ps(_mm_loadu_ps(wi + k), im));
+    }
+#elif defined(AEC_NEON)
+    for (; k + 4 <= n; k += 4) {
+        float32x4_t x_r = vld1q_f32(xr + k), x_i = vld1q_f32(xi + k);
+        float32x4_t g_r = vld1q_f32(gr + k), g_i = vld1q_f32(gi + k);
+        float32x4_t re = vmlaq_f32(vmulq_f32(x_r, g_r), x_i, g_i);
+        float32x4_t im = vmlsq_f32(vmulq_f32(x_r, g_i), x_i, g_r);
+        vst1q_f32(wr + k, vaddq_f32(vld1q_f32(wr + k), re));
+        vst1q_f32(wi + k, vaddq_f32(vld1q_f32(wi + k), im));
+    }
+#endif
+    for (; k < n; ++k) {
+        wr[k] += xr[k] * gr[k] + xi[k] * gi[k];
+        wi[k] += xr[k] * gi[k] - xi[k] * gr[k];
+    }
+}
+
+float peakAbs(const float* x, int n) {
+    float p = 0.0f;
+    for (int i = 0; i < n; ++i) p = std::max(p, std::fabs(x[i]));
+    return p;
+}
+
+} // namespace
+
+EchoCanceller::EchoCanceller() : EchoCanceller(Config()) {}
+
+EchoCanceller::EchoCanceller(const Config& cfg)
+    : config(cfg),
+      N(cfg.block),
+      K(cfg.block + 1),
+      Kp((cfg.block + 1 + 3) & ~3),
+      fft(2 * cfg.block) {
+    size_t delay = (size_t)std::max(0.0, cfg.delay_ms * cfg.sample_rate / 1000.0);
+    delay_line.assign(delay, 0.0f);
+    x_old.assign(N, 0.0f);
+    Xr.assign((size_t)cfg.partitions * Kp, 0.0f);
+    Xi.assign(Xr.size(), 0.0f);
+    Wr.assign(Xr.size(), 0.0f);
+    Wi.assign(Xr.size(), 0.0f);
+    peak.assign(cfg.partitions, 0.0f);
+    power.assign(Kp, 0.0f);
+    for (auto* v : {&Yr, &Yi, &Er, &Ei, &Gr, &Gi}) v->assign(Kp, 0.0f);
+    time_buf.assign(2 * N, 0.0f);
+    y_buf.assign(2 * N, 0.0f);
+    d_blk.assign(N, 0.0f);
+    x_blk.assign(N, 0.0f);
+    e_blk.assign(N, 0.0f);
+    ready.reserve(4 * N);
+}
+
+void EchoCanceller::reset() {
+    std::fill(delay_line.begin(), delay_line.end(), 0.0f);
+    delay_pos = 0;
+    std::fill(x_old.begin(), x_old.end(), 0.0f);
+    for (auto* v : {&Xr, &Xi, &Wr, &Wi, &peak, &power}) std::fill(v->begin(), v->end(), 0.0f);
+    x_head = 0;
+    fill = 0;
+    ready.clear();
+    erle_db = 0.0f;
+    hold = diverged_blocks = 0;
+    far_active = double_talk = false;
+}
+
+void EchoCanceller::process(const int16_t* mic, const int16_t* ref, int16_t* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        d_blk[fill] = mic[i];
+        float r = ref ? (float)ref[i] : 0.0f;
+        if (!delay_line.empty()) {
+            float delayed = delay_line[delay_pos];
+            delay_line[delay_pos] = r;
+            delay_pos = (delay_pos + 1) % delay_line.size();
+            r = delayed;
+        }
+        x_blk[fill] = r;
+        if (++fill < N) continue;
+
+        fill = 0;
+        processBlock(d_blk.data(), x_blk.data(), e_blk.data());
+        for (int k = 0; k < N; ++k) {
+            ready.push_back((int16_t)std::max(-32768.0f, std::min(32767.0f, std::round(e_blk[k]))));
+        }
+    }
+
+    // All of mic has been read, so out may alias it now. Short only when a new
+    // partial block was held back: that shift is filled with silence, not raw echo.
+    size_t pad = ready.size() < n ? n - ready.size() : 0;
+    std::fill(out, out + pad, (int16_t)0);
+    std::copy(ready.begin(), ready.begin() + (n - pad), out + pad);
+    ready.erase(ready.begin(), ready.begin() + (n - pad));
+}
+
+void EchoCanceller::processBlock(const float* d, const float* x, float* e) {
+    const int P = config.partitions;
+
+    // Newest reference spectrum: FFT of [previous block, this block]
+    x_head = (x_head + P - 1) % P;
+    std::memcpy(time_buf.data(), x_old.data(), N * sizeof(float));
+    std::memcpy(time_buf.data() + N, x, N * sizeof(float));
+    std::memcpy(x_old.data(), x, N * sizeof(float));
+    float* xr0 = &Xr[(size_t)x_head * Kp];
+    float* xi0 = &Xi[(size_t)x_head * Kp];
+    fft.forward(time_buf.data(), xr0, xi0);
+    peak[x_head] = peakAbs(x, N);
+
+    // Echo estimate: sum over partitions of W_p * X_(k-p), last N samples of the IFFT
+    std::fill(Yr.begin(), Yr.end(), 0.0f);
+    std::fill(Yi.begin(), Yi.end(), 0.0f);
+    for (int p = 0; p < P; ++p) {
+        size_t xp = (size_t)((x_head + p) % P) * Kp;
+        size_t wp = (size_t)p * Kp;
+        complexMac(&Wr[wp], &Wi[wp], &Xr[xp], &Xi[xp], Yr.data(), Yi.data(), Kp);
+    }
+    fft.inverse(Yr.data(), Yi.data(), y_buf.data());
+
+    float far_peak = *std::max_element(peak.begin(), peak.end());
+    float near_peak = peakAbs(d, N);
+    float e_energy = 0.0f, d_energy = 0.0f;
+    for (int i = 0; i < N; ++i) {
+        e[i] = d[i] - y_buf[N + i];
+        e_energy += e[i] * e[i];
+        d_energy += d[i] * d[i];
+    }
+
+    // Double talk: Geigel (near end louder than the echo could be), or a converged
+    // filter suddenly cancelling much less than usual (near end below the echo level)
+    far_active = far_peak > config.far_silence;
+    float block_erle = 10.0f * std::log10((d_energy + 1.0f) / (e_energy + 1.0f));
+    bool geigel = near_peak > config.doubletalk * far_peak;
+    bool diverging = erle_db > 2.0f * config.erle_drop_db && block_erle < erle_db - config.erle_drop_db;
+    diverged_blocks = diverging ? diverged_blocks + 1 : 0;
+    if (diverged_blocks > kRelearnBlocks) {
+        // Too long to be someone talking: the echo path changed, learn it again
+        erle_db = 0.0f;
+        diverged_blocks = 0;
+        diverging = false;
+    }
+    if (far_active && (geigel || diverging)) hold = kHoldBlocks;
+    double_talk = hold > 0;
+    if (hold > 0) hold--;
+
+    // Per-bin reference power for the step normalization
+    for (int k = 0; k < K; ++k) power[k] = 0.9f * power[k] + 0.1f * (xr0[k] * xr0[k] + xi0[k] * xi0[k]);
+
+    if (far_active && !double_talk) {
+        // Error spectrum: FFT of [0, e]
+        std::fill(time_buf.begin(), time_buf.begin() + N, 0.0f);
+        std::memcpy(time_buf.data() + N, e, N * sizeof(float));
+        fft.forward(time_buf.data(), Er.data(), Ei.data());
+
+        float floor = 1e-2f * (float)(2 * N) * config.far_silence * config.far_silence;
+        for (int k = 0; k < K; ++k) {
+            float g = config.step / (P * power[k] + floor);
+            Gr[k] = Er[k] * g;
+            Gi[k] = Ei[k] * g;
+        }
+        for (int p = 0; p < P; ++p) {
+            size_t xp = (size_t)((x_head + p) % P) * Kp;
+            size_t wp = (size_t)p * Kp;
+            conjMac(&Xr[xp], &Xi[xp], Gr.data(), Gi.data(), &Wr[wp], &Wi[wp], Kp);
+        }
+        // Gradient constraint: keeps each partition a linear (not circular) convolution
+        for (int p = 0; p < P; ++p) constrain(p);
+
+        erle_db = 0.95f * erle_db + 0.05f * block_erle;
+    }
+}
+
+void EchoCanceller::constrain(int p) {
+    // Time-domain filter taps past N would wrap around (circular convolution)
+    size_t wp = (size_t)p * Kp;
+    fft.inverse(&Wr[wp], &Wi[wp], time_buf.data());
+    std::fill(time_buf.begin() + N, time_buf.end(), 0.0f);
+    fft.forward(time_buf.data(), &Wr[wp], &Wi[wp]);
+}
@@ -0,0 +1,79 @@
+#ifndef ECHO_CANCELLER_H
+#define ECHO_CANCELLER_H
+
+#include "fft.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Acoustic echo canceller between the microphone and the VAD.
+//
+// Partitioned-block frequency-domain adaptive filter (overlap-save, NLMS step
+// normalized per bin by the reference power). The reference is the exact audio
+// the duplex stream sent to the speaker; `delay_ms` covers the known
+// output + input latency so the partitions only have to model the room.
+// Adaptation freezes while the near end talks over the echo (Geigel detector),
+// so the user's voice isn't learned away. Everything is allocated up front.
+class EchoCanceller {
+public:
+    struct Config {
+        int sample_rate = 16000;
+        int block = 256;            // Samples per filter block (FFT is 2x)
+        int partitions = 16;        // Echo tail = block * partitions (256 ms)
+        double delay_ms = 0.0;      // Bulk delay of the reference (stream latency)
+        float step = 1.0f;          // NLMS step size
+        float doubletalk = 0.5f;    // Near end above this fraction of the far-end peak freezes adaptation
+        float erle_drop_db = 6.0f;  // ...as does a block cancelling this much less than the running ERLE
+        float far_silence = 100.0f; // Reference peak (int16) below which there's nothing to cancel
+    };
+
+    EchoCanceller();
+    explicit EchoCanceller(const Config& cfg);
+
+    // mic and ref are aligned frames of n samples. Writes the echo-free microphone
+    // signal to out (may alias mic). A partial block waits for the next call rather
+    // than skipping the canceller, so when n isn't a multiple of block, out runs that
+    // many samples behind mic (padded once with silence).
+    void process(const int16_t* mic, const int16_t* ref, int16_t* out, size_t n);
+    void reset();
+
+    // Echo return loss enhancement over recent adapting blocks, in dB
+    float erleDb() const { return erle_db; }
+    bool farEndActive() const { return far_active; }
+    bool doubleTalk() const { return double_talk; }
+
+    const Config& settings() const { return config; }
+
+private:
+    Config config;
+    int N, K, Kp;        // Block, bins (N + 1), bins padded to the SIMD width
+    RealFFT fft;
+
+    // Reference delay line (bulk latency)
+    std::vector<float> delay_line;
+    size_t delay_pos = 0;
+
+    std::vector<float> x_old;          // Previous reference block
+    std::vector<float> Xr, Xi;         // Reference spectra, partitions x Kp, newest at x_head
+    std::vector<float> Wr, Wi;         // Filter, partitions x Kp
+    std::vector<float> peak;           // Reference block peaks, one per partition
+    int x_head = 0;
+
+    std::vector<float> power;          // Smoothed reference power per bin
+    std::vector<float> Yr, Yi, Er, Ei, Gr, Gi; // Scratch spectra
+    std::vector<float> time_buf, y_buf;
+    std::vector<float> d_blk, x_blk, e_blk;
+    int fill = 0;                      // Samples of the next block already in d_blk / x_blk
+    std::vector<int16_t> ready;        // Cancelled samples not yet returned
+
+    float erle_db = 0.0f;
+    int hold = 0;
+    int diverged_blocks = 0;
+    bool far_active = false;
+    bool double_talk = false;
+
+    void processBlock(const float* d, const float* x, float* e);
+    void constrain(int p);
+};
+
+#endif // ECHO_CANCELLER_H
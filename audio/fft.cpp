@@ -0,0 +1,71 @@
+#include "fft.h"
+#include <cmath>
+
+RealFFT::RealFFT(int size) : n(size), rev(size), cos_t(size / 2), sin_t(size / 2), wr(size), wi(size) {
+    int bits = 0;
+    while ((1 << bits) < n) bits++;
+    for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        rev[i] = r;
+    }
+    for (int i = 0; i < n / 2; ++i) {
+        double a = -2.0 * 3.14159265358979323846 * i / n;
+        cos_t[i] = (float)std::cos(a);
+        sin_t[i] = (float)std::sin(a);
+    }
+}
+
+void RealFFT::transform(bool inverse) {
+    for (int i = 0; i < n; ++i) {
+        int j = rev[i];
+        if (i < j) {
+            std::swap(wr[i], wr[j]);
+            std::swap(wi[i], wi[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2;
+        int step = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; ++k) {
+                float c = cos_t[k * step];
+                float s = inverse ? -sin_t[k * step] : sin_t[k * step];
+                int a = start + k, b = a + half;
+                float tr = wr[b] * c - wi[b] * s;
+                float ti = wr[b] * s + wi[b] * c;
+                wr[b] = wr[a] - tr;
+                wi[b] = wi[a] - ti;
+                wr[a] += tr;
+                wi[a] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::forward(const float* in, float* re, float* im) {
+    for (int i = 0; i < n; ++i) {
+        wr[i] = in[i];
+        wi[i] = 0.0f;
+    }
+    transform(false);
+    for (int k = 0; k <= n / 2; ++k) {
+        re[k] = wr[k];
+        im[k] = wi[k];
+    }
+}
+
+void RealFFT::inverse(const float* re, const float* im, float* out) {
+    // Rebuild the Hermitian-symmetric full spectrum
+    for (int k = 0; k <= n / 2; ++k) {
+        wr[k] = re[k];
+        wi[k] = im[k];
+    }
+    for (int k = n / 2 + 1; k < n; ++k) {
+        wr[k] = re[n - k];
+        wi[k] = -im[n - k];
+    }
+    transform(true);
+    float scale = 1.0f / n;
+    for (int i = 0; i < n; ++i) out[i] = wr[i] * scale;
+}
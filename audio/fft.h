@@ -0,0 +1,29 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <vector>
+
+// Small radix-2 FFT for real signals (echo canceller blocks). Tables and work
+// buffers are allocated in the constructor; forward/inverse never allocate.
+class RealFFT {
+public:
+    explicit RealFFT(int n); // n: power of two
+
+    int size() const { return n; }
+    int bins() const { return n / 2 + 1; }
+
+    // n real samples -> n/2+1 bins (split real / imaginary)
+    void forward(const float* in, float* re, float* im);
+    // n/2+1 bins -> n real samples, scaled by 1/n
+    void inverse(const float* re, const float* im, float* out);
+
+private:
+    int n;
+    std::vector<int> rev;
+    std::vector<float> cos_t, sin_t;
+    std::vector<float> wr, wi;
+
+    void transform(bool inverse);
+};
+
+#endif // FFT_H
@@ -1,4 +1,6 @@
 #include "mic_stream.h"
+#include "playback_buffer.h"
+#include "../utils/perf_monitor.h"
 #include <iostream>
 
 MicrophoneStream::MicrophoneStream(int rate, int block) 
@@ -17,20 +19,41 @@ int MicrophoneStream::paCallback(const void *inputBuffer, void *outputBuffer,
                                  PaStreamCallbackFlags statusFlags,
                                  void *userData) {
     MicrophoneStream* self = static_cast<MicrophoneStream*>(userData);
+    auto start = std::chrono::steady_clock::now();
+
+    // Speaker first: the samples written here are the echo reference for this block.
+    // Blocks are the size the stream was opened with, so assign() stays within capacity.
+    std::vector<int16_t>& ref = self->ref_block;
+    ref.clear();
+    if (outputBuffer && self->playback) {
+        int16_t* out = static_cast<int16_t*>(outputBuffer);
+        self->playback->read(out, framesPerBuffer);
+        ref.assign(out, out + framesPerBuffer);
+    }
+
     if (inputBuffer && self->audio_callback) {
         const int16_t* in = static_cast<const int16_t*>(inputBuffer);
-        std::vector<int16_t> data(in, in + framesPerBuffer);
-        self->audio_callback(data);
+        self->mic_block.assign(in, in + framesPerBuffer);
+        self->audio_callback(self->mic_block, ref);
+    }
+    // Only a timestamp pair: the span is emitted off this thread by drainTrace()
+    if (self->tracing.load(std::memory_order_relaxed)) {
+        self->timings.push({start, std::chrono::steady_clock::now()});
     }
     return paContinue;
 }
 
-void MicrophoneStream::start_stream(std::function<void(const std::vector<int16_t>&)> callback) {
+void MicrophoneStream::start_stream(Callback callback) {
     audio_callback = callback;
+    mic_block.reserve(frames_per_buffer);
+    ref_block.reserve(frames_per_buffer);
+    tracing = PerfMonitor::getInstance().traceExportActive();
     
+    // One duplex stream (not separate in/out streams) so every callback pairs
+    // a captured block with the block played at the same time
     Pa_OpenDefaultStream(&stream,
                          1,             // 1 Input Channel
-                         0,             // 0 Output Channels
+                         playback ? 1 : 0, // Speaker only when we own playback
                          paInt16,       // Sample format
                          sample_rate,
                          frames_per_buffer,
@@ -44,6 +67,17 @@ void MicrophoneStream::start_stream(std::function<void(const std::vector<int16_t
     // depending on the architecture. For this callback-based approach, it runs in PA thread.
 }
 
+double MicrophoneStream::latencyMs() const {
+    const PaStreamInfo* info = stream ? Pa_GetStreamInfo(stream) : nullptr;
+    if (!info) return 0.0;
+    return (info->inputLatency + info->outputLatency) * 1000.0;
+}
+
+void MicrophoneStream::drainTrace() {
+    CallbackTiming t;
+    while (timings.pop(t)) PerfMonitor::getInstance().recordSpan(0, "pa_callback", t.start, t.end);
+}
+
 void MicrophoneStream::stop_stream() {
     if (is_running) {
         Pa_StopStream(stream);
@@ -2,25 +2,58 @@
 #define MIC_STREAM_H
 
 #include <portaudio.h>
+#include "../utils/spsc_ring.h"
 #include <vector>
 #include <functional>
 #include <atomic>
+#include <chrono>
+
+class PlaybackBuffer;
 
 class MicrophoneStream {
 public:
+    // mic: captured block; ref: what the speaker played in the same callback
+    // (empty unless a playback buffer is attached)
+    using Callback = std::function<void(const std::vector<int16_t>& mic, const std::vector<int16_t>& ref)>;
+
     int sample_rate;
     int frames_per_buffer;
     PaStream *stream;
     std::atomic<bool> is_running;
-    std::function<void(const std::vector<int16_t>&)> audio_callback;
+    Callback audio_callback;
 
     MicrophoneStream(int rate=16000, int block=480); // 30ms block at 16k
     ~MicrophoneStream();
 
-    void start_stream(std::function<void(const std::vector<int16_t>&)> callback);
+    // Full duplex: also open a mono output at the same rate, fed from playback.
+    // Call before start_stream().
+    void setPlayback(PlaybackBuffer* playback) { this->playback = playback; }
+
+    void start_stream(Callback callback);
     void stop_stream();
+
+    // Input + output latency reported by PortAudio: how far the echo of a
+    // reference block lags behind it in the captured signal
+    double latencyMs() const;
+
+    // Emits the "pa_callback" spans the audio callback timed, from the calling
+    // thread (the callback itself never touches PerfMonitor). Call regularly
+    // while tracing; timings beyond the ring's capacity are dropped.
+    void drainTrace();
     
 private:
+    PlaybackBuffer* playback = nullptr;
+
+    // Preallocated in start_stream(): the callback doesn't allocate
+    std::vector<int16_t> mic_block;
+    std::vector<int16_t> ref_block;
+
+    struct CallbackTiming {
+        std::chrono::steady_clock::time_point start, end;
+    };
+    SpscRing<CallbackTiming> timings{256}; // Callback -> drainTrace()
+    std::atomic<bool> tracing{false};
+
     static int paCallback(const void *inputBuffer, void *outputBuffer,
                           unsigned long framesPerBuffer,
                           const PaStreamCallbackTimeInfo* timeInfo,
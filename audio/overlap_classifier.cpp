@@ -0,0 +1,78 @@
+#include "overlap_classifier.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+OverlapClassifier::OverlapClassifier(const std::wstring& model_path, int window_samples)
+    : env(std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "OverlapClassifier")),
+      memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU)),
+      window(window_samples) {
+
+    Ort::SessionOptions session_options;
+    session_options.SetIntraOpNumThreads(1);
+    session_options.SetInterOpNumThreads(1);
+    session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+    try {
+        session = std::make_shared<Ort::Session>(*env, model_path.c_str(), session_options);
+    } catch (const std::exception& e) {
+        std::cerr << "[Overlap] Failed to load model: " << e.what() << std::endl;
+    }
+}
+
+OverlapClassifier::Result OverlapClassifier::classify(const int16_t* pcm, size_t samples) const {
+    Result r;
+    if (!session) return r;
+
+    // Most recent audio, right-aligned: the window ends where the speech is now
+    std::vector<float> input((size_t)window, 0.0f);
+    size_t n = std::min(samples, (size_t)window);
+    const int16_t* src = pcm + samples - n;
+    float* dst = input.data() + (window - n);
+    for (size_t i = 0; i < n; ++i) dst[i] = src[i] / 32768.0f;
+
+    int64_t input_dims[2] = {1, (int64_t)window};
+    Ort::Value tensor = Ort::Value::CreateTensor<float>(memory_info, input.data(), input.size(), input_dims, 2);
+    float p[3];
+    try {
+        auto outputs = session->Run(Ort::RunOptions{nullptr}, input_node_names.data(), &tensor, 1,
+                                    output_node_names.data(), output_node_names.size());
+        const float* out = outputs[0].GetTensorMutableData<float>();
+        std::copy(out, out + 3, p);
+    } catch (const std::exception& e) {
+        std::cerr << "[Overlap] Inference failed: " << e.what() << std::endl;
+        return r;
+    }
+
+    // Logits unless it already looks like a distribution
+    float sum = p[0] + p[1] + p[2];
+    bool probs = std::fabs(sum - 1.0f) < 1e-3f && std::min({p[0], p[1], p[2]}) >= 0.0f;
+    if (!probs) {
+        float m = std::max({p[0], p[1], p[2]});
+        for (float& v : p) v = std::exp(v - m);
+        sum = p[0] + p[1] + p[2];
+        for (float& v : p) v /= sum;
+    }
+    r.interrupt = p[0];
+    r.backchannel = p[1];
+    r.noise = p[2];
+    return r;
+}
+
+OverlapClassifier::Label OverlapClassifier::Result::label() const {
+    if (interrupt >= backchannel && interrupt >= noise) return Label::Interrupt;
+    return backchannel >= noise ? Label::Backchannel : Label::Noise;
+}
+
+float OverlapClassifier::Result::confidence() const {
+    return std::max({interrupt, backchannel, noise});
+}
+
+const char* OverlapClassifier::labelName(Label label) {
+    switch (label) {
+        case Label::Interrupt: return "interrupt";
+        case Label::Backchannel: return "backchannel";
+        case Label::Noise: return "noise";
+    }
+    return "?";
+}
@@ -0,0 +1,57 @@
+#ifndef OVERLAP_CLASSIFIER_H
+#define OVERLAP_CLASSIFIER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "onnxruntime_cxx_api.h"
+
+// Small acoustic classifier for speech that overlaps the agent: is it a real
+// interruption ("stop", "wait, no"), a backchannel ("uh-huh", "yeah") or
+// noise? Answers from a few hundred ms of audio in about a millisecond, where
+// Whisper + the monitor LLM take seconds.
+//
+// Model contract (ONNX, same runtime as SileroVAD):
+//   input  "input":  float [1, window_samples], 16 kHz mono in [-1, 1]
+//   output "output": float [1, 3] = interrupt, backchannel, noise
+//                    (probabilities or logits; logits get a softmax)
+class OverlapClassifier {
+public:
+    enum class Label { Interrupt, Backchannel, Noise };
+
+    struct Result {
+        float interrupt = 0.0f;
+        float backchannel = 0.0f;
+        float noise = 0.0f;
+
+        Label label() const;
+        float confidence() const; // Probability of label()
+    };
+
+    // window_samples must match what the model was exported with (400 ms by default)
+    OverlapClassifier(const std::wstring& model_path, int window_samples = 6400);
+
+    OverlapClassifier(const OverlapClassifier&) = delete;
+    OverlapClassifier& operator=(const OverlapClassifier&) = delete;
+
+    bool loaded() const { return (bool)session; }
+    int windowSamples() const { return window; }
+
+    // Classifies the last window of pcm, zero-padded in front when shorter.
+    // Stateless, so one instance serves every stream (Run() is thread-safe).
+    Result classify(const int16_t* pcm, size_t samples) const;
+
+    static const char* labelName(Label label);
+
+private:
+    std::shared_ptr<Ort::Env> env;
+    std::shared_ptr<Ort::Session> session;
+    Ort::MemoryInfo memory_info;
+    int window;
+
+    std::vector<const char*> input_node_names = {"input"};
+    std::vector<const char*> output_node_names = {"output"};
+};
+
+#endif // OVERLAP_CLASSIFIER_H
@@ -0,0 +1,97 @@
+#include "playback_buffer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+PlaybackBuffer::PlaybackBuffer(size_t capacity_samples, int rate)
+    : ring(capacity_samples), sample_rate(rate), fade_len((size_t)rate * 60 / 1000) {}
+
+bool PlaybackBuffer::write(const int16_t* pcm, size_t n, const std::atomic<bool>& cancel) {
+    // A flush the callback hasn't applied yet would drop this audio too
+    for (int i = 0; i < 50 && flushed_seq.load() != flush_seq.load(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    uint64_t seq = flush_seq.load();
+    while (n > 0) {
+        if (cancel || flush_seq.load() != seq) return false;
+        size_t written = ring.push(pcm, n);
+        pcm += written;
+        n -= written;
+        if (n > 0) std::this_thread::sleep_for(std::chrono::milliseconds(5)); // Speaker catches up
+    }
+    return true;
+}
+
+size_t PlaybackBuffer::read(int16_t* out, size_t n) {
+    uint64_t seq = flush_seq.load();
+    if (seq != flushed_seq.load(std::memory_order_relaxed)) {
+        ring.clear();
+        overlays.clear();
+        overlay = Overlay();
+        handing_over = false;
+        fade_pos = 0;
+        flushed_seq.store(seq);
+    }
+    size_t got = ring.pop(out, n);
+    if (got < n) {
+        if (got > 0) underrun_count++;
+        std::fill(out + got, out + n, (int16_t)0);
+    }
+
+    // Newest clip wins
+    Overlay next;
+    while (overlays.pop(next)) {
+        overlay = next;
+        overlay_pos = 0;
+    }
+    const int16_t* src = nullptr;
+    size_t m = 0;
+    if (overlay.pcm && overlay_pos < overlay.n) {
+        src = overlay.pcm + overlay_pos;
+        m = std::min(n, overlay.n - overlay_pos);
+    }
+    // A filler hands over to the response as soon as it starts: 60 ms crossfade
+    if (overlay.crossfade && m > 0 && got > 0) handing_over = true;
+    if (m > 0 || handing_over) {
+        bool fade_clip = handing_over && overlay.crossfade;
+        for (size_t i = 0; i < n; ++i) {
+            float g = 1.0f; // Stream gain; a fading clip gets the rest
+            if (handing_over && fade_pos < fade_len) g = (float)fade_pos++ / fade_len;
+            int v = (int)(out[i] * g);
+            if (i < m) v += fade_clip ? (int)(src[i] * (1.0f - g)) : src[i];
+            out[i] = (int16_t)std::max(-32768, std::min(32767, v));
+        }
+        overlay_pos += m;
+        got = std::max(got, m);
+        if (handing_over && fade_pos >= fade_len) {
+            if (overlay.crossfade) overlay = Overlay(); // Rest of the filler stays unsaid
+            handing_over = false;
+            fade_pos = 0;
+        }
+    }
+    overlay_left = overlay.pcm ? overlay.n - overlay_pos : 0;
+    return got;
+}
+
+bool PlaybackBuffer::mix(const int16_t* pcm, size_t n, bool crossfade) {
+    if (!pcm || n == 0) return false;
+    Overlay clip;
+    clip.pcm = pcm;
+    clip.n = n;
+    clip.crossfade = crossfade;
+    std::lock_guard<std::mutex> lock(mix_mtx);
+    if (!overlays.push(clip)) return false;
+    overlay_left = n; // Until the callback picks it up
+    return true;
+}
+
+void PlaybackBuffer::flush() {
+    flush_seq++;
+}
+
+void PlaybackBuffer::drain(const std::atomic<bool>& cancel) {
+    uint64_t seq = flush_seq.load();
+    while (ring.size() > 0 && !cancel && flush_seq.load() == seq) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
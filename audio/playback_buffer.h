@@ -0,0 +1,71 @@
+#ifndef PLAYBACK_BUFFER_H
+#define PLAYBACK_BUFFER_H
+
+#include "../utils/spsc_ring.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Speaker side of the duplex audio stream. The TTS thread writes 16 kHz PCM,
+// the PortAudio callback reads exactly one block per callback (zero-padded on
+// underrun). Whatever read() hands out is what went to the speaker, so the
+// callback can pass the same samples to the echo canceller as its reference.
+//
+// Short clips (backchannels, fillers) can also be mixed on top of the stream:
+// they start on the very next callback, whatever the TTS thread is doing.
+class PlaybackBuffer {
+public:
+    PlaybackBuffer(size_t capacity_samples, int sample_rate = 16000);
+
+    int sampleRate() const { return sample_rate; }
+
+    // Producer. Blocks while the ring is full; returns false if cancel was set
+    // or a flush() came in before everything was queued.
+    bool write(const int16_t* pcm, size_t n, const std::atomic<bool>& cancel);
+
+    // Consumer (audio callback). Always fills n samples; returns how many were real audio.
+    size_t read(int16_t* out, size_t n);
+
+    // Any thread: drop whatever is queued (barge-in). Takes effect on the next read().
+    // Also cuts a mixed clip.
+    void flush();
+
+    // Any thread (backchannels come from the audio pipeline, fillers from the
+    // turn): plays pcm on top of the stream from the next read(), replacing a
+    // clip that is still playing. Callers are serialized; read() never locks.
+    // pcm isn't copied and must outlive playback (ClipCache clips do).
+    // With crossfade the clip is a stand-in for the stream (a thinking filler):
+    // once stream audio arrives, the clip fades out as the stream fades in.
+    bool mix(const int16_t* pcm, size_t n, bool crossfade = false);
+
+    // Producer: blocks until the queue has been played out, cancelled or flushed
+    void drain(const std::atomic<bool>& cancel);
+
+    size_t queued() const { return ring.size(); }
+    bool active() const { return queued() > 0 || overlay_left.load() > 0; }
+    uint64_t underruns() const { return underrun_count.load(); }
+
+private:
+    SpscRing<int16_t> ring;
+    int sample_rate;
+    std::atomic<uint64_t> flush_seq{0};   // Bumped by flush()
+    std::atomic<uint64_t> flushed_seq{0}; // Last flush the consumer has applied
+    std::atomic<uint64_t> underrun_count{0};
+
+    struct Overlay {
+        const int16_t* pcm = nullptr;
+        size_t n = 0;
+        bool crossfade = false;
+    };
+    SpscRing<Overlay> overlays{4}; // mix() -> read()
+    std::mutex mix_mtx;            // Keeps overlays single-producer
+    Overlay overlay;               // Consumer only: clip being played
+    size_t overlay_pos = 0;
+    size_t fade_len;               // Crossfade length in samples
+    size_t fade_pos = 0;           // Consumer only: progress of a crossfade
+    bool handing_over = false;
+    std::atomic<size_t> overlay_left{0};
+};
+
+#endif // PLAYBACK_BUFFER_H
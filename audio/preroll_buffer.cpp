@@ -0,0 +1,33 @@
+#include "preroll_buffer.h"
+#include <algorithm>
+
+PrerollBuffer::PrerollBuffer(size_t capacity_samples) : ring(std::max<size_t>(capacity_samples, 1)) {}
+
+void PrerollBuffer::clear() {
+    head = 0;
+    count = 0;
+}
+
+void PrerollBuffer::push(const int16_t* pcm, size_t n) {
+    size_t cap = ring.size();
+    if (n >= cap) { // Only the tail fits
+        std::copy(pcm + (n - cap), pcm + n, ring.begin());
+        head = 0;
+        count = cap;
+        return;
+    }
+    size_t first = std::min(n, cap - head);
+    std::copy(pcm, pcm + first, ring.begin() + head);
+    std::copy(pcm + first, pcm + n, ring.begin());
+    head = (head + n) % cap;
+    count = std::min(cap, count + n);
+}
+
+void PrerollBuffer::appendLast(size_t n, std::vector<int16_t>& out) const {
+    n = std::min(n, count);
+    size_t cap = ring.size();
+    size_t start = (head + cap - n) % cap;
+    size_t first = std::min(n, cap - start);
+    out.insert(out.end(), ring.begin() + start, ring.begin() + start + first);
+    out.insert(out.end(), ring.begin(), ring.begin() + (n - first));
+}
@@ -0,0 +1,31 @@
+#ifndef PREROLL_BUFFER_H
+#define PREROLL_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size circular buffer of the most recent microphone samples.
+// Everything is allocated up front; push() overwrites the oldest audio, so the
+// per-frame path never allocates. Used to put the audio from before a VAD onset
+// (or before a barge-in is confirmed) back in front of the utterance.
+class PrerollBuffer {
+public:
+    explicit PrerollBuffer(size_t capacity_samples);
+
+    void push(const int16_t* pcm, size_t n);
+    void clear();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return ring.size(); }
+
+    // Appends the newest n samples (oldest first) to out; n is clamped to size()
+    void appendLast(size_t n, std::vector<int16_t>& out) const;
+
+private:
+    std::vector<int16_t> ring;
+    size_t head = 0;  // Next write position
+    size_t count = 0;
+};
+
+#endif // PREROLL_BUFFER_H
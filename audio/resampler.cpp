@@ -0,0 +1,65 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+Resampler::Resampler(int in, int out, int half_taps) : in_rate(in), out_rate(out), taps(2 * half_taps) {
+    int g = std::gcd(in_rate, out_rate);
+    L = out_rate / g;
+    M = in_rate / g;
+    if (L == M) return; // Pass-through
+
+    // Prototype low-pass at the upsampled rate, cut a little below the lower Nyquist
+    const double pi = 3.14159265358979323846;
+    int len = L * taps;
+    double fc = 0.45 * std::min(in_rate, out_rate) / ((double)in_rate * L); // cycles / upsampled sample
+    double center = (len - 1) / 2.0;
+    std::vector<double> h(len);
+    for (int m = 0; m < len; ++m) {
+        double x = m - center;
+        double sinc = x == 0.0 ? 1.0 : std::sin(2.0 * pi * fc * x) / (2.0 * pi * fc * x);
+        double w = 0.42 - 0.5 * std::cos(2.0 * pi * m / (len - 1)) + 0.08 * std::cos(4.0 * pi * m / (len - 1)); // Blackman
+        h[m] = 2.0 * fc * sinc * w * L;
+    }
+
+    // y[j] = sum_k h[phase + k L] x[i0 - k]; stored reversed so the inner loop walks forward
+    coeffs.resize(len);
+    for (int phase = 0; phase < L; ++phase) {
+        for (int k = 0; k < taps; ++k) coeffs[phase * taps + (taps - 1 - k)] = (float)h[phase + k * L];
+    }
+    reset();
+}
+
+void Resampler::reset() {
+    hist.assign(taps > 0 ? taps - 1 : 0, 0.0f);
+    t = (int64_t)(taps - 1) * L;
+}
+
+void Resampler::process(const int16_t* in, size_t n, std::vector<int16_t>& out) {
+    if (L == M) {
+        out.insert(out.end(), in, in + n);
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) hist.push_back((float)in[i]);
+
+    while (true) {
+        int64_t i0 = t / L;
+        int phase = (int)(t % L);
+        int64_t base = i0 - (taps - 1);
+        if (i0 >= (int64_t)hist.size()) break;
+        const float* c = &coeffs[(size_t)phase * taps];
+        const float* x = &hist[(size_t)base];
+        float acc = 0.0f;
+        for (int k = 0; k < taps; ++k) acc += c[k] * x[k];
+        out.push_back((int16_t)std::max(-32768.0f, std::min(32767.0f, std::round(acc))));
+        t += M;
+    }
+
+    // Drop input no future output needs
+    int64_t keep_from = t / L - (taps - 1);
+    if (keep_from > 0) {
+        keep_from = std::min<int64_t>(keep_from, (int64_t)hist.size());
+        hist.erase(hist.begin(), hist.begin() + keep_from);
+        t -= keep_from * L;
+    }
+}
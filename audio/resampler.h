@@ -0,0 +1,31 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming polyphase windowed-sinc resampler for 16-bit PCM (e.g. Piper's
+// 22050 Hz -> the 16 kHz duplex stream). Keeps filter history between calls,
+// so audio can be pushed in arbitrary chunks.
+class Resampler {
+public:
+    Resampler(int in_rate, int out_rate, int half_taps = 16);
+
+    // Appends the resampled audio to out
+    void process(const int16_t* in, size_t n, std::vector<int16_t>& out);
+    void reset();
+
+    int inRate() const { return in_rate; }
+    int outRate() const { return out_rate; }
+
+private:
+    int in_rate, out_rate;
+    int L = 1, M = 1;   // Up / down factors (out/in reduced)
+    int taps;           // Per phase
+    std::vector<float> coeffs; // L phases x taps, ordered oldest input first
+    std::vector<float> hist;   // Input not fully consumed yet
+    int64_t t = 0;             // Next output position, in 1/L input samples from hist[0]
+};
+
+#endif // RESAMPLER_H
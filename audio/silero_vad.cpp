@@ -4,17 +4,18 @@
 #include <cstring>
 
 SileroVAD::SileroVAD(const std::wstring& model_path, int sr_val, float thresh)
-    : env(ORT_LOGGING_LEVEL_WARNING, "SileroVAD"),
+    : env(std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "SileroVAD")),
       memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU)),
       threshold(thresh),
       sample_rate(sr_val) {
     
+    Ort::SessionOptions session_options;
     session_options.SetIntraOpNumThreads(1);
     session_options.SetInterOpNumThreads(1);
     session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
 
     try {
-        session = std::make_unique<Ort::Session>(env, model_path.c_str(), session_options);
+        session = std::make_shared<Ort::Session>(*env, model_path.c_str(), session_options);
     } catch (const std::exception& e) {
         std::cerr << "[SileroVAD] Failed to load model: " << e.what() << std::endl;
     }
@@ -24,6 +25,16 @@ SileroVAD::SileroVAD(const std::wstring& model_path, int sr_val, float thresh)
     _sr.assign(1, (int64_t)sample_rate);
 }
 
+SileroVAD::SileroVAD(const SileroVAD* model)
+    : env(model->env),
+      session(model->session),
+      memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeCPU)),
+      threshold(model->threshold),
+      sample_rate(model->sample_rate) {
+    _state.assign(2 * 1 * 128, 0.0f);
+    _sr.assign(1, (int64_t)sample_rate);
+}
+
 SileroVAD::~SileroVAD() {}
 
 float SileroVAD::getSpeechProb(const std::vector<float>& chunk) {
@@ -49,6 +60,10 @@ float SileroVAD::getSpeechProb(const std::vector<float>& chunk) {
     return prob;
 }
 
+void SileroVAD::reset() {
+    std::fill(_state.begin(), _state.end(), 0.0f);
+}
+
 bool SileroVAD::isSpeech(const std::vector<float>& chunk) {
     return getSpeechProb(chunk) >= threshold;
 }
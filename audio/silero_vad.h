@@ -9,18 +9,26 @@
 class SileroVAD {
 public:
     SileroVAD(const std::wstring& model_path, int sample_rate = 16000, float threshold = 0.5f);
+    // New stream on an already loaded network: shares the ONNX session, own recurrent state
+    explicit SileroVAD(const SileroVAD* model);
     ~SileroVAD();
 
+    SileroVAD(const SileroVAD&) = delete;
+    SileroVAD& operator=(const SileroVAD&) = delete;
+
     // Returns probability of speech [0.0 - 1.0] for a 32ms chunk (512 samples @ 16kHz)
     float getSpeechProb(const std::vector<float>& chunk);
 
     // High level: returns true if speech is detected based on threshold
     bool isSpeech(const std::vector<float>& chunk);
 
+    // Clears the recurrent state (start of a new, unrelated stream)
+    void reset();
+
 private:
-    Ort::Env env;
-    Ort::SessionOptions session_options;
-    std::unique_ptr<Ort::Session> session;
+    // Shared between streams forked from the same model (Run() is thread-safe)
+    std::shared_ptr<Ort::Env> env;
+    std::shared_ptr<Ort::Session> session;
     Ort::MemoryInfo memory_info;
 
     // Model state (recurrent tokens)
@@ -2,17 +2,36 @@
 #include "silero_vad.h"
 #include <vector>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
-VAD::VAD(const std::wstring& model_path, int sample_rate, float threshold) {
+VAD::VAD(const std::wstring& model_path, int sample_rate, float threshold) : prob_threshold(threshold) {
     silero = new SileroVAD(model_path, sample_rate, threshold);
 }
 
+VAD::VAD(float threshold) : silero(nullptr), energy_threshold(threshold) {}
+
+VAD::VAD(const VAD* model)
+    : silero(model->silero ? new SileroVAD(model->silero) : nullptr), energy_threshold(model->energy_threshold),
+      prob_threshold(model->prob_threshold) {}
+
 VAD::~VAD() {
     if (silero) delete silero;
 }
 
 bool VAD::isSpeech(const int16_t* pcm, int length, int sample_rate) {
-    if (!silero) return false;
+    (void)sample_rate;
+    return speechProb(pcm, length) >= prob_threshold;
+}
+
+float VAD::speechProb(const int16_t* pcm, int length) {
+    if (!silero) {
+        if (energy_threshold <= 0.0f || length <= 0) return 0.0f;
+        double sum = 0.0;
+        for (int i = 0; i < length; ++i) sum += (double)pcm[i] * pcm[i];
+        double rms = std::sqrt(sum / length) / 32768.0;
+        return (float)std::min(1.0, 0.5 * rms / energy_threshold);
+    }
 
     // Silero VAD expects float audio in [-1, 1] range
     std::vector<float> float_pcm(length);
@@ -22,5 +41,9 @@ bool VAD::isSpeech(const int16_t* pcm, int length, int sample_rate) {
 
     // Silero usually works best with 512 samples for 16kHz
     // If length is different, SileroVAD::getSpeechProb handles resizing/padding
-    return silero->isSpeech(float_pcm);
+    return silero->getSpeechProb(float_pcm);
+}
+
+void VAD::reset() {
+    if (silero) silero->reset();
 }
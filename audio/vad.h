@@ -13,9 +13,25 @@ public:
     SileroVAD* silero;
 
     VAD(const std::wstring& model_path, int sample_rate = 16000, float threshold = 0.5f);
+    // No model: plain RMS energy gate (mock backends, load tests)
+    explicit VAD(float energy_threshold);
+    // Per-session stream sharing model's loaded network (server mode)
+    explicit VAD(const VAD* model);
     ~VAD();
 
+    VAD(const VAD&) = delete;
+    VAD& operator=(const VAD&) = delete;
+
     bool isSpeech(const int16_t* pcm, int length, int sample_rate = 16000);
+    // Raw speech probability [0, 1] for one frame; isSpeech() is this >= threshold().
+    // The energy gate maps RMS so that energy_threshold lands on 0.5.
+    float speechProb(const int16_t* pcm, int length);
+    float threshold() const { return prob_threshold; }
+    void reset();
+
+private:
+    float energy_threshold = 0.0f;
+    float prob_threshold = 0.5f;
 };
 
 #endif // VAD_H
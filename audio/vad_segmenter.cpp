@@ -0,0 +1,71 @@
+#include "vad_segmenter.h"
+#include <algorithm>
+#include <cmath>
+
+VADSegmenter::VADSegmenter() : VADSegmenter(Config()) {}
+
+VADSegmenter::VADSegmenter(Config config) : cfg(config), probs(config.history_frames > 0 ? config.history_frames : 1, 0.0f) {}
+
+void VADSegmenter::reset() {
+    in_speech = false;
+    onset_run = 0;
+    low_run = 0;
+    speech_ms = 0.0;
+    frame_index = 0;
+    std::fill(probs.begin(), probs.end(), 0.0f);
+    probs_next = 0;
+}
+
+int VADSegmenter::prerollFrames() const {
+    return (int)std::ceil(cfg.preroll_ms / frame_ms);
+}
+
+int VADSegmenter::postrollFrames() const {
+    return (int)std::ceil(cfg.postroll_ms / frame_ms);
+}
+
+VADSegmenter::Frame VADSegmenter::push(float prob, double ms) {
+    frame_ms = ms;
+    probs[probs_next] = prob;
+    probs_next = (probs_next + 1) % probs.size();
+
+    Frame f;
+    f.prob = prob;
+
+    if (!in_speech) {
+        onset_run = prob >= cfg.onset_threshold ? onset_run + 1 : 0;
+        if (onset_run > 0 && onset_run * frame_ms >= cfg.min_speech_ms) {
+            in_speech = true;
+            low_run = 0;
+            speech_ms = onset_run * frame_ms;
+            f.speech = true;
+            f.event = Event::SpeechStart;
+            f.onset_frames = onset_run + prerollFrames();
+            onset_run = 0;
+        }
+    } else {
+        speech_ms += frame_ms;
+        if (prob >= cfg.offset_threshold) {
+            low_run = 0;
+            f.speech = true;
+        } else {
+            low_run++;
+            if (low_run * frame_ms >= cfg.min_silence_ms) {
+                in_speech = false;
+                speech_ms = 0.0;
+                f.event = Event::SpeechEnd;
+            }
+        }
+    }
+
+    if (onProb) onProb(frame_index, prob, f.speech);
+    frame_index++;
+    return f;
+}
+
+std::vector<float> VADSegmenter::history() const {
+    std::vector<float> out;
+    out.reserve(probs.size());
+    for (size_t i = 0; i < probs.size(); ++i) out.push_back(probs[(probs_next + i) % probs.size()]);
+    return out;
+}
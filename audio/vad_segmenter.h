@@ -0,0 +1,76 @@
+#ifndef VAD_SEGMENTER_H
+#define VAD_SEGMENTER_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Turns the per-frame speech probability stream into speech segments.
+//
+//   Silence --(prob >= onset for min_speech_ms)--> Speech
+//   Speech  --(prob <  offset for min_silence_ms)--> Silence
+//
+// Separate onset/offset thresholds (hysteresis) keep a word's soft tail from
+// flickering in and out, and min durations keep clicks and short dips from
+// opening or closing a segment. Onset is only confirmed after min_speech_ms, so
+// each start reports how many frames back the speech (plus pre-roll padding)
+// really began.
+class VADSegmenter {
+public:
+    struct Config {
+        float onset_threshold = 0.5f;   // Probability that starts speech
+        float offset_threshold = 0.35f; // Probability that keeps it going
+        double min_speech_ms = 64.0;    // Above onset this long before a start counts
+        double min_silence_ms = 96.0;   // Below offset this long before the segment closes
+        double preroll_ms = 192.0;      // Audio before the first onset frame kept with the segment
+        double postroll_ms = 64.0;      // Audio after the last speech frame kept with the segment
+        size_t history_frames = 64;     // Probability history kept for inspection (~2 s)
+    };
+
+    enum class Event { None, SpeechStart, SpeechEnd };
+
+    struct Frame {
+        float prob = 0.0f;
+        bool speech = false;   // Frame belongs to speech (after hysteresis)
+        Event event = Event::None;
+        int onset_frames = 0;  // SpeechStart: frames back, this one included, where the segment starts
+    };
+
+    // Per-frame probability stream: (frame index, probability, speech)
+    using ProbListener = std::function<void(int64_t frame, float prob, bool speech)>;
+
+    VADSegmenter();
+    explicit VADSegmenter(Config config);
+
+    Frame push(float prob, double frame_ms);
+    void reset();
+
+    bool inSpeech() const { return in_speech; }
+    // Speech so far in the current segment, from its first onset frame
+    double speechMs() const { return in_speech ? speech_ms : 0.0; }
+    double frameMs() const { return frame_ms; }
+    int prerollFrames() const;
+    int postrollFrames() const;
+
+    // Last history_frames probabilities, oldest first
+    std::vector<float> history() const;
+    void setProbListener(ProbListener listener) { onProb = std::move(listener); }
+
+    const Config& config() const { return cfg; }
+
+private:
+    Config cfg;
+    ProbListener onProb;
+
+    bool in_speech = false;
+    int onset_run = 0;      // Consecutive frames >= onset while silent
+    int low_run = 0;        // Consecutive frames < offset while speaking
+    double speech_ms = 0.0;
+    double frame_ms = 32.0;
+    int64_t frame_index = 0;
+
+    std::vector<float> probs; // Ring of the last history_frames probabilities
+    size_t probs_next = 0;
+};
+
+#endif // VAD_SEGMENTER_H
@@ -0,0 +1,180 @@
+#include "wav_file.h"
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+const uint16_t kFormatPcm = 1;
+const uint16_t kFormatFloat = 3;
+const uint16_t kFormatExtensible = 0xFFFE;
+
+// RIFF is little-endian; memcpy keeps unaligned reads legal
+uint16_t le16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+uint32_t le32(const uint8_t* p) { return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)); }
+
+float sampleAt(const uint8_t* p, int bits, bool is_float) {
+    if (is_float) {
+        if (bits == 64) {
+            double d;
+            std::memcpy(&d, p, sizeof(d));
+            return (float)d;
+        }
+        float f;
+        std::memcpy(&f, p, sizeof(f));
+        return f;
+    }
+    switch (bits) {
+        case 8: return ((int)p[0] - 128) / 128.0f; // 8-bit WAV is unsigned
+        case 16: return (int16_t)le16(p) / 32768.0f;
+        case 24: return (int32_t)((uint32_t)(p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) / 2147483648.0f;
+        default: return (int32_t)le32(p) / 2147483648.0f;
+    }
+}
+
+int16_t toInt16(float v) {
+    return (int16_t)std::max(-32768.0f, std::min(32767.0f, std::round(v * 32768.0f)));
+}
+
+} // namespace
+
+bool WavFile::open(const std::string& path) {
+    data = nullptr;
+    data_bytes = num_frames = 0;
+    if (!file.open(path)) {
+        std::cerr << "[Wav] Could not open " << path << std::endl;
+        return false;
+    }
+
+    if (file.size() >= 12 && std::memcmp(file.data(), "RIFF", 4) == 0 && std::memcmp(file.data() + 8, "WAVE", 4) == 0) {
+        return parseRiff(path);
+    }
+
+    std::string ext = std::filesystem::path(path).extension().string();
+    if (ext == ".raw" || ext == ".pcm") {
+        format = Format::Pcm;
+        sample_rate = kTargetRate;
+        num_channels = 1;
+        bits = 16;
+        block_align = 2;
+        data = file.data();
+        data_bytes = file.size() - file.size() % 2;
+        num_frames = data_bytes / 2;
+        return true;
+    }
+    std::cerr << "[Wav] Not a RIFF/WAVE file: " << path << std::endl;
+    return false;
+}
+
+bool WavFile::parseRiff(const std::string& path) {
+    const uint8_t* base = file.data();
+    size_t size = file.size();
+    bool have_fmt = false;
+    uint16_t tag = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= size) {
+        const uint8_t* chunk = base + pos;
+        uint32_t chunk_size = le32(chunk + 4);
+        const uint8_t* body = chunk + 8;
+        size_t available = size - pos - 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && available >= 16) {
+            tag = le16(body);
+            num_channels = le16(body + 2);
+            sample_rate = (int)le32(body + 4);
+            block_align = le16(body + 12);
+            bits = le16(body + 14);
+            if (tag == kFormatExtensible && chunk_size >= 40 && available >= 40) {
+                tag = le16(body + 24); // First two bytes of the sub-format GUID
+            }
+            have_fmt = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = body;
+            // Streamed writers leave 0 or 0xFFFFFFFF here; a truncated file is cut short
+            data_bytes = (chunk_size == 0 || chunk_size > available) ? available : chunk_size;
+            if (have_fmt) break;
+        }
+        if ((uint64_t)chunk_size + 8 > size - pos) break;
+        pos += 8 + chunk_size + (chunk_size & 1); // Chunks are word aligned
+    }
+
+    if (!have_fmt || !data) {
+        std::cerr << "[Wav] Missing fmt or data chunk: " << path << std::endl;
+        return false;
+    }
+    bool pcm_ok = tag == kFormatPcm && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+    bool float_ok = tag == kFormatFloat && (bits == 32 || bits == 64);
+    if ((!pcm_ok && !float_ok) || num_channels < 1 || sample_rate <= 0 || block_align < num_channels * bits / 8) {
+        std::cerr << "[Wav] Unsupported format (tag " << tag << ", " << bits << " bit, " << num_channels
+                  << " ch, " << sample_rate << " Hz): " << path << std::endl;
+        return false;
+    }
+    format = float_ok ? Format::Float : Format::Pcm;
+    num_frames = data_bytes / block_align;
+    return true;
+}
+
+const int16_t* WavFile::pcm16() const {
+    bool native = format == Format::Pcm && bits == 16 && num_channels == 1 && sample_rate == kTargetRate;
+    // Mapping is page aligned and RIFF chunks are word aligned, but a broken file could still be odd
+    if (!native || !data || ((uintptr_t)data % alignof(int16_t)) != 0) return nullptr;
+    return reinterpret_cast<const int16_t*>(data);
+}
+
+void WavFile::downmix(std::vector<float>& out) const {
+    out.resize(num_frames);
+    int bytes = bits / 8;
+    bool is_float = format == Format::Float;
+    float scale = 1.0f / num_channels;
+    for (size_t f = 0; f < num_frames; ++f) {
+        const uint8_t* frame = data + f * block_align;
+        float sum = 0.0f;
+        for (int c = 0; c < num_channels; ++c) sum += sampleAt(frame + c * bytes, bits, is_float);
+        out[f] = sum * scale;
+    }
+}
+
+bool WavFile::read(std::vector<int16_t>& out) const {
+    out.clear();
+    if (!data) return false;
+    if (const int16_t* pcm = pcm16()) {
+        out.assign(pcm, pcm + num_frames);
+        return true;
+    }
+
+    std::vector<float> mono;
+    downmix(mono);
+    std::vector<int16_t> mono16(mono.size());
+    for (size_t i = 0; i < mono.size(); ++i) mono16[i] = toInt16(mono[i]);
+    if (sample_rate == kTargetRate) {
+        out.swap(mono16);
+        return true;
+    }
+    Resampler resampler(sample_rate, kTargetRate);
+    out.reserve((size_t)((double)mono16.size() * kTargetRate / sample_rate) + 1);
+    resampler.process(mono16.data(), mono16.size(), out);
+    return true;
+}
+
+bool WavFile::readFloat(std::vector<float>& out) const {
+    out.clear();
+    if (!data) return false;
+    if (const int16_t* pcm = pcm16()) {
+        out.resize(num_frames);
+        for (size_t i = 0; i < num_frames; ++i) out[i] = pcm[i] / 32768.0f;
+        return true;
+    }
+    if (sample_rate == kTargetRate) {
+        downmix(out);
+        return true;
+    }
+    std::vector<int16_t> pcm;
+    read(pcm);
+    out.resize(pcm.size());
+    for (size_t i = 0; i < pcm.size(); ++i) out[i] = pcm[i] / 32768.0f;
+    return true;
+}
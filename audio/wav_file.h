@@ -0,0 +1,56 @@
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include "../utils/mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// WAV / raw PCM input for ASR and the offline benchmarks.
+//
+// The file is memory-mapped and its RIFF chunks parsed properly (fmt, data,
+// anything else skipped, WAVE_FORMAT_EXTENSIBLE, streamed files with a bogus
+// data size). 16 kHz mono 16-bit files are used in place: pcm16() points
+// straight into the mapping. Anything else (other rates, stereo, 8/24/32-bit,
+// float) is converted to 16 kHz mono on read. Files without a RIFF header
+// (.raw / .pcm) are taken as 16 kHz mono s16le.
+class WavFile {
+public:
+    static const int kTargetRate = 16000;
+
+    // False (with a log line) if the file can't be mapped or isn't a PCM / float WAV
+    bool open(const std::string& path);
+
+    int sampleRate() const { return sample_rate; }
+    int channels() const { return num_channels; }
+    int bitsPerSample() const { return bits; }
+    size_t frames() const { return num_frames; }
+    double seconds() const { return sample_rate > 0 ? (double)num_frames / sample_rate : 0.0; }
+
+    // Already 16 kHz mono 16-bit: zero-copy view into the mapping, else nullptr
+    const int16_t* pcm16() const;
+
+    // 16 kHz mono, converting if needed (one pass from the mapping for native files)
+    bool read(std::vector<int16_t>& out) const;
+    bool readFloat(std::vector<float>& out) const; // -1..1, what Whisper takes
+
+private:
+    enum class Format { Pcm, Float };
+
+    MappedFile file;
+    const uint8_t* data = nullptr;
+    size_t data_bytes = 0;
+    Format format = Format::Pcm;
+    int sample_rate = 0;
+    int num_channels = 0;
+    int bits = 0;
+    int block_align = 0;
+    size_t num_frames = 0;
+
+    bool parseRiff(const std::string& path);
+    // Mono float in file units (-1..1) at the file's own rate
+    void downmix(std::vector<float>& out) const;
+};
+
+#endif // WAV_FILE_H
@@ -11,10 +11,10 @@ import threading
 
 def run_automated_tests():
     # 0. Clear previous results for a clean dashboard run
-    csv_path = "benchmark_results.csv"
-    if os.path.exists(csv_path):
-        with open(csv_path, "w") as f:
-            f.write("TurnID,Timestamp,VAD_Latency,ASR_Latency,LLM_TTFT,TTS_Latency,Total_E2E,Tokens,UserText\n")
+    # (the agent also truncates these on its first turn)
+    for stale in ["benchmark_results.csv", "benchmark_results.jsonl", "latency_summary.json"]:
+        if os.path.exists(stale):
+            os.remove(stale)
 
     # 1. Start Dashboard Server in background
     print("🌐 Launching Live Research Dashboard...")
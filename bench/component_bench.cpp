@@ -0,0 +1,304 @@
+// Per-component micro-benchmarks (see micro_bench.h for the runner).
+//
+//   voice_agent_bench [--filter REGEX] [--repetitions N] [--min-time S] [--out bench.json]
+//                     [--llm P] [--asr P] [--vad P] [--overlap P] [--wav P] [--list]
+//
+// Models are only loaded when a selected case needs them, so e.g.
+// `--filter "sampler|clean_text|normalize|aec"` runs without any model files.
+
+#include "micro_bench.h"
+#include "../audio/vad.h"
+#include "../audio/echo_canceller.h"
+#include "../audio/overlap_classifier.h"
+#include "../asr/whisper_stream.h"
+#include "../llm/llama_stream.h"
+#include "../tts/simple_tts.h"
+#include "../tts/text_normalizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string llmPath = "models/qwen2.5-3b-instruct-q4_k_m.gguf";
+std::string asrPath = "models/ggml-medium.en-q5_0.bin";
+std::string vadPath = "models/silero_vad.onnx";
+std::string overlapPath = "models/overlap_classifier.onnx";
+std::string wavPath; // Defaults to the first recording under test_audio/
+
+const int kSampleRate = 16000;
+const int kQwenVocab = 151936; // Sampler case runs without a model
+
+VAD& vad() {
+    static VAD v(std::wstring(vadPath.begin(), vadPath.end()));
+    return v;
+}
+
+OverlapClassifier& overlap() {
+    static OverlapClassifier c(std::wstring(overlapPath.begin(), overlapPath.end()));
+    return c;
+}
+
+WhisperASR& asr() {
+    static WhisperASR a(asrPath);
+    return a;
+}
+
+LLMStream& llm() {
+    static LLMStream l(llmPath);
+    return l;
+}
+
+SimpleTTS& tts() {
+    static SimpleTTS t;
+    return t;
+}
+
+// Real speech when available (Whisper decode time depends on content),
+// otherwise a voiced-ish synthetic signal
+const std::vector<int16_t>& speechSample() {
+    static std::vector<int16_t> speech = [] {
+        std::vector<int16_t> pcm;
+        std::string path = wavPath;
+        if (path.empty() && fs::exists("test_audio")) {
+            for (const auto& e : fs::recursive_directory_iterator("test_audio")) {
+                if (e.path().extension() == ".wav") { path = e.path().string(); break; }
+            }
+        }
+        if (!path.empty() && WhisperASR::load_wav(path, pcm) && !pcm.empty()) return pcm;
+
+        pcm.resize(kSampleRate * 2);
+        std::mt19937 rng(42);
+        std::normal_distribution<float> noise(0.0f, 300.0f);
+        for (size_t i = 0; i < pcm.size(); ++i) {
+            float t = (float)i / kSampleRate;
+            float env = 0.5f + 0.5f * std::sin(2.0f * 3.14159f * 4.0f * t); // Syllable-rate envelope
+            float v = env * (3000.0f * std::sin(2.0f * 3.14159f * 140.0f * t) +
+                             1500.0f * std::sin(2.0f * 3.14159f * 700.0f * t)) + noise(rng);
+            pcm[i] = (int16_t)std::max(-32768.0f, std::min(32767.0f, v));
+        }
+        return pcm;
+    }();
+    return speech;
+}
+
+// Speech tiled / trimmed to an exact duration
+std::vector<int16_t> speechOfLength(double seconds) {
+    const std::vector<int16_t>& src = speechSample();
+    std::vector<int16_t> out((size_t)(seconds * kSampleRate));
+    for (size_t i = 0; i < out.size(); ++i) out[i] = src[i % src.size()];
+    return out;
+}
+
+// Exactly n prompt tokens from repeated chat text
+std::vector<llama_token> promptTokens(int n) {
+    std::string text = "<|im_start|>user\nTell me something interesting about real time speech systems and why latency matters.<|im_end|>\n";
+    std::string prompt;
+    std::vector<llama_token> tokens;
+    while ((int)tokens.size() < n) {
+        prompt += text;
+        tokens = llm().tokenize(prompt);
+        if (tokens.empty()) break;
+    }
+    tokens.resize(std::min((int)tokens.size(), n));
+    return tokens;
+}
+
+// Clears the KV cache and decodes tokens as one prompt batch
+bool prefill(llama_batch& batch, const std::vector<llama_token>& tokens) {
+    llama_memory_clear(llama_get_memory(llm().ctx), true);
+    batch.n_tokens = (int)tokens.size();
+    for (int i = 0; i < (int)tokens.size(); ++i) {
+        batch.token[i] = tokens[i];
+        batch.pos[i] = i;
+        batch.n_seq_id[i] = 1;
+        batch.seq_id[i][0] = 0;
+        batch.logits[i] = false;
+    }
+    batch.logits[tokens.size() - 1] = true;
+    return llama_decode(llm().ctx, batch) == 0;
+}
+
+const std::string kResponse =
+    "Sure! \xF0\x9F\x98\x8A Real-time speech systems have to *listen* while they talk [laughter]. "
+    "That's why latency matters so much: people notice gaps over 500 ms. #voice #latency "
+    "Let me know if you want \"more\" detail.<|im_end|>\nuser";
+
+void registerCases() {
+    // --- VAD: one 32 ms frame through Silero -------------------------------
+    bench::add("vad/is_speech/512", [](bench::State& s) {
+        s.pauseTiming();
+        std::vector<int16_t> audio = speechOfLength(1.0);
+        vad(); // Model load isn't part of the measurement
+        s.resumeTiming();
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            size_t off = (size_t)(i % 31) * 512;
+            vad().isSpeech(audio.data() + off, 512);
+        }
+        s.setItemsProcessed((double)s.iterations); // frames/s; real time needs 31.25
+    });
+
+    // --- Overlap classifier: one barge-in decision (400 ms window) ----------
+    bench::add("overlap/classify", [](bench::State& s) {
+        s.pauseTiming();
+        std::vector<int16_t> audio = speechOfLength(1.0);
+        overlap();
+        s.resumeTiming();
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            size_t end = 6400 + (size_t)(i % 16) * 512;
+            bench::doNotOptimize((int64_t)(overlap().classify(audio.data(), end).confidence() * 1000));
+        }
+        s.setItemsProcessed((double)s.iterations); // Decisions/s
+    });
+
+    // --- AEC: one 32 ms frame through the adaptive filter -------------------
+    bench::add("aec/process/512", [](bench::State& s) {
+        s.pauseTiming();
+        std::vector<int16_t> far = speechOfLength(1.0);
+        std::vector<int16_t> mic(far.size()), out(512);
+        for (size_t i = 0; i < far.size(); ++i) mic[i] = (int16_t)(i >= 160 ? far[i - 160] / 3 : 0); // 10 ms, -10 dB echo
+        EchoCanceller aec;
+        s.resumeTiming();
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            size_t off = (size_t)(i % 31) * 512;
+            aec.process(mic.data() + off, far.data() + off, out.data(), 512);
+        }
+        s.setItemsProcessed((double)s.iterations); // frames/s; real time needs 31.25
+    });
+
+    // --- ASR: whole-utterance transcription --------------------------------
+    // "full" forces the padded 30 s encoder window, for comparison with the
+    // trimmed audio_ctx the agent uses on short utterances
+    for (bool trim : {true, false}) {
+        for (double seconds : {1.0, 3.0, 10.0}) {
+            std::string name = std::string(trim ? "asr/transcribe/" : "asr/transcribe_full/") +
+                               std::to_string((int)seconds) + "s";
+            bench::add(name, [seconds, trim](bench::State& s) {
+                s.pauseTiming();
+                std::vector<int16_t> audio = speechOfLength(seconds);
+                asr().config.trim_audio_ctx = trim;
+                s.resumeTiming();
+                for (int64_t i = 0; i < s.iterations; ++i) {
+                    asr().transcribe(audio, [](const std::string&) {});
+                }
+                asr().config.trim_audio_ctx = true;
+                s.counter("realtime_x", seconds * s.iterations, true); // Audio seconds per second
+            }, 1);
+        }
+    }
+
+    // --- LLM: prompt prefill and single-token decode -----------------------
+    for (int n_ctx : {128, 512, 1024}) {
+        bench::add("llm/prefill/" + std::to_string(n_ctx), [n_ctx](bench::State& s) {
+            s.pauseTiming();
+            std::vector<llama_token> tokens = promptTokens(n_ctx);
+            llama_batch batch = llama_batch_init(2048, 0, 1);
+            s.resumeTiming();
+            for (int64_t i = 0; i < s.iterations; ++i) {
+                prefill(batch, tokens);
+            }
+            llama_batch_free(batch);
+            s.counter("tokens_per_second", (double)tokens.size() * s.iterations, true);
+        });
+
+        bench::add("llm/decode/ctx" + std::to_string(n_ctx), [n_ctx](bench::State& s) {
+            const int kSteps = 32;
+            s.pauseTiming();
+            std::vector<llama_token> tokens = promptTokens(n_ctx);
+            llama_batch batch = llama_batch_init(2048, 0, 1);
+            s.resumeTiming();
+            for (int64_t i = 0; i < s.iterations; ++i) {
+                s.pauseTiming();
+                prefill(batch, tokens);
+                s.resumeTiming();
+                // Fixed token each step: measures the decode itself, not sampling
+                for (int step = 0; step < kSteps; ++step) {
+                    batch.n_tokens = 1;
+                    batch.token[0] = tokens.back();
+                    batch.pos[0] = (int)tokens.size() + step;
+                    batch.n_seq_id[0] = 1;
+                    batch.seq_id[0][0] = 0;
+                    batch.logits[0] = true;
+                    llama_decode(llm().ctx, batch);
+                }
+            }
+            llama_batch_free(batch);
+            s.counter("tokens_per_second", (double)kSteps * s.iterations, true);
+        });
+    }
+
+    // --- Sampler: greedy + repetition penalty over the full vocab ----------
+    bench::add("llm/sampler/vocab151936", [](bench::State& s) {
+        std::vector<float> logits(kQwenVocab);
+        std::mt19937 rng(7);
+        std::normal_distribution<float> dist(0.0f, 3.0f);
+        for (float& l : logits) l = dist(rng);
+        std::vector<llama_token> history;
+        for (int i = 0; i < 64; ++i) history.push_back((llama_token)(rng() % kQwenVocab));
+
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            bench::doNotOptimize(LLMStream::samplePenalized(logits.data(), kQwenVocab, history));
+        }
+        s.setItemsProcessed((double)s.iterations); // Sampled tokens/s
+    });
+
+    // --- TTS: text cleaning and Piper synthesis ----------------------------
+    bench::add("tts/clean_text", [](bench::State& s) {
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            bench::doNotOptimize((int64_t)tts().cleanText(kResponse).size());
+        }
+        s.setItemsProcessed((double)s.iterations);
+        s.counter("bytes_per_second", (double)kResponse.size() * s.iterations, true);
+    });
+
+    // Token by token into a reused buffer, the way a streaming TTS feed would
+    bench::add("tts/normalize_stream", [](bench::State& s) {
+        std::string out;
+        out.reserve(kResponse.size() * 2);
+        TextNormalizer normalizer;
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            out.clear();
+            normalizer.reset();
+            for (size_t pos = 0; pos < kResponse.size(); pos += 4) {
+                normalizer.push(kResponse.data() + pos, std::min<size_t>(4, kResponse.size() - pos), out);
+            }
+            normalizer.finish(out);
+            bench::doNotOptimize((int64_t)out.size());
+        }
+        s.setItemsProcessed((double)s.iterations);
+        s.counter("bytes_per_second", (double)kResponse.size() * s.iterations, true);
+    });
+
+    bench::add("tts/synthesize", [](bench::State& s) {
+        double audio_s = 0.0;
+        for (int64_t i = 0; i < s.iterations; ++i) {
+            tts().synthesize("Real time speech systems have to listen while they talk.");
+            audio_s += tts().lastAudioSeconds();
+        }
+        s.counter("realtime_x", audio_s, true); // 1 / RTF
+    }, 1);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench::Runner runner;
+    std::vector<std::string> rest;
+    runner.parseArgs(argc, argv, rest);
+    for (size_t i = 0; i + 1 < rest.size(); i += 2) {
+        if (rest[i] == "--llm") llmPath = rest[i + 1];
+        else if (rest[i] == "--asr") asrPath = rest[i + 1];
+        else if (rest[i] == "--vad") vadPath = rest[i + 1];
+        else if (rest[i] == "--overlap") overlapPath = rest[i + 1];
+        else if (rest[i] == "--wav") wavPath = rest[i + 1];
+    }
+
+    registerCases();
+    return runner.run();
+}
@@ -0,0 +1,268 @@
+// Orchestration load test with mock backends (no model files needed).
+//
+// Runs N simulated sessions, each with the same wiring as main.cpp: its own
+// AudioPipeline (energy VAD), EventBus, DialogueController, ASR worker threads and
+// TTSEngine, fed 32 ms frames on a real-time schedule. ASR, LLM and TTS are mocks
+// with fixed synthetic latency, so anything E2E shows above the synthetic floor is
+// orchestration overhead (threads, bus, locks, logging), and late frames show the
+// feeders falling behind.
+//
+//   voice_agent_loadtest --sessions 200 --duration 60 --llm-tps 30
+
+#include "../audio/vad.h"
+#include "../asr/mock_asr.h"
+#include "../llm/mock_llm.h"
+#include "../tts/mock_tts.h"
+#include "../tts/tts_stream.h"
+#include "../persona/persona_state.h"
+#include "../controller/dialogue_controller.h"
+#include "../controller/audio_pipeline.h"
+#include "../utils/event_bus.h"
+#include "../utils/perf_monitor.h"
+#include "../utils/latency_histogram.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kFrameSamples = 512;
+const double kFrameMs = 32.0;
+
+const char* kResponse =
+    "Sure. Full duplex means both sides can talk and listen at the same time, so the agent "
+    "can be interrupted and can react while you are still speaking.";
+
+struct Options {
+    int sessions = 100;
+    double duration_s = 60.0;
+    double speech_ms = 1500.0;
+    double think_ms = 1000.0;
+    double asr_ms = 150.0;
+    double asr_ms_per_s = 30.0;
+    double llm_ttft_ms = 200.0;
+    double llm_tps = 30.0;
+    double tts_rtf = 0.1;
+    double tts_first_ms = 80.0;
+    bool playback = true;
+    bool verbose = false;
+    std::string out = "loadtest_summary.json";
+    std::string turn_log;   // Base path for the monitor's per-turn CSV/JSONL; off by default
+};
+
+const double kMaxWaitMs = 30000.0; // Give up on a turn that never gets answered
+
+// Frame-schedule lateness across all feeders (lock-free)
+LatencyHistogram frameLateness;
+
+struct SimSession {
+    int id;
+    VAD vad;
+    PersonaState persona;
+    MockLLM llm;
+    MockLLM monitorLLM;
+    TTSEngine tts;
+    EventBus bus;
+    DialogueController controller;
+    std::unique_ptr<AudioPipeline> pipeline;
+
+    std::atomic<int> endpoints{0};
+    std::atomic<int> replies{0};
+    std::thread feeder;
+
+    SimSession(int i, const Options& opt, ASRBackend* asr)
+        : id(i),
+          vad(0.02f),
+          llm(kResponse, opt.llm_ttft_ms, opt.llm_tps),
+          monitorLLM("NO", opt.llm_ttft_ms, opt.llm_tps),
+          tts(new MockTTS(opt.tts_rtf, opt.tts_first_ms)),
+          controller(&llm, &monitorLLM, &persona, &tts, &bus) {
+        tts.setPlaybackEnabled(opt.playback);
+        bus.subscribe(EventType::AudioStarted, [this](const PipelineEvent&) { replies++; });
+
+        AudioPipeline::Config config;
+        config.verbose = false;
+        EventBus* b = &bus;
+        pipeline.reset(new AudioPipeline(&vad, &controller, b, [this, asr, b](TraceId trace, std::vector<int16_t> audio) {
+            endpoints++;
+            // Same hand-off as main.cpp: ASR on a worker, transcript over the bus
+            std::thread([asr, b, trace](std::vector<int16_t> utterance) {
+                double asr_ms = 0.0;
+                std::string text = AudioPipeline::transcribeUtterance(asr, utterance, trace, &asr_ms);
+                if (!text.empty()) b->publish(EventType::FinalTranscript, trace, text, asr_ms);
+            }, std::move(audio)).detach();
+        }, config));
+        bus.start();
+    }
+
+    // A turn is settled once its reply has started and the agent went quiet
+    bool idle() const {
+        return replies.load() >= endpoints.load() && !controller.agentSpeaking;
+    }
+
+    void run(const Options& opt, Clock::time_point deadline) {
+        PerfMonitor::getInstance().setThreadName("session_feeder");
+        uint32_t rng = 0x9E3779B9u ^ (uint32_t)(id * 7919);
+        std::vector<int16_t> frame(kFrameSamples);
+
+        enum { Think, Speak, Wait } phase = Think;
+        // Stagger sessions so they don't all speak in lockstep
+        double phase_left_ms = (rng % 1000) / 1000.0 * (opt.speech_ms + opt.think_ms);
+        int waited_for = 0;
+
+        auto period = std::chrono::microseconds((int64_t)(kFrameMs * 1000.0));
+        auto next = Clock::now();
+        while (Clock::now() < deadline) {
+            if (phase == Speak) {
+                for (int16_t& s : frame) {
+                    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                    s = (int16_t)((int)(rng % 11000) - 5500); // ~0.1 RMS noise
+                }
+            } else {
+                std::fill(frame.begin(), frame.end(), 0);
+            }
+            pipeline->processFrame(frame);
+
+            phase_left_ms -= kFrameMs;
+            if (phase == Speak && phase_left_ms <= 0) {
+                phase = Wait;
+                phase_left_ms = kMaxWaitMs;
+                waited_for = endpoints.load() + 1;
+            } else if (phase == Wait && ((endpoints.load() >= waited_for && idle()) || phase_left_ms <= 0)) {
+                phase = Think;
+                phase_left_ms = opt.think_ms;
+            } else if (phase == Think && phase_left_ms <= 0) {
+                phase = Speak;
+                phase_left_ms = opt.speech_ms;
+            }
+
+            next += period;
+            auto now = Clock::now();
+            if (now > next) {
+                frameLateness.record(std::chrono::duration<double, std::milli>(now - next).count());
+            } else {
+                std::this_thread::sleep_until(next);
+            }
+        }
+    }
+};
+
+double argNum(int& i, int argc, char** argv) {
+    return i + 1 < argc ? std::atof(argv[++i]) : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sessions") opt.sessions = std::max(1, (int)argNum(i, argc, argv));
+        else if (arg == "--duration") opt.duration_s = argNum(i, argc, argv);
+        else if (arg == "--speech-ms") opt.speech_ms = argNum(i, argc, argv);
+        else if (arg == "--think-ms") opt.think_ms = argNum(i, argc, argv);
+        else if (arg == "--asr-ms") opt.asr_ms = argNum(i, argc, argv);
+        else if (arg == "--asr-ms-per-s") opt.asr_ms_per_s = argNum(i, argc, argv);
+        else if (arg == "--llm-ttft-ms") opt.llm_ttft_ms = argNum(i, argc, argv);
+        else if (arg == "--llm-tps") opt.llm_tps = argNum(i, argc, argv);
+        else if (arg == "--tts-rtf") opt.tts_rtf = argNum(i, argc, argv);
+        else if (arg == "--tts-first-ms") opt.tts_first_ms = argNum(i, argc, argv);
+        else if (arg == "--no-playback") opt.playback = false;
+        else if (arg == "--out" && i + 1 < argc) opt.out = argv[++i];
+        else if (arg == "--turn-log" && i + 1 < argc) opt.turn_log = argv[++i];
+        else if (arg == "--verbose") opt.verbose = true;
+        else {
+            std::cout << "Usage: voice_agent_loadtest [--sessions N] [--duration S] [--speech-ms MS] [--think-ms MS]\n"
+                      << "  [--asr-ms MS] [--asr-ms-per-s MS] [--llm-ttft-ms MS] [--llm-tps N] [--tts-rtf X]\n"
+                      << "  [--tts-first-ms MS] [--no-playback] [--out FILE] [--turn-log BASE] [--verbose]\n";
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    // Keep away from the agent's benchmark_results.*; --turn-log BASE writes BASE.csv / BASE.jsonl.
+    // No per-turn summary or [METRICS] block either: the latency summary goes into --out once at the end.
+    auto& monitor = PerfMonitor::getInstance();
+    if (opt.turn_log.empty()) monitor.setTurnLog("", "");
+    else monitor.setTurnLog(opt.turn_log + ".csv", opt.turn_log + ".jsonl");
+    monitor.setTurnSummary("");
+    monitor.setTurnConsole(opt.verbose);
+
+    // Per-turn console logging from hundreds of sessions would dominate the run
+    std::streambuf* console = std::cout.rdbuf();
+    if (!opt.verbose) std::cout.rdbuf(nullptr);
+
+    std::vector<std::string> transcripts = {
+        "Can you explain what full duplex conversation means", "Tell me a quick fact",
+        "How does real time speech processing work", "What happens when people interrupt each other"};
+    MockASR asr(transcripts, opt.asr_ms, opt.asr_ms_per_s);
+
+    std::vector<std::unique_ptr<SimSession>> sessions;
+    for (int i = 0; i < opt.sessions; ++i) sessions.emplace_back(new SimSession(i, opt, &asr));
+
+    auto start = Clock::now();
+    auto deadline = start + std::chrono::microseconds((int64_t)(opt.duration_s * 1e6));
+    for (auto& s : sessions) {
+        SimSession* session = s.get();
+        session->feeder = std::thread([session, &opt, deadline]() { session->run(opt, deadline); });
+    }
+    for (auto& s : sessions) s->feeder.join();
+
+    // Let in-flight turns finish before tearing the sessions down
+    auto drainUntil = Clock::now() + std::chrono::seconds(30);
+    bool drained = false;
+    while (!drained && Clock::now() < drainUntil) {
+        drained = std::all_of(sessions.begin(), sessions.end(), [](const std::unique_ptr<SimSession>& s) { return s->idle(); });
+        if (!drained) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Controller threads return after agentSpeaking drops
+    for (auto& s : sessions) s->bus.stop();
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout.rdbuf(console);
+    std::cout.clear();
+
+    const LatencyHistogram& e2e = monitor.histogram(LatencyMetric::E2E);
+    int words = 0;
+    {
+        std::istringstream ws(kResponse);
+        std::string w;
+        while (ws >> w) words++;
+    }
+    double speech_s = opt.speech_ms / 1000.0;
+    double floor_ms = opt.asr_ms + opt.asr_ms_per_s * speech_s + opt.llm_ttft_ms + words * 1000.0 / opt.llm_tps;
+    int endpoints = 0, replies = 0;
+    for (auto& s : sessions) { endpoints += s->endpoints; replies += s->replies; }
+
+    std::cout << "\n=== Load Test: " << opt.sessions << " sessions, " << elapsed_s << " s ===" << std::endl;
+    std::cout << "Turns: " << endpoints << " endpointed, " << replies << " answered ("
+              << replies / elapsed_s << " turns/s)" << (drained ? "" : " [did not drain]") << std::endl;
+    std::cout << "E2E P50/P90/P99: " << e2e.percentile(50) << " / " << e2e.percentile(90) << " / "
+              << e2e.percentile(99) << " ms (synthetic floor " << floor_ms << " ms)" << std::endl;
+    std::cout << "Orchestration overhead P50/P99: " << e2e.percentile(50) - floor_ms << " / "
+              << e2e.percentile(99) - floor_ms << " ms" << std::endl;
+    std::cout << "Late frames: " << frameLateness.count() << " (P50 " << frameLateness.percentile(50)
+              << " ms, P99 " << frameLateness.percentile(99) << " ms, max " << frameLateness.max() << " ms)" << std::endl;
+    monitor.printPercentiles();
+
+    std::ofstream out(opt.out, std::ios::trunc);
+    out << "{\"sessions\":" << opt.sessions << ",\"elapsed_s\":" << elapsed_s
+        << ",\"endpoints\":" << endpoints << ",\"replies\":" << replies
+        << ",\"turns_per_s\":" << replies / elapsed_s << ",\"drained\":" << (drained ? "true" : "false")
+        << ",\"floor_ms\":" << floor_ms
+        << ",\"e2e_p50\":" << e2e.percentile(50) << ",\"e2e_p90\":" << e2e.percentile(90)
+        << ",\"e2e_p99\":" << e2e.percentile(99)
+        << ",\"late_frames\":" << frameLateness.count() << ",\"late_p99_ms\":" << frameLateness.percentile(99)
+        << ",\"latency\":" << monitor.summaryJson() << "}\n";
+    return drained ? 0 : 1;
+}
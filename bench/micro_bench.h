@@ -0,0 +1,223 @@
+#ifndef MICRO_BENCH_H
+#define MICRO_BENCH_H
+
+// Small Google-Benchmark-style harness for the component benchmarks.
+//
+// A case body runs `state.iterations` times per call. The runner calibrates the
+// iteration count to --min-time, does one untimed warmup call, then repeats the
+// measurement --repetitions times and reports mean / median / stddev / CV / min of
+// the per-iteration time, plus any rate counters (tokens/s, RTF, ...) as medians.
+// Output is a console table and a JSON document (--out) for regression tracking.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+class State {
+public:
+    int64_t iterations = 1;
+
+    // Exclude setup work inside a case from the measurement
+    void pauseTiming() { paused_at = Clock::now(); }
+    void resumeTiming() { excluded += Clock::now() - paused_at; }
+
+    // Total work done across all iterations, reported per second
+    void setItemsProcessed(double items) { items_processed = items; }
+    // Free-form counter (median across repetitions); rate = true divides by elapsed seconds
+    void counter(const std::string& name, double value, bool rate = false) {
+        counters[name] = value;
+        rate_counters[name] = rate;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    friend class Runner;
+    Clock::time_point paused_at;
+    Clock::duration excluded{0};
+    double items_processed = 0.0;
+    std::map<std::string, double> counters;
+    std::map<std::string, bool> rate_counters;
+};
+
+// Keeps a result alive so the optimizer can't drop the work producing it
+inline void doNotOptimize(int64_t value) {
+    static volatile int64_t sink;
+    sink = value;
+    (void)sink;
+}
+
+struct Case {
+    std::string name;
+    std::function<void(State&)> fn;
+    int64_t fixed_iterations = 0; // > 0 skips calibration (expensive cases)
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline void add(const std::string& name, std::function<void(State&)> fn, int64_t fixed_iterations = 0) {
+    registry().push_back({name, std::move(fn), fixed_iterations});
+}
+
+struct Result {
+    std::string name;
+    int64_t iterations = 0;
+    int repetitions = 0;
+    double mean_ns = 0, median_ns = 0, stddev_ns = 0, cv = 0, min_ns = 0;
+    std::map<std::string, double> counters; // medians
+};
+
+class Runner {
+public:
+    double min_time_s = 0.5;
+    int repetitions = 10;
+    std::string filter = ".*";
+    std::string out;
+
+    bool parseArgs(int argc, char** argv, std::vector<std::string>& rest) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+            if (arg == "--filter") filter = next();
+            else if (arg == "--repetitions") repetitions = std::max(1, std::atoi(next().c_str()));
+            else if (arg == "--min-time") min_time_s = std::atof(next().c_str());
+            else if (arg == "--out") out = next();
+            else if (arg == "--list") listOnly = true;
+            else rest.push_back(arg);
+        }
+        return true;
+    }
+
+    int run() {
+        std::regex re(filter);
+        std::vector<Result> results;
+        std::cout << std::left << std::setw(36) << "benchmark" << std::right
+                  << std::setw(12) << "median" << std::setw(12) << "mean" << std::setw(8) << "cv%"
+                  << std::setw(10) << "iters" << "  counters\n";
+        for (Case& c : registry()) {
+            if (!std::regex_search(c.name, re)) continue;
+            if (listOnly) { std::cout << c.name << "\n"; continue; }
+            results.push_back(runCase(c));
+            print(results.back());
+        }
+        if (!out.empty()) writeJson(results);
+        return 0;
+    }
+
+private:
+    bool listOnly = false;
+
+    static double runOnce(Case& c, int64_t iterations, std::map<std::string, double>& counters) {
+        State state;
+        state.iterations = iterations;
+        auto start = State::Clock::now();
+        c.fn(state);
+        auto elapsed = State::Clock::now() - start - state.excluded;
+        double seconds = std::chrono::duration<double>(elapsed).count();
+
+        counters.clear();
+        if (state.items_processed > 0 && seconds > 0) counters["items_per_second"] = state.items_processed / seconds;
+        for (const auto& kv : state.counters) {
+            counters[kv.first] = state.rate_counters[kv.first] && seconds > 0 ? kv.second / seconds : kv.second;
+        }
+        return seconds;
+    }
+
+    Result runCase(Case& c) {
+        std::map<std::string, double> counters;
+
+        // Calibrate: grow iterations until one run covers min_time
+        int64_t iterations = c.fixed_iterations > 0 ? c.fixed_iterations : 1;
+        double seconds = runOnce(c, iterations, counters); // Also the warmup
+        while (c.fixed_iterations <= 0 && seconds < min_time_s && iterations < (int64_t)1e9) {
+            double scale = seconds > 0 ? min_time_s / seconds * 1.2 : 10.0;
+            iterations = (int64_t)std::ceil(iterations * std::min(std::max(scale, 2.0), 100.0));
+            seconds = runOnce(c, iterations, counters);
+        }
+
+        std::vector<double> per_iter;
+        std::map<std::string, std::vector<double>> counter_samples;
+        for (int r = 0; r < repetitions; ++r) {
+            seconds = runOnce(c, iterations, counters);
+            per_iter.push_back(seconds * 1e9 / iterations);
+            for (const auto& kv : counters) counter_samples[kv.first].push_back(kv.second);
+        }
+
+        Result res;
+        res.name = c.name;
+        res.iterations = iterations;
+        res.repetitions = repetitions;
+        res.median_ns = median(per_iter);
+        res.min_ns = *std::min_element(per_iter.begin(), per_iter.end());
+        for (double v : per_iter) res.mean_ns += v;
+        res.mean_ns /= per_iter.size();
+        for (double v : per_iter) res.stddev_ns += (v - res.mean_ns) * (v - res.mean_ns);
+        res.stddev_ns = per_iter.size() > 1 ? std::sqrt(res.stddev_ns / (per_iter.size() - 1)) : 0.0;
+        res.cv = res.mean_ns > 0 ? res.stddev_ns / res.mean_ns : 0.0;
+        for (auto& kv : counter_samples) res.counters[kv.first] = median(kv.second);
+        return res;
+    }
+
+    static double median(std::vector<double> v) {
+        std::sort(v.begin(), v.end());
+        size_t n = v.size();
+        return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+    }
+
+    static std::string formatNs(double ns) {
+        std::ostringstream s;
+        s << std::fixed << std::setprecision(2);
+        if (ns < 1e3) s << ns << " ns";
+        else if (ns < 1e6) s << ns / 1e3 << " us";
+        else if (ns < 1e9) s << ns / 1e6 << " ms";
+        else s << ns / 1e9 << " s";
+        return s.str();
+    }
+
+    static void print(const Result& r) {
+        std::cout << std::left << std::setw(36) << r.name << std::right
+                  << std::setw(12) << formatNs(r.median_ns) << std::setw(12) << formatNs(r.mean_ns)
+                  << std::setw(8) << std::fixed << std::setprecision(1) << r.cv * 100.0
+                  << std::setw(10) << r.iterations << " ";
+        for (const auto& kv : r.counters) {
+            std::cout << " " << kv.first << "=" << std::setprecision(kv.second < 10 ? 3 : 1) << kv.second;
+        }
+        std::cout << std::endl;
+    }
+
+    void writeJson(const std::vector<Result>& results) {
+        std::ofstream f(out, std::ios::trunc);
+        f << "{\"context\":{\"repetitions\":" << repetitions << ",\"min_time_s\":" << min_time_s
+          << "},\"benchmarks\":[";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            f << (i ? "," : "") << "\n{\"name\":\"" << r.name << "\""
+              << ",\"iterations\":" << r.iterations << ",\"repetitions\":" << r.repetitions
+              << ",\"time_unit\":\"ns\",\"median\":" << r.median_ns << ",\"mean\":" << r.mean_ns
+              << ",\"stddev\":" << r.stddev_ns << ",\"cv\":" << r.cv << ",\"min\":" << r.min_ns;
+            for (const auto& kv : r.counters) f << ",\"" << kv.first << "\":" << kv.second;
+            f << "}";
+        }
+        f << "\n]}\n";
+        std::cout << "[Bench] Wrote " << out << std::endl;
+    }
+};
+
+} // namespace bench
+
+#endif // MICRO_BENCH_H
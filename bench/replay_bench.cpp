@@ -0,0 +1,484 @@
+// Offline replay benchmark.
+//
+// Feeds the recorded test suite (test_audio/<category>/<i>_<name>.wav) through the
+// real VAD -> ASR -> LLM -> TTS pipeline without a microphone or speakers. Audio is
+// pushed through AudioPipeline as fast as it can be consumed, so endpointing runs on
+// the audio clock while every compute stage is timed for real, and the next
+// utterance starts as soon as the previous turn finishes.
+//
+// Writes one JSON line per utterance (replay_results.jsonl) plus a per-stage
+// P50/P90/P99 summary (replay_summary.json). Exits 1 if any utterance produced no
+// turn; --max-e2e-p90 also fails the run when it regresses past a budget.
+
+#include "../audio/vad.h"
+#include "../asr/whisper_stream.h"
+#include "../llm/llama_stream.h"
+#include "../tts/tts_stream.h"
+#include "../persona/persona_state.h"
+#include "../controller/dialogue_controller.h"
+#include "../controller/audio_pipeline.h"
+#include "../utils/perf_monitor.h"
+#include "../utils/json_util.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int kSampleRate = 16000;
+const int kFrameSamples = 512;       // Same chunking as MicrophoneStream
+const int kMaxTrailingSilenceMs = 3000;
+
+struct Options {
+    std::string suite = "automated_test_suite.json";
+    std::string audio_dir = "test_audio";
+    std::string out = "replay_results.jsonl";
+    std::string summary = "replay_summary.json";
+    std::string turn_log;   // Base path for the monitor's per-turn CSV/JSONL; off by default
+    std::string category;
+    std::string llm_model = "models/qwen2.5-3b-instruct-q4_k_m.gguf";
+    std::string asr_model = "models/ggml-medium.en-q5_0.bin";
+    std::string vad_model = "models/silero_vad.onnx";
+    int repeat = 1;
+    int warmup = 1;
+    bool tts = true;
+    bool isolated = false;
+    bool partial_asr = true;
+    bool trim_asr = true;
+    std::string vad_probs;
+    double max_e2e_p90 = 0.0;
+};
+
+struct Utterance {
+    std::string category;
+    int index;
+    std::string expected;
+    std::string wav;
+};
+
+struct Result {
+    Utterance utt;
+    std::string transcript;
+    bool ok = false;
+    double audio_ms = 0.0;
+    double endpoint_ms = 0.0;
+    double asr_ms = 0.0;
+    double ttft_ms = 0.0;
+    double first_sentence_ms = 0.0;
+    double tts_first_audio_ms = 0.0;
+    double e2e_ms = 0.0;
+    double perceived_ms = 0.0;  // End of speech to first agent audio
+    int tokens = 0;
+    double tts_audio_s = 0.0;
+    double wall_ms = 0.0;
+};
+
+void usage() {
+    std::cout << "Usage: voice_agent_replay [options]\n"
+              << "  --suite FILE         Test suite JSON (automated_test_suite.json)\n"
+              << "  --audio DIR          Recorded suite audio (test_audio)\n"
+              << "  --category NAME      Only replay one category\n"
+              << "  --out FILE           Per-utterance JSONL (replay_results.jsonl)\n"
+              << "  --summary FILE       Stage percentiles JSON (replay_summary.json)\n"
+              << "  --turn-log BASE      Also write the monitor's BASE.csv / BASE.jsonl turn logs\n"
+              << "  --repeat N           Replay the suite N times\n"
+              << "  --warmup N           Untimed utterances before measuring (1)\n"
+              << "  --no-tts             Stop after the LLM (no Piper synthesis)\n"
+              << "  --isolated           Clear dialogue history between utterances\n"
+              << "  --no-partial-asr     Endpoint on VAD only (no turn-completion scoring)\n"
+              << "  --no-trim            Full 30 s Whisper encoder window (no audio_ctx trimming)\n"
+              << "  --vad-probs FILE     Per-frame VAD probabilities as CSV (threshold tuning)\n"
+              << "  --max-e2e-p90 MS     Exit 1 if E2E P90 exceeds MS\n"
+              << "  --llm/--asr/--vad P  Model paths\n";
+}
+
+// automated_test_suite.json is { "category": ["utterance", ...], ... }.
+// Just enough of a JSON reader for that shape.
+class SuiteParser {
+public:
+    explicit SuiteParser(const std::string& s) : src(s) {}
+
+    bool parse(std::vector<std::pair<std::string, std::vector<std::string>>>& out) {
+        if (!expect('{')) return false;
+        if (peek() == '}') return true;
+        while (true) {
+            std::string key;
+            if (!readString(key) || !expect(':') || !expect('[')) return false;
+            std::vector<std::string> items;
+            if (peek() != ']') {
+                while (true) {
+                    std::string item;
+                    if (!readString(item)) return false;
+                    items.push_back(item);
+                    if (peek() == ',') { ++pos; continue; }
+                    break;
+                }
+            }
+            if (!expect(']')) return false;
+            out.emplace_back(key, items);
+            if (peek() == ',') { ++pos; continue; }
+            return expect('}');
+        }
+    }
+
+private:
+    const std::string& src;
+    size_t pos = 0;
+
+    char peek() {
+        while (pos < src.size() && std::isspace((unsigned char)src[pos])) ++pos;
+        return pos < src.size() ? src[pos] : '\0';
+    }
+    bool expect(char c) {
+        if (peek() != c) return false;
+        ++pos;
+        return true;
+    }
+    bool readString(std::string& out) {
+        if (!expect('"')) return false;
+        while (pos < src.size() && src[pos] != '"') {
+            char c = src[pos++];
+            if (c == '\\' && pos < src.size()) {
+                char e = src[pos++];
+                switch (e) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'u': c = '?'; pos = std::min(src.size(), pos + 4); break;
+                    default: c = e; break;
+                }
+            }
+            out += c;
+        }
+        return expect('"');
+    }
+};
+
+// Same file naming as generate_test_audio.py / automated_test.py
+std::string wavName(int index, const std::string& text) {
+    std::string safe;
+    for (char c : text.substr(0, 20)) {
+        safe += std::isalnum((unsigned char)c) ? (char)std::tolower((unsigned char)c) : '_';
+    }
+    return std::to_string(index) + "_" + safe + ".wav";
+}
+
+double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    double rank = p / 100.0 * (v.size() - 1);
+    size_t lo = (size_t)rank;
+    size_t hi = std::min(lo + 1, v.size() - 1);
+    return v[lo] + (v[hi] - v[lo]) * (rank - lo);
+}
+
+double mean(const std::vector<double>& v) {
+    if (v.empty()) return 0.0;
+    double s = 0.0;
+    for (double x : v) s += x;
+    return s / v.size();
+}
+
+std::string resultJson(const Result& r) {
+    std::ostringstream out;
+    out << "{\"category\":\"" << jsonEscape(r.utt.category) << "\""
+        << ",\"index\":" << r.utt.index
+        << ",\"file\":\"" << jsonEscape(r.utt.wav) << "\""
+        << ",\"expected\":\"" << jsonEscape(r.utt.expected) << "\""
+        << ",\"transcript\":\"" << jsonEscape(r.transcript) << "\""
+        << ",\"ok\":" << (r.ok ? "true" : "false")
+        << ",\"audio_ms\":" << r.audio_ms
+        << ",\"endpoint_ms\":" << r.endpoint_ms
+        << ",\"asr_ms\":" << r.asr_ms
+        << ",\"llm_ttft_ms\":" << r.ttft_ms
+        << ",\"first_sentence_ms\":" << r.first_sentence_ms
+        << ",\"tts_first_audio_ms\":" << r.tts_first_audio_ms
+        << ",\"e2e_ms\":" << r.e2e_ms
+        << ",\"perceived_ms\":" << r.perceived_ms
+        << ",\"tokens\":" << r.tokens
+        << ",\"tts_audio_s\":" << r.tts_audio_s
+        << ",\"wall_ms\":" << r.wall_ms << "}";
+    return out.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--suite") opt.suite = next();
+        else if (arg == "--audio") opt.audio_dir = next();
+        else if (arg == "--category") opt.category = next();
+        else if (arg == "--out") opt.out = next();
+        else if (arg == "--summary") opt.summary = next();
+        else if (arg == "--turn-log") opt.turn_log = next();
+        else if (arg == "--repeat") opt.repeat = std::max(1, std::atoi(next().c_str()));
+        else if (arg == "--warmup") opt.warmup = std::max(0, std::atoi(next().c_str()));
+        else if (arg == "--no-tts") opt.tts = false;
+        else if (arg == "--isolated") opt.isolated = true;
+        else if (arg == "--no-partial-asr") opt.partial_asr = false;
+        else if (arg == "--no-trim") opt.trim_asr = false;
+        else if (arg == "--vad-probs") opt.vad_probs = next();
+        else if (arg == "--max-e2e-p90") opt.max_e2e_p90 = std::atof(next().c_str());
+        else if (arg == "--llm") opt.llm_model = next();
+        else if (arg == "--asr") opt.asr_model = next();
+        else if (arg == "--vad") opt.vad_model = next();
+        else { usage(); return arg == "--help" ? 0 : 2; }
+    }
+
+    // 1. Suite -> utterance list
+    std::ifstream suiteFile(opt.suite);
+    if (!suiteFile.is_open()) {
+        std::cerr << "[Replay] Could not open suite: " << opt.suite << std::endl;
+        return 2;
+    }
+    std::stringstream raw;
+    raw << suiteFile.rdbuf();
+    std::string suiteText = raw.str();
+    std::vector<std::pair<std::string, std::vector<std::string>>> suite;
+    if (!SuiteParser(suiteText).parse(suite)) {
+        std::cerr << "[Replay] Could not parse suite: " << opt.suite << std::endl;
+        return 2;
+    }
+
+    std::vector<Utterance> utterances;
+    for (const auto& category : suite) {
+        if (!opt.category.empty() && category.first != opt.category) continue;
+        for (int i = 0; i < (int)category.second.size(); ++i) {
+            fs::path wav = fs::path(opt.audio_dir) / category.first / wavName(i, category.second[i]);
+            if (!fs::exists(wav)) {
+                std::cerr << "[Replay] Missing audio, skipping: " << wav.string() << std::endl;
+                continue;
+            }
+            utterances.push_back({category.first, i, category.second[i], wav.string()});
+        }
+    }
+    if (utterances.empty()) {
+        std::cerr << "[Replay] No utterances to replay (run generate_test_audio.py first)" << std::endl;
+        return 2;
+    }
+
+    // 2. Engines (load time is not part of the benchmark)
+    std::wstring vadPath(opt.vad_model.begin(), opt.vad_model.end());
+    VAD vad(vadPath);
+    PersonaState persona;
+    LLMStream llm(opt.llm_model);
+    WhisperASR::Config asrConfig;
+    asrConfig.trim_audio_ctx = opt.trim_asr;
+    WhisperASR asr(opt.asr_model, asrConfig);
+    TTSEngine tts;
+    tts.setPlaybackEnabled(false);
+    tts.setSynthesisEnabled(opt.tts); // --no-tts: turns end at the LLM
+
+    // No bus: turns run synchronously on this thread. The monitor LLM is never
+    // consulted because the agent is never speaking while audio is fed.
+    DialogueController controller(&llm, &llm, &persona, &tts);
+
+    auto& monitor = PerfMonitor::getInstance();
+    monitor.setThreadName("replay");
+    // Keep away from the agent's benchmark_results.* (replay_results.jsonl has the per-utterance rows)
+    if (opt.turn_log.empty()) monitor.setTurnLog("", "");
+    else monitor.setTurnLog(opt.turn_log + ".csv", opt.turn_log + ".jsonl");
+    monitor.setTurnSummary(""); // replay_summary.json is written at the end
+
+    TurnTrace lastTurn;
+    bool haveTurn = false;
+    monitor.addTurnListener([&](const TurnTrace& t) {
+        lastTurn = t;
+        haveTurn = true;
+    });
+
+    std::vector<std::pair<TraceId, std::vector<int16_t>>> endpointed;
+    AudioPipeline::Config config;
+    config.backchannel_after_frames = 0;
+    config.verbose = false;
+    AudioPipeline pipeline(&vad, &controller, nullptr, [&](TraceId trace, std::vector<int16_t> audio) {
+        endpointed.emplace_back(trace, std::move(audio));
+    }, config);
+    if (opt.partial_asr) {
+        // Scored inline, but the score only counts once the pause has lasted as long
+        // as the partial transcription took, as it would live
+        pipeline.setPartialHandler([&](uint64_t pause_id, std::vector<int16_t> audio) {
+            auto t0 = std::chrono::steady_clock::now();
+            float score = AudioPipeline::scoreCompletion(&asr, audio);
+            std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - t0;
+            pipeline.setTurnCompletion(pause_id, score, took.count());
+        });
+    }
+
+    std::ofstream probsFile;
+    std::string probsWav;
+    if (!opt.vad_probs.empty()) {
+        probsFile.open(opt.vad_probs, std::ios::trunc);
+        probsFile << "wav,frame,prob,speech\n";
+        pipeline.setProbListener([&](int64_t frame, float prob, bool speech) {
+            probsFile << probsWav << "," << frame << "," << prob << "," << (speech ? 1 : 0) << "\n";
+        });
+    }
+
+    std::ofstream out(opt.out, std::ios::trunc);
+    std::vector<Result> results;
+    double measuredWallMs = 0.0;
+    double measuredAudioMs = 0.0;
+    int total = (int)utterances.size() * opt.repeat;
+
+    std::cout << "[Replay] " << utterances.size() << " utterances x " << opt.repeat
+              << " (+" << opt.warmup << " warmup)" << std::endl;
+
+    for (int n = -opt.warmup; n < total; ++n) {
+        // Warmup replays the first utterances untimed (model caches, page faults)
+        bool measured = n >= 0;
+        const Utterance& utt = utterances[(measured ? n : n + opt.warmup) % utterances.size()];
+
+        std::vector<int16_t> wav;
+        if (!WhisperASR::load_wav(utt.wav, wav)) continue;
+
+        probsWav = utt.wav;
+        Result r;
+        r.utt = utt;
+        r.audio_ms = wav.size() * 1000.0 / kSampleRate;
+        if (opt.isolated) controller.clearHistory();
+
+        auto start = std::chrono::steady_clock::now();
+
+        // Feed the recording, then silence until the pipeline endpoints
+        vad.reset();
+        pipeline.reset();
+        endpointed.clear();
+        std::vector<int16_t> frame(kFrameSamples);
+        for (size_t off = 0; off < wav.size(); off += kFrameSamples) {
+            size_t len = std::min((size_t)kFrameSamples, wav.size() - off);
+            std::fill(frame.begin(), frame.end(), 0);
+            std::copy(wav.begin() + off, wav.begin() + off + len, frame.begin());
+            pipeline.processFrame(frame);
+        }
+        std::fill(frame.begin(), frame.end(), 0);
+        double fedMs = pipeline.audioTimeMs();
+        while (endpointed.empty() && pipeline.audioTimeMs() - fedMs < kMaxTrailingSilenceMs) {
+            pipeline.processFrame(frame);
+        }
+
+        // Every endpointed segment becomes a turn, back to back
+        for (auto& seg : endpointed) {
+            haveTurn = false;
+            std::string text = AudioPipeline::transcribeUtterance(&asr, seg.second, seg.first, nullptr,
+                                                                  controller.asrContext());
+            if (text.empty()) continue;
+            if (!r.transcript.empty()) r.transcript += " ";
+            r.transcript += text;
+            controller.respond(text, seg.first);
+            if (haveTurn) {
+                const InteractionMetrics& m = lastTurn.metrics;
+                r.ok = true;
+                r.endpoint_ms += m.vad_latency_ms;
+                r.asr_ms += m.asr_latency_ms;
+                r.ttft_ms += m.llm_ttft_ms;
+                r.first_sentence_ms += m.first_sentence_ms;
+                r.tts_first_audio_ms += m.tts_latency_ms;
+                r.e2e_ms += m.total_e2e_ms;
+                r.tokens += m.token_count;
+                r.tts_audio_s += tts.lastAudioSeconds();
+            }
+        }
+        r.perceived_ms = r.endpoint_ms + r.e2e_ms;
+
+        std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - start;
+        r.wall_ms = wall.count();
+        if (!measured) continue;
+
+        measuredWallMs += r.wall_ms;
+        measuredAudioMs += r.audio_ms;
+        out << resultJson(r) << "\n";
+        out.flush();
+        results.push_back(r);
+        std::cout << "[Replay] " << results.size() << "/" << total << " " << utt.category << "#" << utt.index
+                  << (r.ok ? "" : " (no turn)") << " E2E " << r.e2e_ms << " ms" << std::endl;
+    }
+
+    // 3. Summary
+    std::vector<std::pair<const char*, std::vector<double>>> stages = {
+        {"endpoint", {}}, {"asr", {}}, {"llm_ttft", {}}, {"first_sentence", {}},
+        {"tts_first_audio", {}}, {"e2e", {}}, {"perceived", {}}, {"wall", {}}};
+    int failed = 0;
+    for (const Result& r : results) {
+        if (!r.ok) { failed++; continue; }
+        stages[0].second.push_back(r.endpoint_ms);
+        stages[1].second.push_back(r.asr_ms);
+        stages[2].second.push_back(r.ttft_ms);
+        stages[3].second.push_back(r.first_sentence_ms);
+        if (opt.tts) stages[4].second.push_back(r.tts_first_audio_ms);
+        stages[5].second.push_back(r.e2e_ms);
+        stages[6].second.push_back(r.perceived_ms);
+        stages[7].second.push_back(r.wall_ms);
+    }
+
+    double wallS = measuredWallMs / 1000.0;
+    double audioS = measuredAudioMs / 1000.0;
+    double perMinute = wallS > 0 ? results.size() * 60.0 / wallS : 0.0;
+    double realtime = wallS > 0 ? audioS / wallS : 0.0;
+
+    std::cout << "\n=== Replay Summary (" << results.size() << " utterances, " << failed << " without a turn) ===\n"
+              << std::left << std::setw(18) << "stage" << std::right
+              << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90"
+              << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    std::ostringstream json;
+    json << "{\"utterances\":" << results.size() << ",\"failed\":" << failed
+         << ",\"wall_s\":" << wallS << ",\"audio_s\":" << audioS
+         << ",\"utterances_per_min\":" << perMinute << ",\"realtime_factor\":" << realtime
+         << ",\"stages\":{";
+    bool firstStage = true;
+    for (const auto& stage : stages) {
+        if (stage.second.empty()) continue;
+        double p50 = percentile(stage.second, 50), p90 = percentile(stage.second, 90);
+        double p99 = percentile(stage.second, 99), mx = percentile(stage.second, 100);
+        std::cout << std::left << std::setw(18) << stage.first << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << mean(stage.second) << std::setw(10) << p50 << std::setw(10) << p90
+                  << std::setw(10) << p99 << std::setw(10) << mx << "\n";
+        json << (firstStage ? "" : ",") << "\"" << stage.first << "\":{\"mean\":" << mean(stage.second)
+             << ",\"p50\":" << p50 << ",\"p90\":" << p90 << ",\"p99\":" << p99 << ",\"max\":" << mx << "}";
+        firstStage = false;
+    }
+    json << "}}";
+    std::cout << "Throughput: " << perMinute << " utterances/min, " << realtime
+              << "x realtime (" << audioS << " s audio in " << wallS << " s)" << std::endl;
+
+    std::ofstream summaryFile(opt.summary, std::ios::trunc);
+    summaryFile << json.str() << "\n";
+
+    // A run that measured nothing must not pass the gate with an E2E of 0
+    int skipped = total - (int)results.size(); // Unreadable WAVs
+    if (results.empty()) {
+        std::cerr << "[Replay] FAIL: no utterances were replayed" << std::endl;
+        return 1;
+    }
+    if (failed > 0 || skipped > 0) {
+        std::cerr << "[Replay] FAIL: " << failed << " utterances produced no turn, "
+                  << skipped << " could not be loaded" << std::endl;
+        return 1;
+    }
+    if (stages[5].second.empty()) {
+        std::cerr << "[Replay] FAIL: no E2E samples (no turn reached playback)" << std::endl;
+        return 1;
+    }
+    if (opt.max_e2e_p90 > 0) {
+        double p90 = percentile(stages[5].second, 90);
+        if (p90 > opt.max_e2e_p90) {
+            std::cerr << "[Replay] FAIL: E2E P90 " << p90 << " ms > budget " << opt.max_e2e_p90 << " ms" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "audio_pipeline.h"
+#include "../audio/overlap_classifier.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+AudioPipeline::AudioPipeline(VAD* v, DialogueController* c, EventBus* b, UtteranceHandler handler)
+    : AudioPipeline(v, c, b, std::move(handler), Config()) {}
+
+AudioPipeline::AudioPipeline(VAD* v, DialogueController* c, EventBus* b, UtteranceHandler handler, Config cfg)
+    : vad(v), controller(c), bus(b), onUtterance(std::move(handler)), config(cfg), segmenter(cfg.vad),
+      endpointer(cfg.endpoint),
+      // Longest look-back: a barge-in capture (interrupt_ms of speech) plus pre-roll, with a frame of slack
+      preroll((size_t)((std::max(cfg.interrupt_ms, cfg.vad.min_speech_ms) + cfg.vad.preroll_ms + 64.0) *
+                       cfg.sample_rate / 1000.0)) {}
+
+void AudioPipeline::reset() {
+    audio_buffer.clear();
+    speech_end = 0;
+    preroll.clear();
+    is_speaking = false;
+    interrupted = false;
+    overlap_classified = false;
+    overlap_ignored = false;
+    segmenter.reset();
+    endpointer.reset();
+    speech_chunk_count = 0;
+    samples_seen = 0;
+    last_voice_sample = 0;
+    last_backchannel_sample = 0;
+}
+
+void AudioPipeline::setOverlapClassifier(const OverlapClassifier* c) {
+    classifier = c && c->loaded() ? c : nullptr;
+}
+
+double AudioPipeline::audioTimeMs() const {
+    return samples_seen * 1000.0 / config.sample_rate;
+}
+
+void AudioPipeline::processFrame(const std::vector<int16_t>& chunk) {
+    auto& monitor = PerfMonitor::getInstance();
+    samples_seen += (int64_t)chunk.size();
+    double frame_ms = chunk.size() * 1000.0 / config.sample_rate;
+
+    Span vad_span = monitor.startSpan(0, "vad");
+    float prob = vad->speechProb(chunk.data(), (int)chunk.size());
+    monitor.endSpan(vad_span);
+    VADSegmenter::Frame vf = segmenter.push(prob, frame_ms);
+    if (vf.event != VADSegmenter::Event::None) interrupted = false;
+    if (vf.event == VADSegmenter::Event::SpeechStart) overlap_classified = false;
+
+    preroll.push(chunk.data(), chunk.size());
+
+    // A backchannel over the agent is dropped whole, never becoming a turn
+    if (overlap_ignored) {
+        if (vf.event == VADSegmenter::Event::SpeechEnd) overlap_ignored = false;
+        return;
+    }
+
+    // FULL DUPLEX 1: Interruption (sustained speech, so the agent's own echo doesn't trigger it).
+    // With a classifier this is only the backstop for overlap it wasn't sure about.
+    double interrupt_after = classifier ? config.classify_fallback_ms : config.interrupt_ms;
+    if (controller->agentSpeaking && !interrupted && segmenter.speechMs() >= interrupt_after) {
+        std::cout << "\n[INTERRUPT] User speech detected while agent speaking!" << std::endl;
+        if (bus) bus->publish(EventType::Interrupt);
+        interrupted = true;
+        // Capture from where the barge-in started (plus pre-roll), not from the frame that
+        // confirmed it. The classifier path has been buffering the segment since its onset.
+        if (!classifier || !is_speaking) {
+            audio_buffer.clear();
+            size_t back = (size_t)((segmenter.speechMs() + config.vad.preroll_ms) * config.sample_rate / 1000.0);
+            preroll.appendLast(back, audio_buffer);
+        }
+        is_speaking = true;
+        speech_end = audio_buffer.size();
+        endpointer.reset();
+        last_voice_sample = samples_seen;
+        return;
+    }
+
+    if (vf.speech && !is_speaking) {
+        if (config.verbose) std::cout << "\n[User detected]: " << std::flush;
+        if (bus) bus->publish(EventType::SpeechStart);
+        is_speaking = true;
+        audio_buffer.clear();
+        endpointer.reset();
+        speech_chunk_count = 0;
+        last_backchannel_sample = samples_seen;
+
+        // Onset was confirmed a few frames late: take those frames and the pre-roll
+        // from the ring (this frame included)
+        int frames = vf.event == VADSegmenter::Event::SpeechStart ? vf.onset_frames : 1;
+        preroll.appendLast((size_t)frames * chunk.size(), audio_buffer);
+    } else if (is_speaking) {
+        audio_buffer.insert(audio_buffer.end(), chunk.begin(), chunk.end());
+    }
+
+    if (!is_speaking) return;
+
+    // FULL DUPLEX 1b: Overlap classifier -- interrupt vs. backchannel/noise from the
+    // first classify_ms of speech over the agent, no ASR or LLM involved
+    if (classifier && controller->agentSpeaking && !interrupted && !overlap_classified &&
+        (segmenter.speechMs() >= config.classify_ms || vf.event == VADSegmenter::Event::SpeechEnd)) {
+        overlap_classified = true;
+        size_t end = vf.speech ? audio_buffer.size() : std::min(speech_end, audio_buffer.size());
+        OverlapClassifier::Result r;
+        {
+            ScopedSpan classify_span(0, "overlap_classify");
+            r = classifier->classify(audio_buffer.data(), end);
+        }
+        OverlapClassifier::Label label = r.label();
+        float confidence = r.confidence();
+        if (confidence < config.classify_confidence) {
+            std::cout << "\n[Overlap] Unsure (" << OverlapClassifier::labelName(label) << " " << confidence
+                      << "), leaving it to the monitor" << std::endl;
+        } else if (label == OverlapClassifier::Label::Interrupt) {
+            std::cout << "\n[INTERRUPT] Overlap classified as interruption (" << confidence << ")" << std::endl;
+            if (bus) bus->publish(EventType::Interrupt);
+            interrupted = true;
+        } else {
+            std::cout << "\n[Overlap] " << OverlapClassifier::labelName(label) << " (" << confidence
+                      << "), ignored" << std::endl;
+            audio_buffer.clear();
+            speech_end = 0;
+            is_speaking = false;
+            endpointer.reset();
+            overlap_ignored = vf.event != VADSegmenter::Event::SpeechEnd;
+            return;
+        }
+    }
+
+    if (vf.speech) {
+        speech_end = audio_buffer.size();
+        endpointer.onVoiced(prob);
+        last_voice_sample = samples_seen;
+        if (config.verbose) std::cout << "." << std::flush;
+
+        // FULL DUPLEX 2: Backchanneling
+        // If user speaks for > 4 seconds, throw in an "uh-huh" or "yeah"
+        speech_chunk_count++;
+        int64_t since_backchannel_ms = (samples_seen - last_backchannel_sample) * 1000 / config.sample_rate;
+        if (config.backchannel_after_frames > 0 &&
+            speech_chunk_count > config.backchannel_after_frames &&
+            since_backchannel_ms > config.backchannel_interval_ms) {
+            std::cout << "\n[Backchanneling...]" << std::flush;
+            controller->tts->playBackchannel("generic");
+            last_backchannel_sample = samples_seen;
+        }
+        return;
+    }
+
+    bool end_turn = endpointer.onSilence(prob, frame_ms);
+    if (!end_turn) {
+        if (onPartial && endpointer.takeScoreRequest()) onPartial(endpointer.pauseId(), audio_buffer);
+        return;
+    }
+
+    if (config.verbose) std::cout << " [Processing...]" << std::endl;
+
+    // New trace per turn: E2E is measured from this endpoint. The endpoint wait is
+    // taken from the audio clock, so it is exact in live mode and in replay alike.
+    auto endpoint_time = std::chrono::steady_clock::now();
+    auto waited = std::chrono::microseconds((samples_seen - last_voice_sample) * 1000000 / config.sample_rate);
+    TraceId trace = monitor.beginTurn(endpoint_time, config.session_id);
+    monitor.recordSpan(trace, "vad_endpoint", endpoint_time - waited, endpoint_time);
+    if (bus) bus->publish(EventType::SpeechEnd, trace);
+
+    if (config.verbose && endpointer.completion() >= 0.0f) {
+        std::cout << "[Endpoint] " << endpointer.pauseMs() << " ms pause, completion "
+                  << endpointer.completion() << std::endl;
+    }
+
+    // Trailing silence only costs ASR time: keep the post-roll and drop the rest
+    size_t postroll = (size_t)(config.vad.postroll_ms * config.sample_rate / 1000.0);
+    audio_buffer.resize(std::min(audio_buffer.size(), speech_end + postroll));
+
+    std::vector<int16_t> utterance;
+    utterance.swap(audio_buffer);
+    speech_end = 0;
+    is_speaking = false;
+    endpointer.reset();
+
+    onUtterance(trace, std::move(utterance));
+}
+
+std::string AudioPipeline::transcribeUtterance(ASRBackend* asr, const std::vector<int16_t>& audio, TraceId trace,
+                                               double* asr_ms_out, const std::string& context, const char* span) {
+    auto& monitor = PerfMonitor::getInstance();
+    Span asr_span = monitor.startSpan(trace, span);
+    std::string text;
+    asr->transcribeWithContext(audio, context, [&](const std::string& segment){
+        text += segment;
+    });
+    double asr_ms = monitor.endSpan(asr_span);
+    if (asr_ms_out) *asr_ms_out = asr_ms;
+
+    // Non-speech output ([BLANK_AUDIO] etc.) is suppressed at decode time (WhisperASR::Config)
+    if (text.find_first_not_of(" \t\r\n") == std::string::npos) {
+        monitor.dropTurn(trace);
+        return "";
+    }
+
+    std::cout << "User: " << text << " (ASR: " << asr_ms << "ms)" << std::endl;
+    return text;
+}
+
+float AudioPipeline::scoreCompletion(ASRBackend* asr, const std::vector<int16_t>& audio) {
+    std::string text;
+    asr->transcribe(audio, [&](const std::string& segment) {
+        text += segment;
+    });
+    return Endpointer::completionScore(text);
+}
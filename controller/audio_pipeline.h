@@ -0,0 +1,106 @@
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../audio/vad.h"
+#include "../audio/vad_segmenter.h"
+#include "../audio/preroll_buffer.h"
+#include "../asr/asr_backend.h"
+#include "dialogue_controller.h"
+#include "endpointer.h"
+#include "../utils/event_bus.h"
+#include "../utils/perf_monitor.h"
+
+class OverlapClassifier;
+
+// Per-frame turn-taking: VAD, barge-in debounce, backchannels and endpointing.
+// This is what main.cpp's processing_thread runs for every microphone chunk, and
+// what the replay benchmark drives from WAV files. All timing decisions count
+// audio samples rather than wall time, so the same input always gives the same
+// turns no matter how fast frames are fed.
+class AudioPipeline {
+public:
+    struct Config {
+        int sample_rate = 16000;
+        VADSegmenter::Config vad;          // Onset/offset hysteresis, min durations, pre-roll
+        double interrupt_ms = 256.0;       // Sustained speech while agent talks (echo debounce; ~64 with AEC)
+        // With an OverlapClassifier, speech over the agent is classified after
+        // classify_ms (or when it ends, if shorter) instead of the debounce above
+        double classify_ms = 320.0;
+        float classify_confidence = 0.7f;  // Below this the monitor LLM decides from the transcript
+        double classify_fallback_ms = 1500.0; // Overlap still going this long interrupts anyway
+        Endpointer::Config endpoint;       // Adaptive end-of-turn silence
+        int backchannel_after_frames = 120; // 0 disables backchannels
+        int backchannel_interval_ms = 4000;
+        bool verbose = true;               // Console progress dots
+        uint32_t session_id = 0;           // Tags turns in server mode
+    };
+
+    // Called at every endpoint with the new turn's trace and the captured audio
+    using UtteranceHandler = std::function<void(TraceId trace, std::vector<int16_t> audio)>;
+    // Called once per pause with the audio so far; should score it (partial ASR +
+    // Endpointer::completionScore) and report back through setTurnCompletion()
+    using PartialHandler = std::function<void(uint64_t pause_id, std::vector<int16_t> audio)>;
+
+    AudioPipeline(VAD* vad, DialogueController* controller, EventBus* bus, UtteranceHandler onUtterance);
+    AudioPipeline(VAD* vad, DialogueController* controller, EventBus* bus, UtteranceHandler onUtterance, Config config);
+
+    void processFrame(const std::vector<int16_t>& frame);
+    void reset();
+
+    // Raw per-frame VAD probabilities (threshold tuning, plots)
+    void setProbListener(VADSegmenter::ProbListener listener) { segmenter.setProbListener(std::move(listener)); }
+
+    // Optional (not owned); without one, barge-in is the interrupt_ms debounce
+    void setOverlapClassifier(const OverlapClassifier* c);
+
+    // Optional; without one, endpointing uses VAD probabilities and pause length only
+    void setPartialHandler(PartialHandler handler) { onPartial = std::move(handler); }
+    // Thread-safe. delay_ms: see Endpointer::setCompletion
+    void setTurnCompletion(uint64_t pause_id, float score, double delay_ms = 0.0) {
+        endpointer.setCompletion(pause_id, score, delay_ms);
+    }
+
+    // Audio time consumed so far (the pipeline's clock)
+    double audioTimeMs() const;
+
+    // Runs ASR for a finished utterance under the turn's "asr" span (or span),
+    // prompted with the dialogue context if given. Returns "" (and drops the
+    // turn) when nothing was recognized.
+    static std::string transcribeUtterance(ASRBackend* asr, const std::vector<int16_t>& audio, TraceId trace,
+                                           double* asr_ms = nullptr, const std::string& context = "",
+                                           const char* span = "asr");
+
+    // Partial transcript of the audio so far -> Endpointer::completionScore.
+    // No turn bookkeeping; for PartialHandlers.
+    static float scoreCompletion(ASRBackend* asr, const std::vector<int16_t>& audio);
+
+private:
+    VAD* vad;
+    DialogueController* controller;
+    EventBus* bus;
+    UtteranceHandler onUtterance;
+    PartialHandler onPartial;
+    Config config;
+    VADSegmenter segmenter;
+    Endpointer endpointer;
+
+    std::vector<int16_t> audio_buffer;  // Current turn, pauses included
+    size_t speech_end = 0;              // audio_buffer size after the last speech frame
+    PrerollBuffer preroll;              // Recent audio, put back in front of onsets and barge-ins
+    bool is_speaking = false;
+    bool interrupted = false;           // Barge-in already raised for this segment
+    const OverlapClassifier* classifier = nullptr;
+    bool overlap_classified = false;    // Classifier already ran on this segment
+    bool overlap_ignored = false;       // Backchannel/noise: drop the rest of the segment
+    int speech_chunk_count = 0;
+
+    int64_t samples_seen = 0;        // Pipeline clock
+    int64_t last_voice_sample = 0;   // End of the last voiced frame
+    int64_t last_backchannel_sample = 0;
+};
+
+#endif // AUDIO_PIPELINE_H
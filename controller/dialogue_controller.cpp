@@ -1,123 +1,265 @@
 #include "dialogue_controller.h"
-#include "../utils/perf_monitor.h" // Research: Metrics logging
-#include <cstdlib> // For rand() placeholder
+#include "../llm/sentence_boundary.h"
+#include "../tts/text_normalizer.h"
+#include <thread>
 
-DialogueController::DialogueController(LLMStream* l, LLMStream* m, PersonaState* p, TTSEngine* t)
-    : llm(l), monitorLLM(m), persona(p), tts(t), agentSpeaking(false), interruptConfidence(0.0f) {}
+DialogueController::DialogueController(LLMBackend* l, LLMBackend* m, PersonaState* p, TTSEngine* t, EventBus* b)
+    : llm(l), monitorLLM(m), persona(p), tts(t), bus(b), agentSpeaking(false), interruptConfidence(0.0f), activeTurns(0) {
+    if (!bus) return;
 
-void DialogueController::onUserSpeech(const std::string& text, bool whileAgentSpeaking, double asr_latency_ms) {
+    // Responses block for the whole LLM + TTS turn, so run them off the dispatcher thread
+    bus->subscribe(EventType::FinalTranscript, [this](const PipelineEvent& e) {
+        std::string text = e.text;
+        TraceId trace = e.trace_id;
+        std::shared_future<bool> check;
+        {
+            std::lock_guard<std::mutex> lock(bargeInMutex);
+            auto it = bargeInChecks.find(trace);
+            if (it != bargeInChecks.end()) {
+                check = it->second;
+                bargeInChecks.erase(it);
+            }
+        }
+        if (text.empty()) return; // The final pass found nothing after all (turn already dropped)
+        activeTurns++;
+        std::thread([this, text, trace, check]() {
+            PerfMonitor::getInstance().setThreadName("controller");
+            if (!check.valid()) onUserSpeech(text, agentSpeaking, trace);
+            else if (check.get()) respond(text, trace); // Already interrupted on the fast transcript
+            else PerfMonitor::getInstance().dropTurn(trace);
+            activeTurns--;
+        }).detach();
+    });
+    // Fast-tier transcript of speech over the agent: decide on the interrupt now,
+    // without waiting for the final transcript
+    bus->subscribe(EventType::PartialTranscript, [this](const PipelineEvent& e) {
+        if (!agentSpeaking) return; // Finished meanwhile; the final transcript is an ordinary turn
+        std::string text = e.text;
+        TraceId trace = e.trace_id;
+        auto decision = std::make_shared<std::promise<bool>>();
+        {
+            std::lock_guard<std::mutex> lock(bargeInMutex);
+            bargeInChecks[trace] = decision->get_future().share();
+        }
+        activeTurns++;
+        std::thread([this, text, trace, decision]() {
+            PerfMonitor::getInstance().setThreadName("controller");
+            bool stop = checkInterrupt(text, trace);
+            if (stop) handleInterrupt();
+            decision->set_value(stop);
+            activeTurns--;
+        }).detach();
+    });
+    bus->subscribe(EventType::Interrupt, [this](const PipelineEvent& e) {
+        handleInterrupt(e.timestamp);
+    });
+}
+
+void DialogueController::onUserSpeech(const std::string& text, bool whileAgentSpeaking, TraceId trace) {
     if (whileAgentSpeaking) {
-        std::cout << "[Parallel] Agent speaking. Checking input with Monitor LLM..." << std::endl;
-        
-        // Quick verify prompt for the Monitor LLM
-        std::string checkPrompt = "<|im_start|>system\nYou are a conversation manager. The user just said: \"" + text + "\" while the agent was speaking. Does this input require the agent to stop immediately or change topic? Answer only YES or NO.\nExamples:\nUser: \"Stop.\"\nAssistant: YES\nUser: \"Yeah.\"\nAssistant: NO\nUser: \"That's wrong.\"\nAssistant: YES\n<|im_end|>\n<|im_start|>assistant\n";
-        
-        std::string decision = "";
-        // Use the monitor LLM instance (parallel processing)
-        monitorLLM->generate(checkPrompt, [&](const std::string& token){
-            decision += token;
-        });
-        
-        std::cout << "[Parallel] Monitor Decision: " << decision << std::endl;
-
-        if (decision.find("YES") != std::string::npos || decision.find("Yes") != std::string::npos) {
+        if (checkInterrupt(text, trace)) {
              handleInterrupt();
              // Respond to the new text immediately after interrupting
-             respond(text, asr_latency_ms);
+             respond(text, trace);
         } else {
-             std::cout << "[Parallel] Ignoring interruption (Classified as Backchannel/Noise)." << std::endl;
+             PerfMonitor::getInstance().dropTurn(trace);
         }
     } else {
-        respond(text, asr_latency_ms);
+        respond(text, trace);
     }
 }
 
-void DialogueController::handleInterrupt() {
+bool DialogueController::checkInterrupt(const std::string& text, TraceId trace) {
+    auto& monitor = PerfMonitor::getInstance();
+    std::cout << "[Parallel] Agent speaking. Checking input with Monitor LLM..." << std::endl;
+    
+    // Quick verify prompt for the Monitor LLM
+    std::string checkPrompt = "<|im_start|>system\nYou are a conversation manager. The user just said: \"" + text + "\" while the agent was speaking. Does this input require the agent to stop immediately or change topic? Answer only YES or NO.\nExamples:\nUser: \"Stop.\"\nAssistant: YES\nUser: \"Yeah.\"\nAssistant: NO\nUser: \"That's wrong.\"\nAssistant: YES\n<|im_end|>\n<|im_start|>assistant\n";
+    
+    std::string decision = "";
+    // Use the monitor LLM instance (parallel processing)
+    Span check = monitor.startSpan(trace, "interrupt_check");
+    monitorLLM->generate(checkPrompt, [&](const std::string& token){
+        decision += token;
+    }, trace);
+    monitor.endSpan(check);
+    
+    std::cout << "[Parallel] Monitor Decision: " << decision << std::endl;
+
+    // No answer at all means the check was refused (shared engine too busy);
+    // real words over the agent are more likely an interruption than not
+    bool noDecision = decision.empty() && !monitorLLM->isAborted();
+    if (noDecision) std::cout << "[Parallel] No monitor decision, treating as interruption." << std::endl;
+
+    if (noDecision || decision.find("YES") != std::string::npos || decision.find("Yes") != std::string::npos) return true;
+    std::cout << "[Parallel] Ignoring interruption (Classified as Backchannel/Noise)." << std::endl;
+    return false;
+}
+
+void DialogueController::handleInterrupt(std::chrono::steady_clock::time_point requested) {
     llm->stop();
     tts->stop();
     agentSpeaking = false;
     interruptConfidence = 0.0f;
-    std::cout << "[Controller] Interrupt triggered!" << std::endl;
+
+    std::chrono::duration<double, std::milli> silence = std::chrono::steady_clock::now() - requested;
+    PerfMonitor::getInstance().recordLatency(LatencyMetric::InterruptToSilence, silence.count());
+    std::cout << "[Controller] Interrupt triggered! (" << silence.count() << " ms to silence)" << std::endl;
+}
+
+void DialogueController::clearHistory() {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    history.clear();
+    asrPrompt.clear();
+}
+
+std::string DialogueController::asrContext() const {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    return asrPrompt;
 }
 
-void DialogueController::respond(const std::string& userText, double asr_latency_ms) {
-    if(userText.empty()) return;
+void DialogueController::rebuildAsrContext() {
+    const size_t kUserTurns = 2;
+    const size_t kReplyChars = 200;
 
-    // Start Research Timers
+    asrPrompt.clear();
+    size_t first = history.size() > kUserTurns ? history.size() - kUserTurns : 0;
+    for (size_t i = first; i < history.size(); ++i) {
+        asrPrompt += history[i].first;
+        asrPrompt += ' ';
+    }
+    if (!history.empty()) {
+        // The end of the last reply is what the user is answering
+        const std::string& reply = history.back().second;
+        size_t start = reply.size() > kReplyChars ? reply.find(' ', reply.size() - kReplyChars) : 0;
+        asrPrompt += reply.substr(start == std::string::npos ? reply.size() - kReplyChars : start);
+    }
+    size_t end = asrPrompt.find_last_not_of(" \n");
+    asrPrompt.erase(end == std::string::npos ? 0 : end + 1);
+    size_t begin = asrPrompt.find_first_not_of(" \n");
+    asrPrompt.erase(0, begin == std::string::npos ? asrPrompt.size() : begin);
+}
+
+void DialogueController::respond(const std::string& userText, TraceId trace) {
     auto& monitor = PerfMonitor::getInstance();
-    monitor.startTimer("LLM_PRE"); // Time to First Token
+    if(userText.empty()) {
+        monitor.dropTurn(trace);
+        return;
+    }
+
+    // Research spans: llm -> prefill (until first token) -> first_sentence
+    Span llmSpan = monitor.startSpan(trace, "llm");
+    Span prefillSpan = monitor.startSpan(trace, "prefill", llmSpan.span_id);
 
     // 1. Build Prompt with History
     std::string prompt = "<|im_start|>system\n" + persona->promptInjection() + "<|im_end|>\n";
     
     // Add history (User/Assistant exchanges)
-    for (const auto& exchange : history) {
-        prompt += "<|im_start|>user\n" + exchange.first + "<|im_end|>\n";
-        prompt += "<|im_start|>assistant\n" + exchange.second + "<|im_end|>\n";
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        for (const auto& exchange : history) {
+            prompt += "<|im_start|>user\n" + exchange.first + "<|im_end|>\n";
+            prompt += "<|im_start|>assistant\n" + exchange.second + "<|im_end|>\n";
+        }
     }
 
     // Add current user prompt
     prompt += "<|im_start|>user\n" + userText + "<|im_end|>\n";
     prompt += "<|im_start|>assistant\n";
-    
+
+    // Long history or a hard question: cover the wait with a filler now, the
+    // response crossfades in over it when it's ready
+    auto respondStart = std::chrono::steady_clock::now();
+    LatencyPredictor::Features features = LatencyPredictor::features(userText, prompt.size());
+    double predictedMs = latencyPredictor.predictMs(features);
+    if (fillerThresholdMs > 0.0 && predictedMs > fillerThresholdMs && tts->playFiller()) {
+        monitor.mark(trace, "filler");
+        std::cout << "[Controller] Filler played (" << (int)predictedMs << " ms predicted)" << std::endl;
+    }
+
     agentSpeaking = true;
     llm->abort = false; // Reset abort flag for new response
     
     bool firstToken = true;
-    double ttft_ms = 0.0;
+    bool firstSentence = true;
+    double firstSentenceMs = 0.0; // respond() start to the first complete sentence, what the predictor learns
     int tokenCount = 0;
     
     std::cout << "[LLM] Generating..." << std::endl;
     std::string fullResponse;
+    // What Piper will read, normalized token by token as the response streams
+    // in: it is ready the moment generation ends
+    TextNormalizer normalizer;
+    std::string spoken;
+    spoken.reserve(1024);
+    SentenceBoundary sentences;
     
-    llm->generate(prompt, [this, &firstToken, &monitor, &ttft_ms, &tokenCount, &fullResponse](const std::string& token){
+    llm->generate(prompt, [&](const std::string& token){
         if (llm->isAborted()) return; // Fast exit callback
         if (firstToken) {
-            ttft_ms = monitor.stopTimer("LLM_PRE"); 
+            monitor.endSpan(prefillSpan);
+            monitor.mark(trace, "first_token", llmSpan.span_id);
             firstToken = false;
         }
         tokenCount++;
         std::cout << token << std::flush; // Visual stream
         fullResponse += token;
-    });
+        if (!normalizer.ended()) normalizer.push(token, spoken);
+        if (sentences.feed(token) && firstSentence) {
+            monitor.mark(trace, "first_sentence", llmSpan.span_id);
+            firstSentenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - respondStart).count();
+            firstSentence = false;
+        }
+        if (bus) bus->publish(EventType::TokenChunk, trace, token);
+    }, trace);
+    if (sentences.finish() && firstSentence && !llm->isAborted()) {
+        monitor.mark(trace, "first_sentence", llmSpan.span_id);
+        firstSentence = false;
+    }
+    // No boundary before the end: the whole reply is the first sentence
+    if (firstSentenceMs == 0.0) {
+        firstSentenceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - respondStart).count();
+    }
+    monitor.endSpan(llmSpan);
+    normalizer.finish(spoken);
     
     std::cout << "\n[LLM] Generation Done. Calling TTS..." << std::endl;
     
     // Save to history (even if aborted, we store what we got)
-    history.push_back({userText, fullResponse});
-    if (history.size() > maxHistory) {
-        history.erase(history.begin());
+    {
+        std::lock_guard<std::mutex> lock(historyMutex);
+        history.push_back({userText, fullResponse});
+        if (history.size() > maxHistory) {
+            history.erase(history.begin());
+        }
+        rebuildAsrContext();
     }
 
     
     // Check if we were interrupted during LLM generation
     if (llm->isAborted()) {
         std::cout << "[Controller] Aborted before TTS." << std::endl;
+        monitor.dropTurn(trace);
         agentSpeaking = false;
         return;
     }
 
-    // Total E2E is from "User stops" to "Agent starts audio"
-    double e2e_ms = monitor.stopTimer("E2E");
+    latencyPredictor.observe(features, firstSentenceMs);
+
+    // Total E2E is from "User stops" (turn origin) to "Agent starts audio"; the
+    // backend marks playback_start when its first sample goes out
+    monitor.mark(trace, "tts_request");
     
     // Speak full response for stability (one-shot pipe)
-    tts->speak(fullResponse);
+    if (bus) bus->publish(EventType::AudioStarted, trace, fullResponse);
+    {
+        ScopedSpan ttsSpan(trace, "tts");
+        tts->speak(spoken, trace, true);
+    }
     std::cout << "[TTS] Speak Done." << std::endl;
     
-    // Log final stats for this turn to CSV/Console
-    InteractionMetrics m;
-    m.turn_id = rand() % 10000;
-    m.vad_latency_ms = 0;
-    m.asr_latency_ms = asr_latency_ms;
-    m.llm_ttft_ms = ttft_ms;
-    m.tts_latency_ms = 0;
-    m.total_e2e_ms = e2e_ms;
-    m.token_count = tokenCount;
-    m.timestamp = ""; 
-    m.user_text = userText;
-    
-    monitor.logTurn(m); // Save to history
-    monitor.saveCSV();  // Auto-save logic
+    // Derive this turn's stats from its spans and log them to CSV/Console
+    monitor.finishTurn(trace, userText, tokenCount);
     
     agentSpeaking = false;
 }
@@ -2,34 +2,70 @@
 #define DIALOGUE_CONTROLLER_H
 
 #include <string>
-#include "../llm/llama_stream.h"
+#include "../llm/llm_backend.h"
 #include "../persona/persona_state.h"
 #include "../tts/tts_stream.h"
+#include "../utils/event_bus.h"
+#include "../utils/perf_monitor.h"
+#include "latency_predictor.h"
 
 #include <atomic>
-
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
 #include <vector>
 #include <utility>
 
 class DialogueController {
 public:
-    LLMStream* llm;
-    LLMStream* monitorLLM;
+    LLMBackend* llm;
+    LLMBackend* monitorLLM;
     PersonaState* persona;
     TTSEngine* tts;
+    EventBus* bus;
 
     std::atomic<bool> agentSpeaking;
     float interruptConfidence;
+    std::atomic<int> activeTurns; // Bus-started turns still running on their threads
+
+    // Dead air: when a turn is predicted to take longer than this before the
+    // response starts, a thinking filler plays right away (0 = never)
+    double fillerThresholdMs = 900.0;
+    LatencyPredictor latencyPredictor; // Learns from every answered turn
 
-    DialogueController(LLMStream* l, LLMStream* m, PersonaState* p, TTSEngine* t);
+    DialogueController(LLMBackend* l, LLMBackend* m, PersonaState* p, TTSEngine* t, EventBus* b = nullptr);
     
-    void onUserSpeech(const std::string& text, bool whileAgentSpeaking, double asr_latency_ms);
-    void handleInterrupt();
-    void respond(const std::string& userText, double asr_latency_ms);
+    void onUserSpeech(const std::string& text, bool whileAgentSpeaking, TraceId trace);
+    // Monitor LLM: should speech over the agent stop it? (false = backchannel / noise)
+    bool checkInterrupt(const std::string& text, TraceId trace);
+    // requested: when the barge-in was detected (for interrupt-to-silence latency)
+    void handleInterrupt(std::chrono::steady_clock::time_point requested = std::chrono::steady_clock::now());
+    void respond(const std::string& userText, TraceId trace);
+
+    // Forget the conversation so far (replay runs utterances independently)
+    void clearHistory();
+
+    // Recent user turns + the tail of the last reply, as an ASR prompt: the
+    // user's next words tend to reuse them. Rebuilt when history changes.
+    std::string asrContext() const;
+
+    // True once every bus-started turn has returned (safe to destroy)
+    bool idle() const { return activeTurns == 0; }
 
 private:
     std::vector<std::pair<std::string, std::string>> history;
     const size_t maxHistory = 5; // Keep last 5 exchanges
+    mutable std::mutex historyMutex; // Turns run on their own threads; ASR workers read the context
+    std::string asrPrompt;
+
+    void rebuildAsrContext(); // historyMutex held
+
+    // Speech over the agent may arrive twice: a fast-tier PartialTranscript that
+    // only decides the interrupt, then the FinalTranscript the turn is answered
+    // with. The decision waits here for it, keyed by trace.
+    std::map<TraceId, std::shared_future<bool>> bargeInChecks;
+    std::mutex bargeInMutex;
 };
 
 
@@ -0,0 +1,110 @@
+#include "endpointer.h"
+#include <algorithm>
+#include <cctype>
+
+Endpointer::Endpointer() : Endpointer(Config()) {}
+
+Endpointer::Endpointer(Config cfg) : config(cfg) {}
+
+void Endpointer::reset() {
+    in_pause = false;
+    pause_ms = 0.0;
+    pause_prob_sum = 0.0;
+    pause_frames = 0;
+    requested_at_ms = -1.0;
+    score = -1.0f;
+    pause_id++; // Invalidates scores still in flight
+}
+
+void Endpointer::onVoiced(float prob) {
+    (void)prob;
+    if (in_pause) reset(); // User kept talking: whatever was scored is stale
+}
+
+bool Endpointer::onSilence(float prob, double frame_ms) {
+    in_pause = true;
+    pause_ms += frame_ms;
+    pause_prob_sum += prob;
+    pause_frames++;
+
+    if (score < 0.0f && requested_at_ms >= 0.0) {
+        std::lock_guard<std::mutex> lock(pending_mtx);
+        if (pending_pause == pause_id && pending_score >= 0.0f && pause_ms >= requested_at_ms + pending_delay_ms) {
+            score = pending_score;
+        }
+    }
+    return pause_ms >= requiredSilenceMs();
+}
+
+bool Endpointer::takeScoreRequest() {
+    if (!in_pause || requested_at_ms >= 0.0 || pause_ms < config.score_after_ms) return false;
+    requested_at_ms = pause_ms;
+    return true;
+}
+
+void Endpointer::setCompletion(uint64_t pause, float s, double delay_ms) {
+    std::lock_guard<std::mutex> lock(pending_mtx);
+    pending_pause = pause;
+    pending_score = std::max(0.0f, std::min(1.0f, s));
+    pending_delay_ms = delay_ms;
+}
+
+double Endpointer::requiredSilenceMs() const {
+    double mean_prob = pause_frames > 0 ? pause_prob_sum / pause_frames : 0.0;
+    double wait = config.base_silence_ms;
+    if (score >= 0.0f) {
+        double t = (score - config.incomplete_score) / (config.complete_score - config.incomplete_score);
+        t = std::max(0.0, std::min(1.0, t));
+        wait = config.max_silence_ms + (config.min_silence_ms - config.max_silence_ms) * t;
+    } else if (mean_prob <= config.clean_prob) {
+        wait *= config.clean_factor; // Only a hint when the transcript has no say
+    }
+    if (mean_prob >= config.hesitation_prob) wait *= config.hesitation_factor;
+
+    return std::max(config.min_silence_ms, std::min(config.max_silence_ms, wait));
+}
+
+float Endpointer::completionScore(const std::string& text) {
+    size_t end = text.find_last_not_of(" \t\r\n");
+    if (end == std::string::npos) return 0.5f;
+
+    float s = 0.5f;
+    char last = text[end];
+    bool ellipsis = end >= 2 && text.compare(end - 2, 3, "...") == 0;
+    if (ellipsis || last == ',' || last == ';' || last == ':' || last == '-') s -= 0.35f;
+    // Whisper closes nearly every segment with a period, mid-thought ones too, so
+    // on its own that is only a hint; it has to agree with the words below
+    else if (last == '.' || last == '?' || last == '!') s += 0.15f;
+
+    // Last word, lowercased, without punctuation
+    std::string word;
+    for (size_t i = end + 1; i-- > 0;) {
+        unsigned char c = (unsigned char)text[i];
+        if (std::isalpha(c) || c == '\'') word.insert(word.begin(), (char)std::tolower(c));
+        else if (!word.empty()) break;
+    }
+    int words = 0;
+    bool in_word = false;
+    for (unsigned char c : text) {
+        bool alpha = std::isalnum(c) || c == '\'';
+        if (alpha && !in_word) words++;
+        in_word = alpha;
+    }
+
+    static const char* kContinues[] = {
+        "and", "but", "or", "so", "because", "if", "when", "while", "then", "than", "that", "which", "who",
+        "the", "a", "an", "my", "your", "our", "their", "his", "her", "its", "this", "these", "those",
+        "to", "of", "in", "on", "at", "for", "with", "from", "about", "like", "into", "is", "are", "was",
+        "were", "am", "be", "i", "we", "you", "they", "it's", "i'm", "um", "uh", "uhm", "er", "erm", "hmm"};
+    bool continues = false;
+    for (const char* w : kContinues) {
+        if (word == w) {
+            continues = true;
+            break;
+        }
+    }
+    if (continues) s -= 0.4f;
+    // A clause that ends on a content word; a lone "Okay." or "So." may well go on
+    else if (words >= 3) s += 0.1f;
+    return std::max(0.0f, std::min(1.0f, s));
+}
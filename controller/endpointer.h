@@ -0,0 +1,82 @@
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Decides when a pause ends the user's turn.
+//
+// Instead of a fixed silence timeout, the silence required adapts to:
+//   - a turn-completion score for what was said so far (partial transcript ->
+//     completionScore(), delivered asynchronously via setCompletion()),
+//   - the VAD probability during the pause (breaths / fillers keep it hovering
+//     below the threshold; a clean stop drops it to ~0),
+//   - the pause length itself.
+// Likely-complete utterances commit after min_silence_ms, mid-sentence pauses
+// wait up to max_silence_ms. Without any score it behaves like the old fixed
+// timeout, shortened a little for clean stops.
+class Endpointer {
+public:
+    struct Config {
+        double min_silence_ms = 160.0;   // Never commit faster than this
+        double base_silence_ms = 544.0;  // No completion score (the old 17 frames)
+        double max_silence_ms = 1200.0;  // Clearly mid-sentence
+        double score_after_ms = 64.0;    // Pause length worth asking for a score
+        float complete_score = 0.75f;    // At/above: commit at min_silence_ms
+        float incomplete_score = 0.3f;   // At/below: wait max_silence_ms
+        float clean_prob = 0.05f;        // Mean pause probability of a clean stop...
+        double clean_factor = 0.75;      // ...which shortens the wait by this
+        float hesitation_prob = 0.25f;   // Mean pause probability of breathing / "uhm"...
+        double hesitation_factor = 1.5;  // ...which lengthens it
+    };
+
+    Endpointer();
+    explicit Endpointer(Config config);
+
+    void reset();
+
+    // Per frame, while the user's turn is open
+    void onVoiced(float prob);
+    // True when the turn should end now
+    bool onSilence(float prob, double frame_ms);
+
+    // True once per pause, when the pause reached score_after_ms and a
+    // completion score for it would be used
+    bool takeScoreRequest();
+    // Identifies the current pause; scores for older pauses are ignored
+    uint64_t pauseId() const { return pause_id; }
+
+    // From any thread. delay_ms holds the score back until the pause is that much
+    // longer than when it was requested (replay: charges the scorer's own latency
+    // to the audio clock).
+    void setCompletion(uint64_t pause, float score, double delay_ms = 0.0);
+
+    double pauseMs() const { return pause_ms; }
+    float completion() const { return score; } // < 0 = unknown
+    double requiredSilenceMs() const;
+
+    // Cheap lexical turn-completion score for a (partial) transcript in [0, 1]:
+    // sentence-final punctuation after a clause of a few words scores high (the
+    // punctuation alone doesn't), trailing conjunctions / articles / fillers and
+    // trailing commas or ellipses score low.
+    static float completionScore(const std::string& text);
+
+private:
+    Config config;
+
+    uint64_t pause_id = 0;
+    bool in_pause = false;
+    double pause_ms = 0.0;
+    double pause_prob_sum = 0.0;
+    int pause_frames = 0;
+    double requested_at_ms = -1.0;
+    float score = -1.0f;
+
+    std::mutex pending_mtx;
+    uint64_t pending_pause = 0;
+    float pending_score = -1.0f;
+    double pending_delay_ms = 0.0;
+};
+
+#endif // ENDPOINTER_H
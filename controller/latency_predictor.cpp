@@ -0,0 +1,66 @@
+#include "latency_predictor.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+const double kForget = 0.95;   // Per observed turn
+const double kMinTurns = 2.5;  // Weighted count; three turns, after which the priors step aside
+const double kPriorMs[2] = {550.0, 1050.0};
+const double kPriorMsPerChar = 0.08; // Prefill on the 4060, roughly
+} // namespace
+
+LatencyPredictor::Features LatencyPredictor::features(const std::string& userText, size_t promptChars) {
+    Features f;
+    f.prompt_chars = promptChars;
+
+    std::string lower;
+    lower.reserve(userText.size() + 2);
+    lower += ' ';
+    bool inWord = false;
+    for (unsigned char c : userText) {
+        bool alnum = std::isalnum(c) || c == '\'';
+        if (alnum && !inWord) f.user_words++;
+        inWord = alnum;
+        lower += alnum ? (char)std::tolower(c) : ' ';
+    }
+    lower += ' ';
+
+    // Questions that need reasoning rather than a reflex
+    static const char* cues[] = {" why ", " how ", " explain ", " compare ", " difference ", " describe ",
+                                 " what if ", " should i ", " pros ", " tell me about "};
+    bool cue = false;
+    for (const char* c : cues) {
+        if (lower.find(c) != std::string::npos) {
+            cue = true;
+            break;
+        }
+    }
+    f.complex = f.user_words >= 14 || (cue && f.user_words >= 4);
+    return f;
+}
+
+double LatencyPredictor::predictMs(const Features& f) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    const Fit& fit = fits[f.complex ? 1 : 0];
+    double x = (double)f.prompt_chars;
+    if (fit.n < kMinTurns) return kPriorMs[f.complex ? 1 : 0] + kPriorMsPerChar * x;
+
+    double meanX = fit.sx / fit.n;
+    double meanY = fit.sy / fit.n;
+    double varX = fit.sxx / fit.n - meanX * meanX;
+    // Prompts all about the same length: no slope to speak of yet
+    double slope = varX > 1e3 ? (fit.sxy / fit.n - meanX * meanY) / varX : kPriorMsPerChar;
+    slope = std::max(0.0, slope);
+    return std::max(0.0, meanY + slope * (x - meanX));
+}
+
+void LatencyPredictor::observe(const Features& f, double ms) {
+    std::lock_guard<std::mutex> lock(mtx);
+    Fit& fit = fits[f.complex ? 1 : 0];
+    double x = (double)f.prompt_chars;
+    fit.n = fit.n * kForget + 1.0;
+    fit.sx = fit.sx * kForget + x;
+    fit.sy = fit.sy * kForget + ms;
+    fit.sxx = fit.sxx * kForget + x * x;
+    fit.sxy = fit.sxy * kForget + x * ms;
+}
@@ -0,0 +1,38 @@
+#ifndef LATENCY_PREDICTOR_H
+#define LATENCY_PREDICTOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+// Predicts how long a turn will take from the start of respond() to the first
+// complete sentence of the response (when speech can start), before the LLM has
+// seen the prompt. Latency is bimodal (see
+// the README): short commands are answered in a few hundred ms, complex
+// questions take over a second, and prefill grows with the prompt. So each mode
+// gets its own line, ms = a + b * prompt_chars, fitted online from recent turns
+// (older turns weigh less). Until a mode has seen a few turns, priors from the
+// benchmark numbers stand in.
+class LatencyPredictor {
+public:
+    struct Features {
+        size_t prompt_chars = 0;
+        size_t user_words = 0;
+        bool complex = false; // "Cognitive" question rather than a quick command
+    };
+
+    static Features features(const std::string& userText, size_t promptChars);
+
+    double predictMs(const Features& f) const;
+    void observe(const Features& f, double ms);
+
+private:
+    // Exponentially weighted least squares sums
+    struct Fit {
+        double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    };
+    Fit fits[2]; // Reflexive, complex
+    mutable std::mutex mtx;
+};
+
+#endif // LATENCY_PREDICTOR_H
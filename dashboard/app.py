@@ -1,37 +1,80 @@
 from flask import Flask, jsonify, send_from_directory
 from flask_cors import CORS
-import pandas as pd
+import json
 import os
+import threading
 
 app = Flask(__name__)
 CORS(app)
 
-CSV_PATH = os.path.join(os.path.dirname(__file__), "..", "benchmark_results.csv")
+ROOT = os.path.join(os.path.dirname(__file__), "..")
+JSONL_PATH = os.path.join(ROOT, "benchmark_results.jsonl")
+SUMMARY_PATH = os.path.join(ROOT, "latency_summary.json")
+MAX_ROWS = 500  # Only the most recent turns are charted
+
+# The agent appends one JSON line per turn; we only read what's new since the last poll
+_tail_lock = threading.Lock()
+_tail = {"offset": 0, "rows": []}
+
+
+def read_new_turns():
+    with _tail_lock:
+        if not os.path.exists(JSONL_PATH):
+            _tail["offset"], _tail["rows"] = 0, []
+            return list(_tail["rows"])
+
+        size = os.path.getsize(JSONL_PATH)
+        if size < _tail["offset"]:
+            # Agent restarted and truncated the log
+            _tail["offset"], _tail["rows"] = 0, []
+
+        with open(JSONL_PATH, "r", encoding="utf-8") as f:
+            f.seek(_tail["offset"])
+            while True:
+                line = f.readline()
+                if not line or not line.endswith("\n"):
+                    break  # Partial line still being written
+                _tail["offset"] = f.tell()
+                try:
+                    _tail["rows"].append(json.loads(line))
+                except ValueError:
+                    continue
+
+        del _tail["rows"][:-MAX_ROWS]
+        return list(_tail["rows"])
+
+
+def read_summary():
+    if not os.path.exists(SUMMARY_PATH):
+        return None
+    with open(SUMMARY_PATH, "r", encoding="utf-8") as f:
+        return json.load(f)
+
 
 @app.route('/api/metrics')
 def get_metrics():
-    if not os.path.exists(CSV_PATH):
-        return jsonify({"error": "CSV not found", "data": []})
-    
     try:
-        df = pd.read_csv(CSV_PATH)
-        # Handle cases where CSV is empty or being written
-        if df.empty:
-            return jsonify({"data": [], "stats": {}})
-        
-        # Calculate some P-values
+        rows = read_new_turns()
+        summary = read_summary()
+        if not rows or summary is None:
+            return jsonify({"data": rows, "stats": {}})
+
+        # Percentiles come from the agent's HDR histograms (all turns, not just MAX_ROWS)
+        m = summary["metrics"]
         stats = {
-            "p50_e2e": float(df['Total_E2E'].median()),
-            "p90_e2e": float(df['Total_E2E'].quantile(0.9)),
-            "avg_asr": float(df['ASR_Latency'].mean()),
-            "avg_llm": float(df['LLM_TTFT'].mean()),
-            "total_tokens": int(df['Tokens'].sum()),
-            "count": int(len(df))
+            "p50_e2e": m["e2e"]["p50"],
+            "p90_e2e": m["e2e"]["p90"],
+            "p99_e2e": m["e2e"]["p99"],
+            "avg_asr": m["asr"]["mean"],
+            "avg_llm": m["llm_ttft"]["mean"],
+            "total_tokens": int(sum(r.get("Tokens", 0) for r in rows)),
+            "count": summary["turns"]
         }
-        
+
         return jsonify({
-            "data": df.to_dict(orient='records'),
-            "stats": stats
+            "data": rows,
+            "stats": stats,
+            "percentiles": m
         })
     except Exception as e:
         return jsonify({"error": str(e), "data": []})
@@ -22,6 +22,9 @@ async def generate_audio():
     # Choose a neutral "Golden Speaker" (US Male/Female)
     VOICE = "en-US-GuyNeural" 
 
+    # Golden set for ASR checks: `voice_agent --transcribe test_audio/manifest.tsv`
+    manifest = []
+
     for category, utterances in suite.items():
         print(f"\n📂 Processing Category: {category}")
         cat_dir = os.path.join(output_dir, category)
@@ -52,9 +55,13 @@ async def generate_audio():
                 ], check=True, capture_output=True)
                 # Cleanup temp mp3
                 os.remove(temp_mp3)
+                manifest.append(f"{category}/{i}_{safe_name}.wav\t{text}")
             except Exception as e:
                 print(f"   ❌ Error converting {text}: {e}")
 
+    with open(os.path.join(output_dir, "manifest.tsv"), "w") as f:
+        f.write("\n".join(manifest) + "\n")
+
     print("\n✅ All 40 WAV files generated successfully!")
 
 if __name__ == "__main__":
@@ -2,8 +2,9 @@
 #include <iostream>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
-LLMStream::LLMStream(const std::string& model_path) : model(nullptr), ctx(nullptr), abort(false) {
+LLMStream::LLMStream(const std::string& model_path) : model(nullptr), ctx(nullptr) {
     llama_model_params model_params = llama_model_default_params();
     // Offload layers to GPU if compiled with CUBLAS
     model_params.n_gpu_layers = 99; 
@@ -24,27 +25,18 @@ LLMStream::~LLMStream() {
     if (model) llama_free_model(model);
 }
 
-void LLMStream::generate(const std::string& prompt, std::function<void(const std::string&)> token_callback) {
+void LLMStream::generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                              TraceId trace, const std::atomic<bool>& cancel) {
     if (!model || !ctx) return;
-    abort = false;
-    
-    // Clear KV cache to allow re-evaluating the full prompt from scratch
-    // This is necessary because DialogueController constructs the full prompt each time.
-    llama_memory_t mem = llama_get_memory(ctx);
-    llama_memory_clear(mem, true);
+    auto& monitor = PerfMonitor::getInstance();
 
     // 1. Get Vocab
     const llama_vocab* vocab = llama_model_get_vocab(model);
 
     // 2. Tokenize
-    std::vector<llama_token> tokens_list;
-    tokens_list.resize(prompt.size() + 1);
-    int n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), tokens_list.data(), tokens_list.size(), true, false);
-    if (n_tokens < 0) {
-        tokens_list.resize(-n_tokens);
-        n_tokens = llama_tokenize(vocab, prompt.c_str(), prompt.length(), tokens_list.data(), tokens_list.size(), true, false);
-    }
-    tokens_list.resize(n_tokens);
+    std::vector<llama_token> tokens_list = tokenize(prompt);
+    int n_tokens = (int)tokens_list.size();
+    if (n_tokens == 0) return;
 
     // 3. Prepare Batch
     // Allocate batch capability for context size to be safe (or at least n_tokens)
@@ -54,63 +46,27 @@ void LLMStream::generate(const std::string& prompt, std::function<void(const std
     llama_batch batch = llama_batch_init(n_batch_cap, 0, 1); // max tokens, embd, seqs
 
     // 4. Decode Prompt
-    // Fill batch manually
-    batch.n_tokens = n_tokens;
-    for(int i=0; i<n_tokens; i++) {
-        batch.token[i] = tokens_list[i];
-        batch.pos[i] = i;
-        batch.n_seq_id[i] = 1;
-        batch.seq_id[i][0] = 0;
-        batch.logits[i] = false; // logic: only last token needs logits?
-    }
-    batch.logits[n_tokens - 1] = true;
-
-    if (llama_decode(ctx, batch) != 0) {
+    // Only the part that differs from what's already cached (the system prompt
+    // and earlier history usually match the previous turn)
+    Span prompt_span = monitor.startSpan(trace, "prompt_decode");
+    bool prompt_ok = syncKV(tokens_list, batch, n_batch_cap);
+    monitor.endSpan(prompt_span);
+    if (!prompt_ok) {
         std::cerr << "Prompt decode failed" << std::endl;
         llama_batch_free(batch);
         return;
     }
 
     // 5. Generate Loop
-    int n_cur = n_tokens;
+    // tokens_list grows into prompt + generated, the sequence this call owns
     std::vector<llama_token> history_tokens;
     history_tokens.reserve(2048);
 
-    while (!abort && n_cur < n_batch_cap) { // Safety check
+    while (!cancel && (int)tokens_list.size() < n_batch_cap) { // Safety check
         auto* logits = llama_get_logits(ctx); // Logits from last decode
         int n_vocab = llama_n_vocab(vocab);
 
-        // Apply Repetition Penalty (Quick & Dirty implementation)
-        const float penalty = 1.2f; // Strong penalty to break loops
-        const int penalty_window = 64; 
-        
-        // Create a penalized copy of logits? No, modifying in place is fine for next step greedy 
-        // (but we are pointing to internal memory, so actually we should copy if we want to be safe, 
-        // AND we must be careful not to mess up internal state if we were doing beam search, but here we are single stream).
-        // Llama.cpp logits pointer is usually read-only or ephemeral per batch.
-        
-        // Let's Find max with penalty on the fly
-        llama_token new_token_id = 0;
-        float max_prob = -1e9;
-
-        for (int i=0; i<n_vocab; i++) {
-            float val = logits[i];
-            
-            // Check if token 'i' is in recent history
-            int start_idx = std::max(0, (int)history_tokens.size() - penalty_window);
-            for (int k = start_idx; k < history_tokens.size(); ++k) {
-                if (history_tokens[k] == i) {
-                    if (val > 0) val /= penalty;
-                    else val *= penalty;
-                    break; // Apply once
-                }
-            }
-            
-            if (val > max_prob) {
-                max_prob = val;
-                new_token_id = i;
-            }
-        }
+        llama_token new_token_id = samplePenalized(logits, n_vocab, history_tokens);
 
         // Output Text (Filter tags)
         char buf[256];
@@ -119,33 +75,92 @@ void LLMStream::generate(const std::string& prompt, std::function<void(const std
         
         // Stop Check (More aggressive)
         if (token_str == "</s>" || token_str.find("im_end") != std::string::npos || token_str.find("im_start") != std::string::npos || token_str == "<|endoftext|>") break;
-        if (n_cur > 2000) break;
+        if (tokens_list.size() > 2000) break;
 
         token_callback(token_str); // Only callback if not a stop token 
         history_tokens.push_back(new_token_id);
+        tokens_list.push_back(new_token_id);
 
-        // Decode Next Token
-        batch.n_tokens = 1;
-        batch.token[0] = new_token_id;
-        batch.pos[0] = n_cur;
-        batch.n_seq_id[0] = 1;
-        batch.seq_id[0][0] = 0;
-        batch.logits[0] = true; // We need logits for next generation
-
-        if (llama_decode(ctx, batch) != 0) {
+        // Decode Next Token (plus whatever another generation evicted meanwhile)
+        Span step_span = monitor.startSpan(trace, "decode_step");
+        bool step_ok = syncKV(tokens_list, batch, n_batch_cap);
+        monitor.endSpan(step_span);
+        if (!step_ok) {
              std::cerr << "Generate decode failed" << std::endl;
              break;
         }
-        n_cur++;
     }
     
     llama_batch_free(batch);
 }
 
-void LLMStream::stop() {
-    abort = true;
+bool LLMStream::syncKV(const std::vector<llama_token>& tokens, llama_batch& batch, int n_batch) {
+    size_t n_keep = 0;
+    while (n_keep < kv_tokens.size() && n_keep < tokens.size() && kv_tokens[n_keep] == tokens[n_keep]) n_keep++;
+    if (n_keep == tokens.size() && n_keep > 0) n_keep--; // Need fresh logits for the last token
+
+    llama_memory_t mem = llama_get_memory(ctx);
+    if (n_keep == 0) llama_memory_clear(mem, true);
+    else llama_memory_seq_rm(mem, 0, (llama_pos)n_keep, -1);
+    kv_tokens.resize(n_keep);
+
+    for (size_t pos = n_keep; pos < tokens.size();) {
+        int n = (int)std::min(tokens.size() - pos, (size_t)n_batch);
+        batch.n_tokens = n;
+        for (int i = 0; i < n; i++) {
+            batch.token[i] = tokens[pos + i];
+            batch.pos[i] = (llama_pos)(pos + i);
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = 0;
+            batch.logits[i] = false;
+        }
+        batch.logits[n - 1] = pos + n == tokens.size(); // Only the last token needs logits
+        if (llama_decode(ctx, batch) != 0) {
+            kv_tokens.clear(); // Unknown state, start over next time
+            return false;
+        }
+        kv_tokens.insert(kv_tokens.end(), tokens.begin() + pos, tokens.begin() + pos + n);
+        pos += n;
+    }
+    return true;
 }
 
-bool LLMStream::isAborted() const {
-    return abort;
+std::vector<llama_token> LLMStream::tokenize(const std::string& text) {
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    std::vector<llama_token> tokens_list(text.size() + 1);
+    int n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), tokens_list.data(), tokens_list.size(), true, false);
+    if (n_tokens < 0) {
+        tokens_list.resize(-n_tokens);
+        n_tokens = llama_tokenize(vocab, text.c_str(), text.length(), tokens_list.data(), tokens_list.size(), true, false);
+    }
+    tokens_list.resize(n_tokens < 0 ? 0 : n_tokens);
+    return tokens_list;
+}
+
+llama_token LLMStream::samplePenalized(const float* logits, int n_vocab, const std::vector<llama_token>& history,
+                                       float penalty, int penalty_window) {
+    // Apply Repetition Penalty (Quick & Dirty implementation)
+    // Logits pointer is read-only per batch, so find max with penalty on the fly
+    llama_token new_token_id = 0;
+    float max_prob = -1e9;
+    int start_idx = std::max(0, (int)history.size() - penalty_window);
+
+    for (int i=0; i<n_vocab; i++) {
+        float val = logits[i];
+
+        // Check if token 'i' is in recent history
+        for (int k = start_idx; k < (int)history.size(); ++k) {
+            if (history[k] == i) {
+                if (val > 0) val /= penalty;
+                else val *= penalty;
+                break; // Apply once
+            }
+        }
+
+        if (val > max_prob) {
+            max_prob = val;
+            new_token_id = i;
+        }
+    }
+    return new_token_id;
 }
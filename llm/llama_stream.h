@@ -2,24 +2,38 @@
 #define LLAMA_STREAM_H
 
 #include "llama.h"
+#include "llm_backend.h"
+#include "../utils/perf_monitor.h"
 #include <string>
 #include <functional>
 #include <vector>
 
-#include <atomic>
-
-class LLMStream {
+class LLMStream : public LLMBackend {
 public:
     llama_model* model;
     llama_context* ctx;
-    std::atomic<bool> abort;
 
     LLMStream(const std::string& model_path);
     ~LLMStream();
 
-    void generate(const std::string& prompt, std::function<void(const std::string&)> token_callback);
-    void stop();
-    bool isAborted() const;
+    // trace: PerfMonitor turn the prompt/decode step spans belong to (0 = none)
+    void generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                       TraceId trace, const std::atomic<bool>& cancel) override;
+
+    std::vector<llama_token> tokenize(const std::string& text);
+
+    // Greedy pick with a repetition penalty over the recent tokens
+    static llama_token samplePenalized(const float* logits, int n_vocab,
+                                       const std::vector<llama_token>& history,
+                                       float penalty = 1.2f, int window = 64);
+
+private:
+    std::vector<llama_token> kv_tokens; // What the KV cache (seq 0) currently holds
+
+    // Makes the KV cache hold exactly `tokens`, decoding only what differs from
+    // kv_tokens, and leaves logits for the last one. After a generation was
+    // preempted by another one on this context, this re-decodes the diverged tail.
+    bool syncKV(const std::vector<llama_token>& tokens, llama_batch& batch, int n_batch);
 };
 
 #endif // LLAMA_STREAM_H
@@ -0,0 +1,36 @@
+#ifndef LLM_BACKEND_H
+#define LLM_BACKEND_H
+
+#include "../utils/perf_monitor.h"
+#include <atomic>
+#include <functional>
+#include <string>
+
+// Streaming text generator used by DialogueController.
+// LLMStream is the real one (llama.cpp); MockLLM stands in for load tests.
+class LLMBackend {
+public:
+    std::atomic<bool> abort;
+
+    LLMBackend() : abort(false) {}
+    virtual ~LLMBackend() = default;
+
+    // Blocks until generation ends; token_callback runs on the calling thread.
+    // trace: PerfMonitor turn the prompt/decode step spans belong to (0 = none)
+    void generate(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                  TraceId trace = 0) {
+        abort = false;
+        generateUntil(prompt, std::move(token_callback), trace, abort);
+    }
+
+    // Same, but stops on `cancel` instead of this backend's abort flag. Keeps no
+    // per-call state on the backend, so a scheduler may run other generations
+    // from inside token_callback (decode-step preemption, see server/engine_scheduler.h).
+    virtual void generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                               TraceId trace, const std::atomic<bool>& cancel) = 0;
+
+    void stop() { abort = true; }
+    bool isAborted() const { return abort; }
+};
+
+#endif // LLM_BACKEND_H
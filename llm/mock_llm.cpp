@@ -0,0 +1,32 @@
+#include "mock_llm.h"
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+MockLLM::MockLLM(const std::string& response, double ttft, double tps)
+    : ttft_ms(ttft), tokens_per_second(tps > 0.0 ? tps : 1.0) {
+    // One "token" per word, with the leading space like a BPE piece
+    std::istringstream words(response);
+    std::string word;
+    while (words >> word) tokens.push_back(tokens.empty() ? word : " " + word);
+}
+
+void MockLLM::generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                            TraceId trace, const std::atomic<bool>& cancel) {
+    (void)prompt;
+    auto& monitor = PerfMonitor::getInstance();
+
+    Span prompt_span = monitor.startSpan(trace, "prompt_decode");
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(ttft_ms * 1000.0)));
+    monitor.endSpan(prompt_span);
+
+    auto step = std::chrono::microseconds((int64_t)(1e6 / tokens_per_second));
+    for (const std::string& token : tokens) {
+        if (cancel) break;
+        token_callback(token);
+
+        Span step_span = monitor.startSpan(trace, "decode_step");
+        std::this_thread::sleep_for(step);
+        monitor.endSpan(step_span);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef MOCK_LLM_H
+#define MOCK_LLM_H
+
+#include "llm_backend.h"
+#include <string>
+#include <vector>
+
+// Stand-in for LLMStream: "prefills" for ttft_ms, then streams the canned
+// response word by word at tokens_per_second. Records the same prompt_decode /
+// decode_step spans and honors abort like the real model.
+class MockLLM : public LLMBackend {
+public:
+    MockLLM(const std::string& response, double ttft_ms = 200.0, double tokens_per_second = 30.0);
+
+    void generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                       TraceId trace, const std::atomic<bool>& cancel) override;
+
+private:
+    std::vector<std::string> tokens;
+    double ttft_ms;
+    double tokens_per_second;
+};
+
+#endif // MOCK_LLM_H
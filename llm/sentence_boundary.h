@@ -0,0 +1,65 @@
+#ifndef SENTENCE_BOUNDARY_H
+#define SENTENCE_BOUNDARY_H
+
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Finds sentence ends in a token stream. '.', '!' or '?' only ends a sentence
+// when whitespace (or the end of the stream) follows, so "3.5", "example.com"
+// and "...!?" mid-token don't count, and never after a title like "Dr." or a
+// single initial. Closing quotes and brackets may sit in between ('."' + ' ').
+// The character after the punctuation is often in the next token, so this
+// keeps a little state; one per stream.
+class SentenceBoundary {
+public:
+    // True if a sentence ended inside (or right before) this token
+    bool feed(const std::string& token) {
+        bool ended = false;
+        for (char ch : token) {
+            unsigned char c = (unsigned char)ch;
+            if (std::isspace(c)) {
+                if (pending) ended = true;
+                pending = false;
+                word_len = 0;
+                continue;
+            }
+            if (c == '.' || c == '!' || c == '?') {
+                pending = c != '.' || !abbreviation();
+            } else if (pending && (c == '"' || c == '\'' || c == ')' || c == ']')) {
+                // Still pending: closing punctuation after the end
+            } else {
+                pending = false;
+            }
+            if (word_len < sizeof(word)) word[word_len] = (char)std::tolower(c);
+            if (word_len <= sizeof(word)) word_len++;
+        }
+        return ended;
+    }
+
+    // End of stream: true if the text ended on a sentence end
+    bool finish() {
+        bool ended = pending;
+        pending = false;
+        word_len = 0;
+        return ended;
+    }
+
+private:
+    char word[5] = {};   // Start of the current word, lowercased
+    size_t word_len = 0; // Characters in the current word (capped past the buffer)
+    bool pending = false;
+
+    bool abbreviation() const {
+        if (word_len == 1) return std::isalpha((unsigned char)word[0]) != 0; // "J. Smith"
+        if (word_len <= sizeof(word) && std::memchr(word, '.', word_len)) return true; // "e.g.", "U.S."
+        static const char* titles[] = {"dr", "mr", "mrs", "ms", "prof", "st", "vs", "jr", "sr"};
+        for (const char* t : titles) {
+            if (std::strlen(t) == word_len && std::memcmp(t, word, word_len) == 0) return true;
+        }
+        return false;
+    }
+};
+
+#endif // SENTENCE_BOUNDARY_H
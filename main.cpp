@@ -1,13 +1,24 @@
 #include <windows.h> // For SetConsoleOutputCP
 #include "audio/mic_stream.h"
+#include "audio/playback_buffer.h"
+#include "audio/echo_canceller.h"
 #include "audio/vad.h"
+#include "audio/overlap_classifier.h"
 #include "persona/persona_state.h"
 #include "llm/llama_stream.h"
 #include "asr/whisper_stream.h" 
+#include "asr/whisper_tiers.h"
 #include "tts/tts_stream.h"
 #include "controller/dialogue_controller.h"
+#include "controller/audio_pipeline.h"
 #include "utils/perf_monitor.h"
+#include "utils/event_bus.h"
+#include "utils/metrics_server.h"
+#include "server/voice_server.h"
+#include "asr/batch_transcriber.h"
 #include <queue>
+#include <map>
+#include <sstream>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
@@ -15,138 +26,194 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <fstream>
 #include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
 
-// Thread-safe queue for audio chunks
-std::queue<std::vector<int16_t>> audio_queue;
+// One PortAudio callback's worth of audio: the mic block and what the speaker
+// played meanwhile (empty without in-process playback)
+struct CapturedBlock {
+    std::vector<int16_t> mic;
+    std::vector<int16_t> ref;
+};
+
+// Thread-safe queue for audio chunks (PortAudio callback -> processing_thread only)
+std::queue<CapturedBlock> audio_queue;
 std::mutex queue_mutex;
 std::condition_variable queue_cv;
 std::atomic<bool> running(true);
 
-// Global flag for response thread management
-std::atomic<bool> response_in_progress(false);
+// Set by the stdin test commands: microphone input is ignored while automation runs
 std::atomic<bool> test_mode_active(false);
 
-void processing_thread(VAD* vad, WhisperASR* asr, DialogueController* controller) {
-    std::vector<int16_t> audio_buffer;
-    bool is_speaking = false;
-    int silence_frames = 0;
+void processing_thread(VAD* vad, WhisperTiers* asr, DialogueController* controller, EventBus* bus, EchoCanceller* aec,
+                       const OverlapClassifier* overlap, MicrophoneStream* mic) {
     auto& monitor = PerfMonitor::getInstance();
+    monitor.setThreadName("processing_thread");
+
+    AudioPipeline::Config config;
+    // With the echo cancelled the agent's own voice no longer trips the VAD,
+    // so barge-in only needs the segmenter's onset (two frames)
+    if (aec) config.interrupt_ms = 64.0;
 
-    // Interruption state
-    int interrupt_frames = 0;
+    AudioPipeline pipeline(vad, controller, bus, [asr, bus, controller, &monitor](TraceId trace, std::vector<int16_t> utterance) {
+        // ASR worker: transcribes (prompted with the conversation so far) and
+        // hands the result to the controller via the bus. Speech over the agent
+        // only has to be told apart from a backchannel, so the fast tier hears it
+        // first for the interrupt check; the turn itself is answered from the
+        // Final tier's transcript.
+        bool bargeIn = controller->agentSpeaking &&
+                       asr->model(WhisperTiers::Use::BargeIn) != asr->model(WhisperTiers::Use::Final);
+        std::thread([asr, bus, trace, bargeIn, &monitor](std::vector<int16_t> audio, std::string context) {
+            monitor.setThreadName("asr_worker");
+            double asr_ms = 0.0;
+            if (bargeIn) {
+                std::string quick = AudioPipeline::transcribeUtterance(asr->backend(WhisperTiers::Use::BargeIn), audio,
+                                                                       trace, &asr_ms, context, "asr_barge_in");
+                if (quick.empty()) return;
+                bus->publish(EventType::PartialTranscript, trace, quick, asr_ms);
+            }
+            std::string text = AudioPipeline::transcribeUtterance(asr->backend(WhisperTiers::Use::Final), audio, trace,
+                                                                  &asr_ms, context);
+            if (text.empty() && !bargeIn) return; // Empty after a quick pass: releases the pending check
+            bus->publish(EventType::FinalTranscript, trace, text, asr_ms);
+        }, std::move(utterance), controller->asrContext()).detach();
+    }, config);
+    pipeline.setOverlapClassifier(overlap);
 
-    // Backchanneling state
-    auto last_backchannel_time = std::chrono::steady_clock::now();
-    int speech_chunk_count = 0;
+    // End-of-turn scoring: transcribe what was said so far at the start of each
+    // pause, so a finished sentence can be committed without the full timeout.
+    // Only on a tier of its own: on the Final model a partial decode would hold
+    // it while the endpoint fires, and the real transcript would queue behind it.
+    std::atomic<bool> partial_busy(false);
+    pipeline.setPartialHandler([asr, &pipeline, &partial_busy](uint64_t pause_id, std::vector<int16_t> audio) {
+        if (asr->model(WhisperTiers::Use::Partial) == asr->model(WhisperTiers::Use::Final)) return;
+        if (partial_busy.exchange(true)) return; // Previous pause still scoring
+        std::thread([asr, &pipeline, &partial_busy, pause_id](std::vector<int16_t> audio) {
+            PerfMonitor::getInstance().setThreadName("asr_partial");
+            pipeline.setTurnCompletion(pause_id, AudioPipeline::scoreCompletion(asr->backend(WhisperTiers::Use::Partial), audio));
+            partial_busy = false;
+        }, std::move(audio)).detach();
+    });
 
     while (running) {
-        std::vector<int16_t> chunk;
+        CapturedBlock block;
         {
             std::unique_lock<std::mutex> lock(queue_mutex);
             queue_cv.wait(lock, [] { return !audio_queue.empty() || !running; });
             if (!running && audio_queue.empty()) break;
-            chunk = std::move(audio_queue.front());
+            block = std::move(audio_queue.front());
             audio_queue.pop();
         }
+        mic->drainTrace(); // The callback's own spans, emitted here
 
-        if (test_mode_active) {
-            // Ignore microphone while automation is running
-            {
-                std::lock_guard<std::mutex> lock(queue_mutex);
-                while(!audio_queue.empty()) audio_queue.pop();
-            }
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
+        // Ignore microphone while automation is running
+        if (test_mode_active) continue;
 
-        bool vad_active = vad->isSpeech(chunk.data(), (int)chunk.size());
-
-        // FULL DUPLEX 1: Interruption (with debounce to avoid echo trigger)
-        if (controller->agentSpeaking) {
-            if (vad_active) {
-                interrupt_frames++;
-                if (interrupt_frames > 8) { // ~250ms of sustained sound
-                    std::cout << "\n[INTERRUPT] User speech detected while agent speaking!" << std::endl;
-                    controller->handleInterrupt();
-                    is_speaking = true;
-                    audio_buffer.clear();
-                    audio_buffer.insert(audio_buffer.end(), chunk.begin(), chunk.end());
-                    silence_frames = 0;
-                    interrupt_frames = 0;
-                    continue; 
-                }
-            } else {
-                interrupt_frames = 0;
-            }
-        } else {
-            interrupt_frames = 0;
+        // Remove the agent's own voice before the VAD sees the frame
+        if (aec && block.ref.size() == block.mic.size()) {
+            ScopedSpan aec_span(0, "aec");
+            aec->process(block.mic.data(), block.ref.data(), block.mic.data(), block.mic.size());
         }
-        
-        if (vad_active) {
-            if (!is_speaking) {
-                std::cout << "\n[User detected]: " << std::flush;
-                is_speaking = true;
-                audio_buffer.clear();
-                speech_chunk_count = 0;
-                last_backchannel_time = std::chrono::steady_clock::now();
-            }
-            audio_buffer.insert(audio_buffer.end(), chunk.begin(), chunk.end());
-            silence_frames = 0;
-            std::cout << "." << std::flush;
-
-            // FULL DUPLEX 2: Backchanneling
-            // If user speaks for > 4 seconds, throw in an "uh-huh" or "yeah"
-            speech_chunk_count++;
-            auto now = std::chrono::steady_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_backchannel_time).count();
-            
-            if (speech_chunk_count > 120 && duration > 4) { // 120 chunks * 32ms ~= 3.8s
-                std::cout << "\n[Backchanneling...]" << std::flush;
-                controller->tts->playBackchannel("generic");
-                last_backchannel_time = std::chrono::steady_clock::now();
-            }
+        pipeline.processFrame(block.mic);
+    }
+    if (aec) std::cout << "[AEC] ERLE " << aec->erleDb() << " dB" << std::endl;
+    while (partial_busy) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
 
-        } else {
-            if (is_speaking) {
-                silence_frames++;
-                // 17 frames ~= 500ms
-                if (silence_frames > 17) {
-                    std::cout << " [Processing...]" << std::endl;
-                    
-                    monitor.startTimer("E2E");
-                    monitor.startTimer("ASR");
-                    
-                    std::vector<int16_t> buffer_copy = audio_buffer;
-                    
-                    std::thread([asr, controller, buffer_copy, &monitor](){
-                        // if (response_in_progress) return; // PARALLEL FLOW: Allow processing
-                        response_in_progress = true;
-
-                        asr->transcribe(buffer_copy, [&](const std::string& text){
-                            double asr_ms = monitor.stopTimer("ASR");
-                            if (text.empty()) return;
-                            if (text == "[BLANK_AUDIO]" || text == "[Silence]" || text.find("(Video Ad)") != std::string::npos) return;
-                            
-                            std::cout << "User: " << text << " (ASR: " << asr_ms << "ms)" << std::endl;
-                            controller->onUserSpeech(text, controller->agentSpeaking, asr_ms);
-                        });
-
-                        {
-                            std::lock_guard<std::mutex> lock(queue_mutex);
-                            while(!audio_queue.empty()) audio_queue.pop();
-                        }
-                        
-                        response_in_progress = false;
-                    }).detach();
-
-                    is_speaking = false;
-                    audio_buffer.clear();
-                    silence_frames = 0;
-                }
-            }
+// Server mode: no microphone; sessions connect over TCP and share one set of engines
+int run_server(const std::string& host, int port, int maxSessions, WhisperTiers& whisper,
+               const OverlapClassifier* overlap, ResponseCache* ttsCache) {
+    VAD vad(L"models/silero_vad.onnx");
+    std::string modelPath = "models/qwen2.5-3b-instruct-q4_k_m.gguf";
+    LLMStream llm(modelPath);
+    LLMStream monitorLLM(modelPath);
+    SimpleTTS piper;
+
+    // One scheduler per device queue: each Whisper tier, and both LLM contexts together
+    EngineScheduler asrScheduler("asr");
+    EngineScheduler fastAsrScheduler("asr_fast");
+    EngineScheduler llmScheduler("llm");
+    SharedASR asr(whisper.backend(WhisperTiers::Use::Final), &asrScheduler);
+    SharedASR fastAsr(whisper.backend(WhisperTiers::Use::BargeIn), &fastAsrScheduler);
+    SharedLLM sharedLLM(&llm, &llmScheduler);
+    SharedLLM sharedMonitor(&monitorLLM, &llmScheduler);
+
+    // Sessions are wired to the routing at startup (tiers can still be reloaded)
+    WhisperTiers::Routing route = whisper.routing();
+    bool splitTiers = route.barge_in != route.final_tier && whisper.loaded(route.barge_in);
+
+    ServerEngines engines;
+    engines.vad_model = &vad;
+    engines.overlap = overlap;
+    engines.asr = &asr;
+    engines.asr_barge_in = splitTiers ? &fastAsr : nullptr;
+    engines.asr_partial = splitTiers && route.partial == route.barge_in ? &fastAsr : nullptr;
+    engines.llm = &sharedLLM;
+    engines.monitor_llm = &sharedMonitor;
+    engines.tts = &piper;
+    engines.tts_cache = ttsCache;
+
+    VoiceServer server(engines, host, port, maxSessions);
+    if (!server.start()) return 1;
+
+    std::cout << "[System] Server mode. Type 'quit' to stop." << std::endl;
+    std::string input;
+    while (std::getline(std::cin, input)) {
+        if (input == "quit") break;
+        if (input == "sessions") {
+            std::cout << "[Server] " << server.activeSessions() << " active sessions" << std::endl;
+            std::cout << "[Scheduler] " << asrScheduler.statsLine() << std::endl;
+            if (splitTiers) std::cout << "[Scheduler] " << fastAsrScheduler.statsLine() << std::endl;
+            std::cout << "[Scheduler] " << llmScheduler.statsLine() << std::endl;
+            if (ttsCache) std::cout << "[TTS] " << ttsCache->statsLine() << std::endl;
         }
     }
+    server.stop();
+    PerfMonitor::getInstance().printPercentiles();
+    return 0;
+}
+
+// Batch mode: transcribe a directory or manifest of files and exit (no mic, no LLM)
+int run_transcribe(const std::string& input, const std::string& outPath, BatchTranscriber::Config config,
+                   const WhisperASR::Config& asrConfig) {
+    std::vector<BatchTranscriber::Item> items;
+    if (!BatchTranscriber::collect(input, items)) return 1;
+    if (items.empty()) {
+        std::cerr << "[Batch] No audio files in " << input << std::endl;
+        return 1;
+    }
+
+    WhisperASR whisper("models/ggml-medium.en-q5_0.bin", asrConfig);
+    if (!whisper.ctx) return 1;
+    BatchTranscriber batch(&whisper, config);
+
+    std::ofstream out(outPath, std::ios::trunc);
+    size_t done = 0, failed = 0;
+    double audio_s = 0.0;
+    long long errors = 0, ref_words = 0;
+    auto start = std::chrono::steady_clock::now();
+    batch.run(items, [&](const BatchTranscriber::Result& r) {
+        out << BatchTranscriber::resultJson(r) << "\n";
+        done++;
+        if (!r.ok) failed++;
+        audio_s += r.audio_s;
+        errors += r.word_errors;
+        ref_words += r.ref_words;
+        if (done % 50 == 0 || done == items.size()) {
+            std::cout << "[Batch] " << done << "/" << items.size() << std::endl;
+        }
+    });
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    failed += items.size() - std::min(done, items.size()); // Never reported counts as failed
+
+    std::cout << "[Batch] " << done << " files (" << failed << " failed), " << audio_s << " s audio in "
+              << wall_s << " s (" << (wall_s > 0 ? audio_s / wall_s : 0.0) << "x real time)";
+    if (ref_words > 0) std::cout << ", WER " << 100.0 * errors / ref_words << "%";
+    std::cout << " -> " << outPath << std::endl;
+    return failed == 0 ? 0 : 2;
 }
 
 // Suppress Llama logs
@@ -164,7 +231,118 @@ int main(int argc, char** argv) {
 
     std::cout << "Starting Voice Agent (Press Ctrl+C to stop)..." << std::endl;
 
+    // --trace [file]: stream a Chrome/Perfetto trace of every pipeline span
+    // --metrics-port N / --metrics-host ADDR: embedded /metrics + /events server (port 0 disables)
+    // --server [port], --server-host ADDR, --max-sessions N: multi-session socket server instead of the mic
+    // --transcribe DIR|MANIFEST [--transcribe-out FILE] [--workers N] [--threads N] [--no-pack]: batch ASR, then exit
+    // --no-trim: full 30 s Whisper encoder window for every utterance
+    // --asr-tier NAME=MODEL (repeatable): load a Whisper tier ("medium" and, if present, "tiny" by default)
+    // --asr-route final=T,barge_in=T,partial=T: which tier serves which use
+    // --no-overlap-classifier: speech over the agent always goes through ASR + the monitor LLM
+    // --tts-cache DIR / --no-tts-cache: where repeated responses' audio is kept (or don't cache)
+    // --no-aec: play through ffplay without echo cancellation (long barge-in debounce instead)
+    std::string metricsHost = "127.0.0.1";
+    int metricsPort = 9464;
+    std::string serverHost = "127.0.0.1";
+    int serverPort = 0;
+    int maxSessions = 64;
+    bool useAec = true;
+    std::string transcribeInput;
+    std::string transcribeOut = "transcripts.jsonl";
+    BatchTranscriber::Config batchConfig;
+    WhisperASR::Config asrConfig;
+    std::map<std::string, std::string> asrTiers = {{"medium", "models/ggml-medium.en-q5_0.bin"}};
+    const std::string tinyPath = "models/ggml-tiny.en-q5_1.bin";
+    if (std::ifstream(tinyPath).good()) asrTiers["tiny"] = tinyPath;
+    WhisperTiers::Routing asrRouting;
+    bool useOverlapClassifier = true;
+    bool useTtsCache = true;
+    ResponseCache::Config ttsCacheConfig;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--trace") {
+            std::string tracePath = "pipeline_trace.json";
+            if (i + 1 < argc && argv[i + 1][0] != '-') tracePath = argv[++i];
+            PerfMonitor::getInstance().startTraceExport(tracePath);
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            metricsPort = std::atoi(argv[++i]);
+        } else if (arg == "--metrics-host" && i + 1 < argc) {
+            metricsHost = argv[++i];
+        } else if (arg == "--server") {
+            serverPort = 9470;
+            if (i + 1 < argc && argv[i + 1][0] != '-') serverPort = std::atoi(argv[++i]);
+        } else if (arg == "--server-host" && i + 1 < argc) {
+            serverHost = argv[++i];
+        } else if (arg == "--max-sessions" && i + 1 < argc) {
+            maxSessions = std::atoi(argv[++i]);
+        } else if (arg == "--no-aec") {
+            useAec = false;
+        } else if (arg == "--transcribe" && i + 1 < argc) {
+            transcribeInput = argv[++i];
+        } else if (arg == "--transcribe-out" && i + 1 < argc) {
+            transcribeOut = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            batchConfig.workers = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            batchConfig.threads_per_worker = std::atoi(argv[++i]);
+        } else if (arg == "--no-pack") {
+            batchConfig.pack = false;
+        } else if (arg == "--no-trim") {
+            asrConfig.trim_audio_ctx = false;
+        } else if (arg == "--asr-tier" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq != std::string::npos) asrTiers[spec.substr(0, eq)] = spec.substr(eq + 1);
+        } else if (arg == "--no-overlap-classifier") {
+            useOverlapClassifier = false;
+        } else if (arg == "--tts-cache" && i + 1 < argc) {
+            ttsCacheConfig.dir = argv[++i];
+        } else if (arg == "--no-tts-cache") {
+            useTtsCache = false;
+        } else if (arg == "--asr-route" && i + 1 < argc) {
+            if (!asrRouting.parse(argv[++i])) std::cerr << "[ASR] Bad --asr-route, using defaults" << std::endl;
+        }
+    }
+    MetricsServer metricsServer(metricsHost, metricsPort);
+    if (metricsPort > 0) metricsServer.start();
+    PerfMonitor::getInstance().setThreadName("main_stdin");
+
+    if (!transcribeInput.empty()) {
+        int rc = run_transcribe(transcribeInput, transcribeOut, batchConfig, asrConfig);
+        PerfMonitor::getInstance().stopTraceExport();
+        metricsServer.stop();
+        return rc;
+    }
+
+    WhisperTiers asr(asrConfig, asrRouting);
+    for (const auto& tier : asrTiers) asr.load(tier.first, tier.second);
+    std::cout << "[ASR] Routing: " << asr.describeRouting() << std::endl;
+
+    // Interrupt vs. backchannel straight from the audio; optional model
+    std::unique_ptr<OverlapClassifier> overlap;
+    const std::string overlapPath = "models/overlap_classifier.onnx";
+    if (useOverlapClassifier && std::ifstream(overlapPath).good()) {
+        overlap.reset(new OverlapClassifier(std::wstring(overlapPath.begin(), overlapPath.end())));
+        std::cout << "[Overlap] Classifier " << (overlap->loaded() ? "loaded" : "failed to load")
+                  << ", barge-ins decided from audio" << std::endl;
+    }
+
+    // Synthesized responses, reused whenever the agent says the same thing again
+    std::unique_ptr<ResponseCache> ttsCache;
+    if (useTtsCache) ttsCache.reset(new ResponseCache(ttsCacheConfig));
+
+    if (serverPort > 0) {
+        int rc = run_server(serverHost, serverPort, maxSessions, asr, overlap.get(), ttsCache.get());
+        PerfMonitor::getInstance().stopTraceExport();
+        metricsServer.stop();
+        return rc;
+    }
+
     VAD vad(L"models/silero_vad.onnx"); 
+    // Speaker output shares the mic's duplex stream so the echo canceller gets
+    // the exact playback signal, callback-aligned with the capture. Declared
+    // first: the audio callback reads it until the stream is closed.
+    PlaybackBuffer playback(16000 * 2);
     MicrophoneStream mic(16000, 512); 
     PersonaState persona;
     
@@ -172,25 +350,46 @@ int main(int argc, char** argv) {
     LLMStream llm(modelPath);
     std::cout << "[Init] Loading secondary Monitor LLM for parallel processing..." << std::endl;
     LLMStream monitorLLM(modelPath); // Second instance for Full Duplex Listening
-    
-    WhisperASR asr("models/ggml-medium.en-q5_0.bin");
-    TTSEngine tts;
-    DialogueController controller(&llm, &monitorLLM, &persona, &tts);
 
-    std::thread worker(processing_thread, &vad, &asr, &controller);
-    
-    mic.start_stream([&](const std::vector<int16_t>& audio_chunk){
+
+    SimpleTTS* piper = new SimpleTTS();
+    if (useAec) {
+        piper->setPlaybackOutput(&playback);
+        mic.setPlayback(&playback);
+        piper->loadClips("tts_clips"); // Backchannels start on the next audio callback
+    }
+    TTSEngine tts(piper);
+    tts.setCache(ttsCache.get());
+    EventBus bus;
+    DialogueController controller(&llm, &monitorLLM, &persona, &tts, &bus);
+    bus.start();
+
+    mic.start_stream([&](const std::vector<int16_t>& audio_chunk, const std::vector<int16_t>& ref){
         {
             std::lock_guard<std::mutex> lock(queue_mutex);
-            audio_queue.push(audio_chunk);
+            audio_queue.push({audio_chunk, ref});
         }
         queue_cv.notify_one();
     });
 
+    // Reference delay: the stream's round trip minus a frame, so the filter
+    // partitions only have to model the room (and any latency misreport)
+    std::unique_ptr<EchoCanceller> aec;
+    if (useAec) {
+        EchoCanceller::Config aecConfig;
+        aecConfig.delay_ms = std::max(0.0, mic.latencyMs() - 32.0);
+        aec.reset(new EchoCanceller(aecConfig));
+        std::cout << "[AEC] Enabled (stream latency " << mic.latencyMs() << " ms, "
+                  << aecConfig.block * aecConfig.partitions * 1000 / aecConfig.sample_rate << " ms tail)" << std::endl;
+    }
+
+    std::thread worker(processing_thread, &vad, &asr, &controller, &bus, aec.get(), overlap.get(), &mic);
+
     std::cout << "\n[System] Microphone is LIVE. You can speak now." << std::endl;
     std::cout << "[System] Or use the CLI for testing:" << std::endl;
     std::cout << "  - Type 'text: hello' to simulate speech input." << std::endl;
     std::cout << "  - Type 'file: test_audio/file.wav' to run ASR on a file." << std::endl;
+    std::cout << "  - Type 'asr: tiny models/ggml-base.en.bin' to swap a Whisper tier." << std::endl;
     std::cout << "  - Type 'quit' to exit.\n" << std::endl;
 
     std::string input;
@@ -202,9 +401,8 @@ int main(int argc, char** argv) {
             std::string text = input.substr(5);
             std::cout << "[Test] Injected text: " << text << std::endl;
             
-            auto& monitor = PerfMonitor::getInstance();
-            monitor.startTimer("E2E"); // Start E2E for text injection
-            controller.onUserSpeech(text, false, 0.0);
+            TraceId trace = PerfMonitor::getInstance().beginTurn(); // E2E starts at injection
+            bus.publish(EventType::FinalTranscript, trace, text, 0.0);
         }
         else if (input.substr(0, 5) == "file:") {
             test_mode_active = true;
@@ -213,21 +411,37 @@ int main(int argc, char** argv) {
             path.erase(path.find_last_not_of(" ") + 1);
             
             auto& monitor = PerfMonitor::getInstance();
-            monitor.startTimer("E2E"); // E2E starts when we begin processing the 'audio'
-            monitor.startTimer("ASR"); // Track file transcription time
+            TraceId trace = monitor.beginTurn(); // E2E starts when we begin processing the 'audio'
+            Span asr_span = monitor.startSpan(trace, "asr"); // Track file transcription time
             
             std::cout << "[Test] Processing WAV: " << path << std::endl;
-            asr.transcribe_wav(path, [&](const std::string& text){
-                double asr_ms = monitor.stopTimer("ASR");
-                std::cout << "[Test ASR] File Output: " << text << " (took " << asr_ms << "ms)" << std::endl;
-                controller.onUserSpeech(text, false, asr_ms);
+            std::string text;
+            std::shared_ptr<WhisperASR> finalModel = asr.model(WhisperTiers::Use::Final);
+            if (finalModel) finalModel->transcribe_wav(path, [&](const std::string& segment){
+                text += segment;
             });
+            double asr_ms = monitor.endSpan(asr_span);
+            std::cout << "[Test ASR] File Output: " << text << " (took " << asr_ms << "ms)" << std::endl;
+            bus.publish(EventType::FinalTranscript, trace, text, asr_ms);
+        }
+        else if (input.substr(0, 4) == "asr:") {
+            // Hot swap: the old model finishes whatever it is decoding first
+            std::istringstream args(input.substr(4));
+            std::string tier, path;
+            if (args >> tier >> path) asr.load(tier, path);
+            else std::cout << "[ASR] Usage: asr: <tier> <model path>" << std::endl;
         }
     }
 
     running = false;
     queue_cv.notify_all();
     if (worker.joinable()) worker.join();
+    mic.stop_stream(); // No more callbacks into playback or the queue
+    bus.stop();
+    if (ttsCache) std::cout << "[TTS] " << ttsCache->statsLine() << std::endl;
+    PerfMonitor::getInstance().printPercentiles();
+    PerfMonitor::getInstance().stopTraceExport();
+    metricsServer.stop();
 
     return 0;
 }
@@ -0,0 +1,127 @@
+#include "engine_scheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+const char* jobPriorityName(JobPriority p) {
+    switch (p) {
+        case JobPriority::Interrupt: return "interrupt";
+        case JobPriority::FirstSentence: return "first_sentence";
+        case JobPriority::Continuation: return "continuation";
+        case JobPriority::Background: return "background";
+        default: return "unknown";
+    }
+}
+
+EngineScheduler::EngineScheduler(const std::string& n) : name(n) {}
+
+bool EngineScheduler::before(const Job* a, const Job* b) {
+    if (a->priority != b->priority) return a->priority < b->priority;
+    if (a->deadline != b->deadline) return a->deadline < b->deadline;
+    return a->seq < b->seq;
+}
+
+EngineScheduler::Job* EngineScheduler::next() const {
+    if (waiting.empty()) return nullptr;
+    return *std::min_element(waiting.begin(), waiting.end(), before);
+}
+
+double EngineScheduler::predictedWaitMs(const Job& job, Clock::time_point now) const {
+    double wait = 0.0;
+    if (running) {
+        if (running->priority <= job.priority) {
+            double held = running->held_ms + std::chrono::duration<double, std::milli>(now - running->held_since).count();
+            wait += std::max(step_ms, service_ms[(int)running->priority] - held);
+        } else {
+            wait += step_ms; // Gets preempted at its next step
+        }
+    }
+    for (const Job* w : waiting) {
+        if (before(w, &job)) wait += service_ms[(int)w->priority];
+    }
+    return wait;
+}
+
+void EngineScheduler::waitTurn(std::unique_lock<std::mutex>& lock, Job& job) {
+    waiting.push_back(&job);
+    cv.wait(lock, [&] { return !running && next() == &job; });
+    waiting.erase(std::find(waiting.begin(), waiting.end(), &job));
+    running = &job;
+    job.held_since = Clock::now();
+}
+
+bool EngineScheduler::acquire(Job& job) {
+    std::unique_lock<std::mutex> lock(mtx);
+    auto now = Clock::now();
+    if (job.deadline != Clock::time_point::max()) {
+        double wait = predictedWaitMs(job, now);
+        if (now + std::chrono::microseconds((int64_t)(wait * 1000.0)) > job.deadline) {
+            rejected++;
+            std::cout << "[Scheduler] " << name << ": refused " << jobPriorityName(job.priority) << " job of session "
+                      << job.session_id << " (predicted wait " << wait << " ms)" << std::endl;
+            return false;
+        }
+    }
+    admitted++;
+    job.seq = next_seq++;
+    job.held_ms = 0.0;
+    waitTurn(lock, job);
+    return true;
+}
+
+bool EngineScheduler::checkpoint(Job& job) {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (running != &job) return false;
+
+    auto now = Clock::now();
+    double held = std::chrono::duration<double, std::milli>(now - job.held_since).count();
+    job.held_ms += held;
+    job.held_since = now;
+    step_ms = 0.9 * step_ms + 0.1 * held; // Checkpoints come once per decode step
+
+    Job* other = next();
+    if (!other || other->priority >= job.priority) return false;
+
+    preemptions++;
+    running = nullptr;
+    cv.notify_all();
+    waitTurn(lock, job);
+    return true;
+}
+
+void EngineScheduler::release(Job& job) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (running != &job) return;
+    job.held_ms += std::chrono::duration<double, std::milli>(Clock::now() - job.held_since).count();
+    double& avg = service_ms[(int)job.priority];
+    avg = 0.8 * avg + 0.2 * job.held_ms;
+    running = nullptr;
+    cv.notify_all();
+}
+
+void EngineScheduler::setPriority(Job& job, JobPriority priority) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (running == &job) {
+        // Book the time so far to the class it was spent in
+        auto now = Clock::now();
+        job.held_ms += std::chrono::duration<double, std::milli>(now - job.held_since).count();
+        job.held_since = now;
+        double& avg = service_ms[(int)job.priority];
+        avg = 0.8 * avg + 0.2 * job.held_ms;
+        job.held_ms = 0.0;
+    }
+    job.priority = priority;
+    cv.notify_all(); // Waiting order may have changed
+}
+
+int EngineScheduler::queued() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return (int)waiting.size();
+}
+
+std::string EngineScheduler::statsLine() {
+    std::ostringstream s;
+    s << name << ": " << admitted << " admitted, " << rejected << " refused, " << preemptions
+      << " preemptions, " << queued() << " queued";
+    return s.str();
+}
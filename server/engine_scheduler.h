@@ -0,0 +1,81 @@
+#ifndef ENGINE_SCHEDULER_H
+#define ENGINE_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Priority classes, most urgent first
+enum class JobPriority {
+    Interrupt = 0,   // Barge-in classification (monitor LLM, ASR of speech over the agent)
+    FirstSentence,   // Prefill + tokens until the first sentence can be spoken
+    Continuation,    // Rest of a response (already audible)
+    Background,      // Summaries etc. nobody is waiting on
+    Count
+};
+
+const char* jobPriorityName(JobPriority p);
+
+// Hands one engine (a GPU running Whisper or llama contexts) to the most urgent
+// waiting job. Jobs of the same class go earliest-deadline first, then FIFO.
+//
+// Preemption is cooperative: a job calls checkpoint() between decode steps and
+// gives the engine away there if a more urgent class is waiting. Admission is
+// deadline aware: a job with a deadline it can't start before (from recent
+// service times) is refused up front instead of queueing for nothing.
+class EngineScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        JobPriority priority = JobPriority::FirstSentence;
+        Clock::time_point deadline = Clock::time_point::max(); // Latest acceptable start
+        uint32_t session_id = 0;
+
+        // Scheduler bookkeeping
+        uint64_t seq = 0;
+        Clock::time_point held_since;
+        double held_ms = 0.0;
+    };
+
+    explicit EngineScheduler(const std::string& name);
+
+    // Blocks until the job owns the engine. False = not admitted (deadline).
+    bool acquire(Job& job);
+    // Decode-step boundary. Returns true if the job was preempted and got the
+    // engine back later (engine state may have changed in between).
+    bool checkpoint(Job& job);
+    void release(Job& job);
+    // e.g. FirstSentence -> Continuation once the first sentence is out
+    void setPriority(Job& job, JobPriority priority);
+
+    std::string name;
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> preemptions{0};
+
+    int queued();
+    std::string statsLine();
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<Job*> waiting;
+    Job* running = nullptr;
+    uint64_t next_seq = 0;
+
+    // Recent time a job of each class holds the engine, and one decode step
+    double service_ms[(int)JobPriority::Count] = {150.0, 600.0, 2000.0, 2000.0};
+    double step_ms = 30.0;
+
+    static bool before(const Job* a, const Job* b);
+    Job* next() const;
+    double predictedWaitMs(const Job& job, Clock::time_point now) const;
+    void waitTurn(std::unique_lock<std::mutex>& lock, Job& job);
+};
+
+#endif // ENGINE_SCHEDULER_H
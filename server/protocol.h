@@ -0,0 +1,29 @@
+#ifndef VOICE_PROTOCOL_H
+#define VOICE_PROTOCOL_H
+
+#include <cstdint>
+
+// Session wire format (TCP, both directions), one message per frame:
+//   [type: 1 byte][payload length: uint32 little endian][payload]
+namespace proto {
+
+// Client -> server
+const char kAudioIn = 'A';   // s16le mono 16 kHz PCM, any length
+const char kText = 'T';      // UTF-8 user text (skips VAD/ASR, like "text:" on stdin)
+const char kBye = 'Q';       // Close the session
+
+// Server -> client
+const char kHello = 'H';     // {"session":N,"in_rate":16000,"out_rate":22050}
+const char kAudioOut = 'A';  // s16le mono 22050 Hz agent speech
+const char kFlush = 'X';     // Barge-in: drop any agent audio still buffered
+const char kEvent = 'E';     // {"event":"SpeechStart","trace":N,"text":"..."}
+const char kMetrics = 'M';   // Finished turn, same object as a benchmark_results.jsonl row
+const char kError = '!';     // Text reason, connection closes after it
+
+const uint32_t kMaxPayload = 1u << 20;
+const int kInRate = 16000;
+const int kOutRate = 22050;
+
+} // namespace proto
+
+#endif // VOICE_PROTOCOL_H
@@ -0,0 +1,151 @@
+#include "session.h"
+#include "protocol.h"
+#include "../tts/callback_tts.h"
+#include "../utils/json_util.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace {
+// An interrupt check that can't start by then is answered by the fallback
+// (treat the speech as a real interruption) instead
+const double kMonitorDeadlineMs = 400.0;
+
+AudioPipeline::Config sessionPipelineConfig(uint32_t id) {
+    AudioPipeline::Config config;
+    config.verbose = false;
+    config.session_id = id;
+    config.backchannel_after_frames = 0; // Nothing fire-and-forget on a shared stream yet
+    return config;
+}
+} // namespace
+
+Session::Session(uint32_t session_id, const ServerEngines& engines, Sender sender)
+    : id(session_id),
+      send(std::move(sender)),
+      asr(engines.asr, session_id, &controller.agentSpeaking),
+      bargeInAsr(engines.asr_barge_in ? engines.asr_barge_in : engines.asr, session_id, &controller.agentSpeaking),
+      has_barge_in(engines.asr_barge_in != nullptr),
+      partialAsr(engines.asr_partial ? engines.asr_partial : engines.asr, session_id, &controller.agentSpeaking),
+      vad(engines.vad_model),
+      llm(engines.llm, session_id),
+      monitorLLM(engines.monitor_llm, session_id, JobPriority::Interrupt, kMonitorDeadlineMs),
+      tts(new CallbackTTS(engines.tts,
+          [this](const int16_t* pcm, size_t n) {
+              return send(proto::kAudioOut, (const char*)pcm, n * sizeof(int16_t));
+          },
+          [this]() { send(proto::kFlush, nullptr, 0); })),
+      controller(&llm, &monitorLLM, &persona, &tts, &bus),
+      pipeline(&vad, &controller, &bus,
+          [this](TraceId trace, std::vector<int16_t> audio) { onUtterance(trace, std::move(audio)); },
+          sessionPipelineConfig(session_id)),
+      frame(512) {
+    // Mirror the pipeline events to the client (captions, UI state)
+    for (int t = 0; t < (int)EventType::Count; ++t) {
+        bus.subscribe((EventType)t, [this](const PipelineEvent& e) {
+            std::string json = std::string("{\"event\":\"") + eventTypeName(e.type) + "\",\"trace\":" +
+                               std::to_string(e.trace_id) + ",\"text\":\"" + jsonEscape(e.text) + "\"}";
+            send(proto::kEvent, json.data(), json.size());
+        });
+    }
+    pipeline.setOverlapClassifier(engines.overlap);
+    tts.setCache(engines.tts_cache);
+    // Pause scoring only with a tier of its own; on the shared Final tier it would
+    // queue ahead of the transcripts it is meant to speed up
+    if (engines.asr_partial) {
+        pipeline.setPartialHandler([this](uint64_t pause_id, std::vector<int16_t> audio) {
+            onPause(pause_id, std::move(audio));
+        });
+    }
+    bus.start();
+}
+
+Session::~Session() {
+    close();
+}
+
+void Session::feedAudio(const int16_t* pcm, size_t samples) {
+    while (samples > 0) {
+        size_t n = std::min(samples, frame.size() - frame_fill);
+        std::copy(pcm, pcm + n, frame.begin() + frame_fill);
+        frame_fill += n;
+        pcm += n;
+        samples -= n;
+        if (frame_fill == frame.size()) {
+            pipeline.processFrame(frame);
+            frame_fill = 0;
+        }
+    }
+}
+
+void Session::injectText(const std::string& text) {
+    TraceId trace = PerfMonitor::getInstance().beginTurn(std::chrono::steady_clock::now(), id);
+    bus.publish(EventType::FinalTranscript, trace, text, 0.0);
+}
+
+void Session::onUtterance(TraceId trace, std::vector<int16_t> audio) {
+    asr_in_flight++;
+    // Speech over the agent: the fast tier's transcript only decides the
+    // interrupt; the turn is answered from the final tier's
+    bool bargeIn = has_barge_in && controller.agentSpeaking;
+    std::thread([this, trace, bargeIn](std::vector<int16_t> utterance, std::string context) {
+        auto& monitor = PerfMonitor::getInstance();
+        monitor.setThreadName("asr_worker");
+        double asr_ms = 0.0;
+        bool quick = false;
+        if (bargeIn) {
+            std::string text = AudioPipeline::transcribeUtterance(&bargeInAsr, utterance, trace, &asr_ms, context,
+                                                                  "asr_barge_in");
+            quick = !text.empty() && !closed;
+            if (quick) bus.publish(EventType::PartialTranscript, trace, text, asr_ms);
+            else if (!text.empty()) monitor.dropTurn(trace);
+        }
+        if (!bargeIn || quick) {
+            std::string text = AudioPipeline::transcribeUtterance(&asr, utterance, trace, &asr_ms, context);
+            if (closed) {
+                if (!text.empty()) monitor.dropTurn(trace);
+            } else if (!text.empty() || quick) {
+                bus.publish(EventType::FinalTranscript, trace, text, asr_ms); // Empty: releases the pending check
+            }
+        }
+        asr_in_flight--;
+    }, std::move(audio), controller.asrContext()).detach();
+}
+
+void Session::onPause(uint64_t pause_id, std::vector<int16_t> audio) {
+    if (closed || partial_busy.exchange(true)) return;
+    asr_in_flight++;
+    std::thread([this, pause_id](std::vector<int16_t> partial) {
+        PerfMonitor::getInstance().setThreadName("asr_partial");
+        pipeline.setTurnCompletion(pause_id, AudioPipeline::scoreCompletion(&partialAsr, partial));
+        partial_busy = false;
+        asr_in_flight--;
+    }, std::move(audio)).detach();
+}
+
+void Session::onTurnFinished(const TurnTrace& turn) {
+    turns_done++;
+    e2e_hist.record(turn.metrics.total_e2e_ms);
+    std::string json = interactionMetricsJson(turn.metrics);
+    send(proto::kMetrics, json.data(), json.size());
+}
+
+void Session::close() {
+    if (closed.exchange(true)) return;
+
+    // No new turns: let transcriptions finish, then stop dispatching
+    while (asr_in_flight > 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    bus.stop();
+
+    // Keep cutting until every running turn has returned (a turn that was
+    // just starting resets its abort flag, so one stop() isn't enough)
+    while (!controller.idle()) {
+        llm.stop();
+        monitorLLM.stop();
+        tts.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::cout << "[Server] Session " << id << " closed after " << turns_done << " turns (E2E P50 "
+              << e2e_hist.percentile(50) << " ms)" << std::endl;
+}
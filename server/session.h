@@ -0,0 +1,76 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "shared_engines.h"
+#include "../audio/vad.h"
+#include "../persona/persona_state.h"
+#include "../tts/tts_stream.h"
+#include "../controller/dialogue_controller.h"
+#include "../controller/audio_pipeline.h"
+#include "../utils/event_bus.h"
+#include "../utils/latency_histogram.h"
+#include "../utils/perf_monitor.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One connected conversation in server mode. Owns everything that used to be
+// process-global in main.cpp -- VAD stream state, the audio buffer / endpointing,
+// dialogue history, bus and per-session metrics -- and borrows the shared engines.
+class Session {
+public:
+    // Writes one protocol message; false once the client is gone. Called from
+    // several threads (frames, TTS, bus), so it must serialize internally.
+    using Sender = std::function<bool(char type, const char* data, size_t len)>;
+
+    Session(uint32_t id, const ServerEngines& engines, Sender send);
+    ~Session();
+
+    const uint32_t id;
+
+    // Raw 16 kHz PCM from the client, any chunk size
+    void feedAudio(const int16_t* pcm, size_t samples);
+    // Typed input: starts a turn directly
+    void injectText(const std::string& text);
+
+    // Called by the server for every finished turn tagged with this session
+    void onTurnFinished(const TurnTrace& turn);
+
+    // Stops any response and waits for in-flight turns. Idempotent.
+    void close();
+
+    int turns() const { return turns_done; }
+    const LatencyHistogram& e2e() const { return e2e_hist; }
+
+private:
+    Sender send;
+    SessionASR asr;
+    SessionASR bargeInAsr; // Fast first pass over speech during the agent's turn, when a tier is routed
+    bool has_barge_in;
+    SessionASR partialAsr; // Pause scoring; only used when a tier of its own is routed
+
+    VAD vad;
+    PersonaState persona;
+    SessionLLM llm;
+    SessionLLM monitorLLM;
+    TTSEngine tts;
+    EventBus bus;
+    DialogueController controller;
+    AudioPipeline pipeline;
+
+    std::vector<int16_t> frame; // Re-chunks client audio into 512-sample VAD frames
+    size_t frame_fill = 0;
+
+    std::atomic<int> asr_in_flight{0};
+    std::atomic<bool> partial_busy{false};
+    std::atomic<bool> closed{false};
+    std::atomic<int> turns_done{0};
+    LatencyHistogram e2e_hist;
+
+    void onUtterance(TraceId trace, std::vector<int16_t> audio);
+    void onPause(uint64_t pause_id, std::vector<int16_t> audio);
+};
+
+#endif // SESSION_H
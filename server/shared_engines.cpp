@@ -0,0 +1,49 @@
+#include "shared_engines.h"
+#include "../llm/sentence_boundary.h"
+
+void SharedASR::transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback,
+                           JobPriority priority, uint32_t session_id, const std::string& context) {
+    EngineScheduler::Job job;
+    job.priority = priority;
+    job.session_id = session_id;
+    scheduler->acquire(job); // No deadline: always admitted
+
+    engine->transcribeWithContext(audio, context, callback);
+    scheduler->release(job);
+}
+
+void SessionLLM::generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                               TraceId trace, const std::atomic<bool>& cancel) {
+    auto& monitor = PerfMonitor::getInstance();
+    EngineScheduler* scheduler = shared->scheduler;
+
+    EngineScheduler::Job job;
+    job.priority = priority;
+    job.session_id = session_id;
+    if (deadline_ms > 0.0) {
+        job.deadline = EngineScheduler::Clock::now() + std::chrono::microseconds((int64_t)(deadline_ms * 1000.0));
+    }
+
+    Span queue = monitor.startSpan(trace, "llm_queue");
+    bool admitted = scheduler->acquire(job);
+    monitor.endSpan(queue);
+    if (!admitted) return;
+    if (cancel) { // Interrupted while queued
+        scheduler->release(job);
+        return;
+    }
+
+    SentenceBoundary sentences;
+    shared->engine->generateUntil(prompt, [&](const std::string& token) {
+        if (cancel) return;
+        token_callback(token);
+        if (sentences.feed(token) && job.priority == JobPriority::FirstSentence) {
+            scheduler->setPriority(job, JobPriority::Continuation);
+        }
+        // Decode-step boundary: let a more urgent job (another session's
+        // interrupt check, a first sentence) run before our next token
+        scheduler->checkpoint(job);
+    }, trace, cancel);
+
+    scheduler->release(job);
+}
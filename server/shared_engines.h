@@ -0,0 +1,103 @@
+#ifndef SHARED_ENGINES_H
+#define SHARED_ENGINES_H
+
+#include "engine_scheduler.h"
+#include "../asr/asr_backend.h"
+#include "../llm/llm_backend.h"
+
+class VAD;
+class OverlapClassifier;
+class SimpleTTS;
+class ResponseCache;
+
+// Whisper / llama contexts are single-stream: sessions take turns on them,
+// in the order an EngineScheduler decides.
+
+class SharedASR : public ASRBackend {
+public:
+    SharedASR(ASRBackend* engine, EngineScheduler* scheduler) : engine(engine), scheduler(scheduler) {}
+
+    // Whisper can't stop halfway, so ASR jobs are ordered but never preempted
+    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback,
+                    JobPriority priority, uint32_t session_id = 0, const std::string& context = "");
+    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) override {
+        transcribe(audio, std::move(callback), JobPriority::FirstSentence);
+    }
+    void transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                               std::function<void(const std::string&)> callback) override {
+        transcribe(audio, std::move(callback), JobPriority::FirstSentence, 0, context);
+    }
+
+private:
+    ASRBackend* engine;
+    EngineScheduler* scheduler;
+};
+
+// A session's view of a SharedASR: speech that arrives while the agent is
+// talking may be a barge-in, so it jumps ahead of ordinary turns.
+class SessionASR : public ASRBackend {
+public:
+    SessionASR(SharedASR* shared, uint32_t session_id, const std::atomic<bool>* agent_speaking)
+        : shared(shared), session_id(session_id), agent_speaking(agent_speaking) {}
+
+    void transcribe(const std::vector<int16_t>& audio, std::function<void(const std::string&)> callback) override {
+        transcribeWithContext(audio, "", std::move(callback));
+    }
+    void transcribeWithContext(const std::vector<int16_t>& audio, const std::string& context,
+                               std::function<void(const std::string&)> callback) override {
+        JobPriority priority = *agent_speaking ? JobPriority::Interrupt : JobPriority::FirstSentence;
+        shared->transcribe(audio, std::move(callback), priority, session_id, context);
+    }
+
+private:
+    SharedASR* shared;
+    uint32_t session_id;
+    const std::atomic<bool>* agent_speaking;
+};
+
+class SharedLLM {
+public:
+    // Both LLM contexts live on the same GPU, so they normally share one scheduler
+    SharedLLM(LLMBackend* engine, EngineScheduler* scheduler) : engine(engine), scheduler(scheduler) {}
+
+    LLMBackend* engine;
+    EngineScheduler* scheduler;
+};
+
+// A session's view of a SharedLLM. Has its own abort flag, so one session's
+// interrupt only ever stops its own generation.
+//
+// Response generations start as FirstSentence and drop to Continuation once a
+// sentence is complete; they yield the engine at every decode step to anything
+// more urgent. deadline_ms > 0 refuses jobs that can't start in time (the
+// caller sees an empty generation).
+class SessionLLM : public LLMBackend {
+public:
+    SessionLLM(SharedLLM* shared, uint32_t session_id, JobPriority priority = JobPriority::FirstSentence,
+               double deadline_ms = 0.0)
+        : shared(shared), session_id(session_id), priority(priority), deadline_ms(deadline_ms) {}
+
+    void generateUntil(const std::string& prompt, std::function<void(const std::string&)> token_callback,
+                       TraceId trace, const std::atomic<bool>& cancel) override;
+
+private:
+    SharedLLM* shared;
+    uint32_t session_id;
+    JobPriority priority;
+    double deadline_ms;
+};
+
+// Everything sessions share. Not owned.
+struct ServerEngines {
+    VAD* vad_model = nullptr;   // Each session forks its own stream state
+    const OverlapClassifier* overlap = nullptr; // Stateless, shared as is (optional)
+    SharedASR* asr = nullptr;          // Final transcripts
+    SharedASR* asr_barge_in = nullptr; // Interrupt check on speech over the agent (null = none)
+    SharedASR* asr_partial = nullptr;  // End-of-turn scoring (null = asr)
+    SharedLLM* llm = nullptr;
+    SharedLLM* monitor_llm = nullptr;
+    SimpleTTS* tts = nullptr;
+    ResponseCache* tts_cache = nullptr; // Stock answers synthesized once for everyone (optional)
+};
+
+#endif // SHARED_ENGINES_H
@@ -0,0 +1,169 @@
+#include "voice_server.h"
+#include "session.h"
+#include "protocol.h"
+#include "../utils/socket_compat.h"
+#include "../utils/perf_monitor.h"
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+// Live sessions by id, for routing finished turns
+struct SessionRegistry {
+    std::mutex mtx;
+    std::map<uint32_t, std::shared_ptr<Session>> sessions;
+};
+
+namespace {
+bool sendMessage(socket_t s, char type, const char* data, size_t len) {
+    char header[5];
+    header[0] = type;
+    uint32_t n = (uint32_t)len;
+    for (int i = 0; i < 4; ++i) header[1 + i] = (char)((n >> (8 * i)) & 0xFF);
+    return sendAll(s, header, sizeof(header)) && (len == 0 || sendAll(s, data, len));
+}
+
+// Waits up to timeout_ms for the socket to become readable
+bool readable(socket_t s, int timeout_ms) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(s, &set);
+    timeval tv{timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+    return select((int)s + 1, &set, nullptr, nullptr, &tv) > 0;
+}
+} // namespace
+
+VoiceServer::VoiceServer(const ServerEngines& e, const std::string& h, int p, int max)
+    : engines(e), host(h), port(p), max_sessions(max), listener((uintptr_t)INVALID_SOCKET), running(false),
+      active_clients(0), next_session(1), registry(std::make_shared<SessionRegistry>()) {
+    std::shared_ptr<SessionRegistry> reg = registry;
+    turn_listener = PerfMonitor::getInstance().addTurnListener([reg](const TurnTrace& t) {
+        if (t.metrics.session_id == 0) return;
+        std::shared_ptr<Session> session;
+        {
+            std::lock_guard<std::mutex> lock(reg->mtx);
+            auto it = reg->sessions.find(t.metrics.session_id);
+            if (it != reg->sessions.end()) session = it->second;
+        }
+        // Send outside the lock so one slow client doesn't stall every session's turns
+        if (session) session->onTurnFinished(t);
+    });
+}
+
+VoiceServer::~VoiceServer() {
+    PerfMonitor::getInstance().removeTurnListener(turn_listener);
+    stop();
+}
+
+bool VoiceServer::start() {
+    if (running) return true;
+    socket_t s = listenTcp(host, port);
+    if (s == INVALID_SOCKET) {
+        std::cerr << "[Server] Could not listen on " << host << ":" << port << std::endl;
+        return false;
+    }
+    listener = (uintptr_t)s;
+    running = true;
+    accept_thread = std::thread(&VoiceServer::acceptLoop, this);
+    std::cout << "[Server] Accepting sessions on " << host << ":" << port
+              << " (max " << max_sessions << ")" << std::endl;
+    return true;
+}
+
+void VoiceServer::stop() {
+    if (!running.exchange(false)) return;
+    if (accept_thread.joinable()) accept_thread.join();
+    CLOSE_SOCKET((socket_t)listener);
+
+    // Connection threads notice running == false within one poll interval
+    while (active_clients > 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+void VoiceServer::acceptLoop() {
+    PerfMonitor::getInstance().setThreadName("voice_server");
+    socket_t ls = (socket_t)listener;
+    while (running) {
+        if (!readable(ls, 200)) continue;
+        socket_t client = accept(ls, nullptr, nullptr);
+        if (client == INVALID_SOCKET) continue;
+
+        if (active_clients >= max_sessions) {
+            std::string reason = "server full";
+            sendMessage(client, proto::kError, reason.data(), reason.size());
+            CLOSE_SOCKET(client);
+            continue;
+        }
+#ifdef TCP_NODELAY
+        int yes = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&yes, sizeof(yes));
+#endif
+        active_clients++;
+        std::thread([this, client]() {
+            handleClient((uintptr_t)client);
+            CLOSE_SOCKET(client);
+            active_clients--;
+        }).detach();
+    }
+}
+
+void VoiceServer::handleClient(uintptr_t c) {
+    socket_t s = (socket_t)c;
+    uint32_t id = next_session++;
+    PerfMonitor::getInstance().setThreadName("session");
+    setRecvTimeout(s, 5000); // Bounds a stalled half-sent message
+    setSendTimeout(s, 5000); // And a client that stopped reading
+
+    // TTS, bus and frame threads all write to the socket
+    auto send_mtx = std::make_shared<std::mutex>();
+    std::atomic<bool> alive(true);
+    Session::Sender sender = [s, send_mtx, &alive](char type, const char* data, size_t len) {
+        if (!alive) return false;
+        std::lock_guard<std::mutex> lock(*send_mtx);
+        if (!sendMessage(s, type, data, len)) alive = false;
+        return alive.load();
+    };
+
+    auto session = std::make_shared<Session>(id, engines, sender);
+    {
+        std::lock_guard<std::mutex> lock(registry->mtx);
+        registry->sessions[id] = session;
+    }
+    std::string hello = "{\"session\":" + std::to_string(id) + ",\"in_rate\":" + std::to_string(proto::kInRate) +
+                        ",\"out_rate\":" + std::to_string(proto::kOutRate) + "}";
+    sender(proto::kHello, hello.data(), hello.size());
+    std::cout << "[Server] Session " << id << " connected (" << active_clients << " active)" << std::endl;
+
+    std::vector<char> payload;
+    while (running && alive) {
+        if (!readable(s, 200)) continue;
+
+        char header[5];
+        if (!recvAll(s, header, sizeof(header))) break;
+        uint32_t len = 0;
+        for (int i = 0; i < 4; ++i) len |= (uint32_t)(unsigned char)header[1 + i] << (8 * i);
+        if (len > proto::kMaxPayload) {
+            std::string reason = "payload too large";
+            sender(proto::kError, reason.data(), reason.size());
+            break;
+        }
+        payload.resize(len);
+        if (len > 0 && !recvAll(s, payload.data(), len)) break;
+
+        if (header[0] == proto::kAudioIn) {
+            session->feedAudio((const int16_t*)payload.data(), len / sizeof(int16_t));
+        } else if (header[0] == proto::kText) {
+            session->injectText(std::string(payload.begin(), payload.end()));
+        } else if (header[0] == proto::kBye) {
+            break;
+        }
+    }
+
+    session->close();
+    alive = false; // Nothing may write to the socket once this thread closes it
+    {
+        std::lock_guard<std::mutex> lock(registry->mtx);
+        registry->sessions.erase(id);
+    }
+    // A turn listener may still hold the session; it must not outlive alive/send_mtx
+    while (session.use_count() > 1) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
@@ -0,0 +1,45 @@
+#ifndef VOICE_SERVER_H
+#define VOICE_SERVER_H
+
+#include "shared_engines.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+struct SessionRegistry;
+
+// Multi-session server mode. Each TCP connection is one Session (see protocol.h
+// for the framing) running on its own connection thread; all sessions share the
+// ASR/LLM/TTS engines. Finished turns are routed back to their session by the
+// session id PerfMonitor tags them with.
+class VoiceServer {
+public:
+    VoiceServer(const ServerEngines& engines, const std::string& host = "127.0.0.1", int port = 9470,
+                int max_sessions = 64);
+    ~VoiceServer();
+
+    bool start();
+    void stop();
+
+    int activeSessions() const { return active_clients; }
+
+private:
+    void acceptLoop();
+    void handleClient(uintptr_t client);
+
+    ServerEngines engines;
+    std::string host;
+    int port;
+    int max_sessions;
+    uintptr_t listener;
+    std::atomic<bool> running;
+    std::atomic<int> active_clients;
+    std::atomic<uint32_t> next_session;
+    std::thread accept_thread;
+    std::shared_ptr<SessionRegistry> registry; // Shared with the PerfMonitor turn listener
+    uint64_t turn_listener;
+};
+
+#endif // VOICE_SERVER_H
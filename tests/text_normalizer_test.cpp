@@ -0,0 +1,70 @@
+// TextNormalizer case table: what Piper should be given for a few LLM outputs.
+// Each case is checked one-shot, streamed in 3-byte fragments (tokens split
+// mid-number and mid-UTF-8), and normalized a second time, which must change
+// nothing (cache keys are normalized text). Exits 1 on any mismatch.
+//
+//   ctest -R text_normalizer
+
+#include "../tts/text_normalizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+const struct {
+    const char* in;
+    const char* out;
+} kNormalizeCases[] = {
+    {"It costs $4.99, about 20% off.", "It costs four dollars and ninety-nine cents, about twenty percent off."},
+    {"$1.50 each", "one dollar and fifty cents each"},
+    {"$1 or $2.5M", "one dollar or two point five million dollars"},
+    {"1,500 people on the 3rd", "one thousand five hundred people on the third"},
+    {"Meet at 3:30pm, not 10:00.", "Meet at three thirty P M, not ten o'clock."},
+    {"Built in 1990, rebuilt 2005.", "Built in nineteen ninety, rebuilt two thousand five."},
+    {"the 1990s and her 20s", "the nineteen nineties and her twenties"},
+    {"back in the '90s", "back in the nineties"},
+    {"timeout 15s", "timeout fifteen seconds"},
+    {"2020-2021", "twenty twenty to twenty twenty-one"},
+    {"1990-95", "nineteen ninety to ninety-five"},
+    {"5-10 km", "five to ten kilometers"},
+    {"1 km, 200ms, 3 MB", "one kilometer, two hundred milliseconds, three megabytes"},
+    {"It's -5\xC2\xB0" "C outside.", "It's minus five degrees Celsius outside."},
+    {"Dr. Smith, e.g. vs. Jones", "Doctor Smith, for example versus Jones"},
+    {"agent 007", "agent zero zero seven"},
+    {"Sure! \xF0\x9F\x98\x8A *Really* [laughter] #yes", "Sure! Really yes"},
+    {"- first item\n- second item", "first item\nsecond item"},
+    {"snake_case", "snake case"},
+    {"Done.<|im_end|>\nuser", "Done."},
+    {"Done.\nuser: hi", "Done."},
+};
+
+int checkCases() {
+    int failures = 0;
+    for (const auto& c : kNormalizeCases) {
+        std::string once = TextNormalizer::normalize(c.in);
+        std::string streamed;
+        TextNormalizer normalizer;
+        for (const char* p = c.in; *p; p += std::min<size_t>(3, std::strlen(p))) {
+            normalizer.push(p, std::min<size_t>(3, std::strlen(p)), streamed);
+        }
+        normalizer.finish(streamed);
+        std::string twice = TextNormalizer::normalize(once);
+        if (once == c.out && streamed == once && twice == once) continue;
+        std::cerr << "[normalize] \"" << c.in << "\"\n  expected \"" << c.out << "\"\n  got      \"" << once
+                  << "\" (streamed \"" << streamed << "\", twice \"" << twice << "\")" << std::endl;
+        failures++;
+    }
+    return failures;
+}
+
+} // namespace
+
+int main() {
+    int failures = checkCases();
+    size_t total = sizeof(kNormalizeCases) / sizeof(kNormalizeCases[0]);
+    std::cout << "[normalize] " << total - failures << "/" << total << " cases passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+#include "callback_tts.h"
+#include <algorithm>
+
+CallbackTTS::CallbackTTS(SimpleTTS* e, Sink s, std::function<void()> stop_cb)
+    : engine(e), sink(std::move(s)), on_stop(std::move(stop_cb)) {}
+
+void CallbackTTS::speak(const std::string& text, TraceId trace, std::vector<int16_t>* synthesized, bool normalized) {
+    if (text.empty()) return;
+    stopped = false;
+
+    size_t samples = 0;
+    bool complete = true;
+    auto first_chunk = std::chrono::steady_clock::now();
+    engine->synthesize(text, trace, [&](const int16_t* pcm, size_t n) {
+        if (stopped || !sink(pcm, n)) return complete = false;
+        if (samples == 0) {
+            first_chunk = std::chrono::steady_clock::now();
+            PerfMonitor::getInstance().mark(trace, "playback_start"); // On its way to the client
+        }
+        samples += n;
+        if (synthesized) synthesized->insert(synthesized->end(), pcm, pcm + n);
+        return true;
+    }, 0.0f, normalized);
+    if (synthesized && !complete) synthesized->clear();
+    lastAudioSec = (double)samples / SimpleTTS::kSampleRate;
+    if (!pace || samples == 0) return;
+    holdUntilPlayed(first_chunk);
+}
+
+bool CallbackTTS::playPcm(const int16_t* pcm, size_t samples, TraceId trace) {
+    stopped = false;
+    auto first_chunk = std::chrono::steady_clock::now();
+    size_t sent = 0;
+    // Piper-sized chunks, so the client's jitter buffer sees the usual stream
+    while (sent < samples && !stopped) {
+        size_t n = std::min<size_t>(1024, samples - sent);
+        if (!sink(pcm + sent, n)) break;
+        if (sent == 0) PerfMonitor::getInstance().mark(trace, "playback_start");
+        sent += n;
+    }
+    lastAudioSec = (double)sent / SimpleTTS::kSampleRate;
+    if (pace && sent > 0) holdUntilPlayed(first_chunk);
+    return true;
+}
+
+void CallbackTTS::holdUntilPlayed(std::chrono::steady_clock::time_point first_chunk) {
+    // Hold until the client has had time to play it (or we get interrupted)
+    auto done = first_chunk + std::chrono::microseconds((int64_t)(lastAudioSec * 1e6));
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait_until(lock, done, [this] { return stopped.load(); });
+}
+
+void CallbackTTS::playBackchannel(const std::string& type) {
+    (void)type; // No fire-and-forget audio on a shared stream yet
+}
+
+void CallbackTTS::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopped = true;
+    }
+    cv.notify_all();
+    if (on_stop) on_stop();
+}
@@ -0,0 +1,50 @@
+#ifndef CALLBACK_TTS_H
+#define CALLBACK_TTS_H
+
+#include "tts_backend.h"
+#include "simple_tts.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+// Speaks through a shared SimpleTTS but hands the PCM (22050 Hz s16) to a
+// callback instead of the local speakers -- e.g. a server session's socket.
+// speak() still blocks for the audio's duration, as if it were playing, so the
+// controller's agentSpeaking (and barge-in detection) matches what the client hears.
+class CallbackTTS : public TTSBackend {
+public:
+    using Sink = std::function<bool(const int16_t* pcm, size_t samples)>;
+
+    // on_stop runs when an interrupt cuts playback (tell the client to flush)
+    CallbackTTS(SimpleTTS* engine, Sink sink, std::function<void()> on_stop = nullptr);
+
+    void speak(const std::string& text, TraceId trace = 0, std::vector<int16_t>* synthesized = nullptr,
+               bool normalized = false) override;
+    void playBackchannel(const std::string& type) override;
+    void stop() override;
+
+    void setPlaybackEnabled(bool enabled) override { pace = enabled; }
+    double lastAudioSeconds() const override { return lastAudioSec; }
+
+    // Same audio as the engine's, so every session shares its cache entries
+    std::string voiceId() const override { return engine->voice(); }
+    int sampleRate() const override { return SimpleTTS::kSampleRate; }
+    bool playPcm(const int16_t* pcm, size_t samples, TraceId trace = 0) override;
+
+private:
+    SimpleTTS* engine;
+    Sink sink;
+    std::function<void()> on_stop;
+    bool pace = true;
+    double lastAudioSec = 0.0;
+
+    std::atomic<bool> stopped{false};
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    void holdUntilPlayed(std::chrono::steady_clock::time_point first_chunk);
+};
+
+#endif // CALLBACK_TTS_H
@@ -0,0 +1,137 @@
+#include "clip_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+const std::vector<ClipCache::Spec>& ClipCache::catalog() {
+    static const std::vector<Spec> specs = {
+        {"generic", "uh-huh.", 1.0f},
+        {"generic", "uh-huh.", 0.85f},
+        {"generic", "mm-hmm.", 1.0f},
+        {"generic", "mm-hmm.", 1.15f},
+        {"agreement", "yeah.", 1.0f},
+        {"agreement", "yeah!", 0.9f},
+        {"agreement", "right.", 1.0f},
+        {"agreement", "exactly.", 1.0f},
+        {"thinking", "hmm.", 1.0f},
+        {"thinking", "hmm...", 1.3f},
+        {"thinking", "um,", 1.1f},
+        {"acknowledge", "okay.", 1.0f},
+        {"acknowledge", "got it.", 1.0f},
+        {"acknowledge", "sure.", 0.9f},
+        {"acknowledge", "I see.", 1.0f},
+        {"filler", "Let me think.", 1.0f},
+        {"filler", "Hmm, let me see.", 1.05f},
+        {"filler", "Good question.", 1.0f},
+        {"filler", "One moment.", 1.0f},
+    };
+    return specs;
+}
+
+std::string ClipCache::fileName(const Spec& spec, int sample_rate) {
+    // Content-addressed, so editing the catalog never picks up a stale clip
+    std::string key = spec.text + "|" + std::to_string((int)std::lround(spec.length_scale * 100)) + "|" +
+                      std::to_string(sample_rate);
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
+    return spec.type + "_" + hex + ".pcm";
+}
+
+void ClipCache::shape(std::vector<int16_t>& pcm, int sample_rate, float gain) {
+    const int kSilence = 200; // About -44 dBFS
+    auto loud = [&](int16_t s) { return std::abs((int)s) > kSilence; };
+    auto first = std::find_if(pcm.begin(), pcm.end(), loud);
+    auto last = std::find_if(pcm.rbegin(), pcm.rend(), loud).base();
+    if (first >= last) {
+        pcm.clear();
+        return;
+    }
+    // A few ms either side so consonants aren't clipped
+    size_t pad = (size_t)(sample_rate * 0.005);
+    size_t begin = (size_t)std::max<std::ptrdiff_t>(0, (first - pcm.begin()) - (std::ptrdiff_t)pad);
+    size_t end = std::min(pcm.size(), (size_t)(last - pcm.begin()) + pad);
+    pcm.assign(pcm.begin() + begin, pcm.begin() + end);
+
+    size_t fade = std::min(pcm.size() / 2, (size_t)(sample_rate * 0.005));
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        float g = gain;
+        if (i < fade) g *= (float)i / fade;
+        else if (i >= pcm.size() - fade) g *= (float)(pcm.size() - 1 - i) / fade;
+        pcm[i] = (int16_t)std::lround(pcm[i] * g);
+    }
+}
+
+size_t ClipCache::load(const std::string& dir, int sample_rate, Synth synth, float gain) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    clips.clear();
+    by_type.clear();
+    size_t synthesized = 0;
+    for (const Spec& spec : catalog()) {
+        Clip clip;
+        clip.spec = spec;
+        fs::path path = fs::path(dir) / fileName(spec, sample_rate);
+
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (in) {
+            std::streamsize bytes = in.tellg();
+            clip.pcm.resize((size_t)bytes / sizeof(int16_t));
+            in.seekg(0);
+            in.read((char*)clip.pcm.data(), (std::streamsize)(clip.pcm.size() * sizeof(int16_t)));
+        } else if (synth) {
+            clip.pcm = synth(spec.text, spec.length_scale);
+            shape(clip.pcm, sample_rate, gain);
+            if (!clip.pcm.empty()) {
+                std::ofstream out(path, std::ios::binary | std::ios::trunc);
+                out.write((const char*)clip.pcm.data(), (std::streamsize)(clip.pcm.size() * sizeof(int16_t)));
+                synthesized++;
+            }
+        }
+        if (clip.pcm.empty()) continue;
+        by_type[spec.type].push_back(clips.size());
+        clips.push_back(std::move(clip));
+    }
+    std::cout << "[Clips] " << clips.size() << " backchannel/filler clips ready (" << synthesized
+              << " synthesized) in " << dir << std::endl;
+    return clips.size();
+}
+
+bool ClipCache::has(const std::string& type) const {
+    return by_type.count(type) > 0;
+}
+
+const std::vector<int16_t>* ClipCache::pick(const std::string& type) {
+    auto it = by_type.find(type);
+    if (it == by_type.end()) return nullptr;
+    const std::vector<size_t>& variants = it->second;
+
+    std::lock_guard<std::mutex> lock(mtx);
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    size_t choice = variants[rng % variants.size()];
+    auto last = last_pick.find(type);
+    if (variants.size() > 1 && last != last_pick.end() && last->second == choice) {
+        choice = variants[(std::find(variants.begin(), variants.end(), choice) - variants.begin() + 1) % variants.size()];
+    }
+    last_pick[type] = choice;
+    return &clips[choice].pcm;
+}
+
+const std::vector<int16_t>* ClipCache::find(const std::string& text) const {
+    for (const Clip& clip : clips) {
+        if (clip.spec.text == text) return &clip.pcm;
+    }
+    return nullptr;
+}
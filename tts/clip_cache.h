@@ -0,0 +1,61 @@
+#ifndef CLIP_CACHE_H
+#define CLIP_CACHE_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Pre-synthesized backchannels and fillers ("uh-huh", "yeah", "hmm", "okay"...),
+// several prosodic variants each, held as PCM at the playback rate. Spawning
+// Piper for a 300 ms clip costs a process and a model load and lands too late
+// to sound natural; a cached clip is mixed into the speaker stream at once.
+//
+// Clips are synthesized once and kept as raw s16 files in a directory, so later
+// startups only read them.
+class ClipCache {
+public:
+    struct Spec {
+        std::string type;   // "generic", "agreement", "thinking", "acknowledge", "filler"
+        std::string text;   // What Piper says (punctuation shapes the intonation)
+        float length_scale; // Piper speed: < 1 clipped, > 1 drawn out
+    };
+
+    // Synthesizes text at the cache's sample rate; empty on failure
+    using Synth = std::function<std::vector<int16_t>(const std::string& text, float length_scale)>;
+
+    static const std::vector<Spec>& catalog();
+
+    // Loads every catalog clip from dir, synthesizing (and saving) the missing
+    // ones. Returns how many clips are available.
+    size_t load(const std::string& dir, int sample_rate, Synth synth, float gain = 0.6f);
+
+    bool has(const std::string& type) const;
+    // A random variant of type, never the same one twice in a row (null if none).
+    // Clips live as long as the cache.
+    const std::vector<int16_t>* pick(const std::string& type);
+    // A specific phrase, e.g. "Let me think." (null if not cached)
+    const std::vector<int16_t>* find(const std::string& text) const;
+
+    size_t size() const { return clips.size(); }
+
+private:
+    struct Clip {
+        Spec spec;
+        std::vector<int16_t> pcm;
+    };
+    std::vector<Clip> clips; // Fixed after load(), so pointers into it stay valid
+    std::map<std::string, std::vector<size_t>> by_type;
+
+    std::mutex mtx; // pick() state
+    std::map<std::string, size_t> last_pick;
+    uint32_t rng = 0x2545F491u;
+
+    static std::string fileName(const Spec& spec, int sample_rate);
+    // Drops Piper's leading/trailing silence, fades the edges and applies gain
+    static void shape(std::vector<int16_t>& pcm, int sample_rate, float gain);
+};
+
+#endif // CLIP_CACHE_H
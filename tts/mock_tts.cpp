@@ -0,0 +1,46 @@
+#include "mock_tts.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+MockTTS::MockTTS(double r, double first_ms, double cps)
+    : rtf(r), first_chunk_ms(first_ms), chars_per_second(cps > 0.0 ? cps : 15.0) {}
+
+std::vector<int16_t> MockTTS::synthesize(const std::string& text, TraceId trace) {
+    auto& monitor = PerfMonitor::getInstance();
+    double audio_s = text.size() / chars_per_second;
+    double synth_ms = rtf * audio_s * 1000.0;
+    double first_ms = std::min(first_chunk_ms, synth_ms);
+
+    Span first_sample = monitor.startSpan(trace, "tts_first_sample");
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)(first_ms * 1000.0)));
+    monitor.endSpan(first_sample);
+    std::this_thread::sleep_for(std::chrono::microseconds((int64_t)((synth_ms - first_ms) * 1000.0)));
+
+    lastAudioSec = audio_s;
+    return std::vector<int16_t>((size_t)(audio_s * kSampleRate), 0);
+}
+
+void MockTTS::speak(const std::string& text, TraceId trace, std::vector<int16_t>* synthesized, bool normalized) {
+    (void)normalized; // Nothing to normalize: the text only sets the audio length
+    if (text.empty()) return;
+    stopped = false;
+    std::vector<int16_t> pcm = synthesize(text, trace);
+    PerfMonitor::getInstance().mark(trace, "playback_start");
+    if (synthesized) *synthesized = std::move(pcm);
+    if (!playbackEnabled) return;
+
+    // "Play" in 20 ms slices so an interrupt lands quickly
+    auto end = std::chrono::steady_clock::now() + std::chrono::microseconds((int64_t)(lastAudioSec * 1e6));
+    while (!stopped && std::chrono::steady_clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+}
+
+void MockTTS::playBackchannel(const std::string& type) {
+    (void)type; // Fire and forget, like the real one
+}
+
+void MockTTS::stop() {
+    stopped = true;
+}
@@ -0,0 +1,37 @@
+#ifndef MOCK_TTS_H
+#define MOCK_TTS_H
+
+#include "tts_backend.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Stand-in for SimpleTTS: "synthesizes" silence at a fixed real-time factor
+// (audio length estimated from the text) and, with playback on, blocks for the
+// audio's duration the way ffplay would. stop() cuts playback short.
+class MockTTS : public TTSBackend {
+public:
+    static const int kSampleRate = 22050;
+
+    MockTTS(double rtf = 0.1, double first_chunk_ms = 80.0, double chars_per_second = 15.0);
+
+    void speak(const std::string& text, TraceId trace = 0, std::vector<int16_t>* synthesized = nullptr,
+               bool normalized = false) override;
+    void playBackchannel(const std::string& type) override;
+    void stop() override;
+
+    void setPlaybackEnabled(bool enabled) override { playbackEnabled = enabled; }
+    double lastAudioSeconds() const override { return lastAudioSec; }
+
+    std::vector<int16_t> synthesize(const std::string& text, TraceId trace = 0);
+
+private:
+    double rtf;
+    double first_chunk_ms;
+    double chars_per_second;
+    bool playbackEnabled = true;
+    double lastAudioSec = 0.0;
+    std::atomic<bool> stopped{false};
+};
+
+#endif // MOCK_TTS_H
@@ -0,0 +1,251 @@
+#include "response_cache.h"
+#include "text_normalizer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+// On-disk entry: header, key bytes (padded to even), then s16 PCM
+const char kMagic[4] = {'V', 'A', 'R', 'C'};
+const uint32_t kVersion = 2; // 2: keys are TextNormalizer output
+
+struct DiskHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sample_rate;
+    uint32_t key_len;
+    uint64_t samples;
+};
+
+size_t pcmOffset(size_t key_len) {
+    return (sizeof(DiskHeader) + key_len + 1) & ~(size_t)1;
+}
+} // namespace
+
+ResponseCache::ResponseCache() : ResponseCache(Config()) {}
+
+ResponseCache::ResponseCache(const Config& cfg) : config(cfg) {
+    if (config.dir.empty()) return;
+    std::error_code ec;
+    fs::create_directories(config.dir, ec);
+    for (const auto& e : fs::directory_iterator(config.dir, ec)) {
+        if (e.path().extension() == ".tmp") fs::remove(e.path(), ec); // Crashed mid-write
+        else if (e.path().extension() == ".pcm") disk_used += (size_t)e.file_size(ec);
+    }
+}
+
+std::string ResponseCache::normalize(const std::string& text) {
+    return TextNormalizer::normalize(text);
+}
+
+bool ResponseCache::cacheable(const std::string& normalized) const {
+    return !normalized.empty() && normalized.size() <= config.max_chars;
+}
+
+std::string ResponseCache::makeKey(const std::string& normalized, const std::string& voice) {
+    return voice + '\x1f' + normalized;
+}
+
+std::string ResponseCache::pathFor(const std::string& key) const {
+    uint64_t h = 1469598103934665603ull; // FNV-1a; the full key is checked on load
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx.pcm", (unsigned long long)h);
+    return (fs::path(config.dir) / name).string();
+}
+
+ResponseCache::AudioPtr ResponseCache::lookup(const std::string& normalized, const std::string& voice) {
+    std::string key = makeKey(normalized, voice);
+    AudioPtr audio;
+    bool persist = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            Entry& e = *it->second;
+            e.uses++;
+            audio = e.audio;
+            // Asked for again: worth keeping across restarts
+            if (!e.on_disk && !config.dir.empty() && e.uses >= config.disk_after_uses) {
+                e.on_disk = true;
+                persist = true;
+            }
+            counters.memory_hits++;
+        }
+    }
+    if (audio) {
+        if (persist) writeDisk(key, *audio);
+        return audio;
+    }
+
+    if (!config.dir.empty()) audio = readDisk(key);
+    std::lock_guard<std::mutex> lock(mtx);
+    if (audio) {
+        counters.disk_hits++;
+        remember(key, audio, true);
+    } else {
+        counters.misses++;
+    }
+    return audio;
+}
+
+void ResponseCache::insert(const std::string& normalized, const std::string& voice, std::vector<int16_t> pcm,
+                           int sample_rate) {
+    if (!cacheable(normalized) || pcm.empty()) return;
+    std::string key = makeKey(normalized, voice);
+
+    std::shared_ptr<Audio> audio = std::make_shared<Audio>();
+    audio->owned = std::move(pcm);
+    audio->pcm = audio->owned.data();
+    audio->samples = audio->owned.size();
+    audio->sample_rate = sample_rate;
+
+    bool persist = !config.dir.empty() && config.disk_after_uses <= 1;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (index.count(key)) return; // Another session got there first
+        remember(key, audio, persist);
+        counters.inserts++;
+    }
+    if (persist) writeDisk(key, *audio);
+}
+
+void ResponseCache::remember(const std::string& key, AudioPtr audio, bool on_disk) {
+    Entry e;
+    e.key = key;
+    e.bytes = audio->samples * sizeof(int16_t);
+    e.audio = std::move(audio);
+    e.uses = 1;
+    e.on_disk = on_disk;
+    memory_used += e.bytes;
+    lru.push_front(std::move(e));
+    index[key] = lru.begin();
+    trimMemory();
+}
+
+void ResponseCache::trimMemory() {
+    // Evicted audio still playing stays alive through its AudioPtr
+    while (memory_used > config.memory_bytes && lru.size() > 1) {
+        Entry& victim = lru.back();
+        memory_used -= victim.bytes;
+        index.erase(victim.key);
+        lru.pop_back();
+    }
+}
+
+ResponseCache::AudioPtr ResponseCache::readDisk(const std::string& key) const {
+    std::string path = pathFor(key);
+    std::shared_ptr<Audio> audio = std::make_shared<Audio>();
+    if (!audio->file.open(path)) return nullptr;
+
+    const uint8_t* data = audio->file.data();
+    size_t size = audio->file.size();
+    DiskHeader h;
+    if (size < sizeof(h)) return nullptr;
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion || h.key_len != key.size()) return nullptr;
+    size_t offset = pcmOffset(h.key_len);
+    if (size < offset || (size - offset) / sizeof(int16_t) < h.samples) return nullptr;
+    if (std::memcmp(data + sizeof(h), key.data(), key.size()) != 0) return nullptr; // Hash collision
+
+    audio->pcm = (const int16_t*)(data + offset);
+    audio->samples = (size_t)h.samples;
+    audio->sample_rate = (int)h.sample_rate;
+
+    // Disk eviction goes by age, so a hit counts as fresh
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return audio;
+}
+
+bool ResponseCache::writeDisk(const std::string& key, const Audio& audio) {
+    std::string path = pathFor(key);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        DiskHeader h;
+        std::memcpy(h.magic, kMagic, 4);
+        h.version = kVersion;
+        h.sample_rate = (uint32_t)audio.sample_rate;
+        h.key_len = (uint32_t)key.size();
+        h.samples = audio.samples;
+        out.write((const char*)&h, sizeof(h));
+        out.write(key.data(), (std::streamsize)key.size());
+        if ((sizeof(h) + key.size()) & 1) out.put('\0');
+        out.write((const char*)audio.pcm, (std::streamsize)(audio.samples * sizeof(int16_t)));
+        if (!out) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+
+    bool over;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        disk_used += pcmOffset(key.size()) + audio.samples * sizeof(int16_t);
+        over = disk_used > config.disk_bytes;
+    }
+    if (over) trimDisk();
+    return true;
+}
+
+void ResponseCache::trimDisk() {
+    struct File {
+        fs::file_time_type time;
+        size_t size;
+        fs::path path;
+    };
+    std::vector<File> files;
+    std::error_code ec;
+    size_t total = 0;
+    for (const auto& e : fs::directory_iterator(config.dir, ec)) {
+        if (e.path().extension() != ".pcm") continue;
+        File f{e.last_write_time(ec), (size_t)e.file_size(ec), e.path()};
+        total += f.size;
+        files.push_back(std::move(f));
+    }
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+
+    // Oldest first, down to 90% so the next few writes don't trim again
+    size_t target = config.disk_bytes / 10 * 9;
+    for (const File& f : files) {
+        if (total <= target) break;
+        if (fs::remove(f.path, ec)) total -= f.size; // A mapped file may refuse (Windows); skip it
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    disk_used = total;
+    // Entries whose file is gone get written again on their next reuse
+    for (Entry& e : lru) {
+        if (e.on_disk && !fs::exists(pathFor(e.key), ec)) e.on_disk = false;
+    }
+}
+
+ResponseCache::Stats ResponseCache::stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    Stats s = counters;
+    s.memory_bytes = memory_used;
+    s.disk_bytes = disk_used;
+    return s;
+}
+
+std::string ResponseCache::statsLine() const {
+    Stats s = stats();
+    std::ostringstream out;
+    out << "tts_cache: " << s.memory_hits << " memory hits, " << s.disk_hits << " disk hits, " << s.misses
+        << " misses, " << (s.memory_bytes >> 20) << " MB in memory, " << (s.disk_bytes >> 20) << " MB on disk";
+    return out.str();
+}
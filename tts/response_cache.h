@@ -0,0 +1,97 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "../utils/mapped_file.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Synthesized agent audio keyed by (normalized text, voice). Greetings,
+// confirmations, apologies and other stock answers come back again and again,
+// across turns and sessions; a hit skips Piper entirely and starts instantly.
+//
+// Two tiers:
+//  - memory: LRU bounded by bytes
+//  - disk:   one file per entry under dir, memory-mapped on a hit (the page
+//            cache keeps hot entries resident), written once a response has
+//            been asked for disk_after_uses times so one-offs don't churn it
+//
+// Thread-safe; one instance is shared by every TTSEngine.
+class ResponseCache {
+public:
+    struct Config {
+        size_t memory_bytes = 64u << 20;
+        size_t disk_bytes = 512u << 20;
+        std::string dir = "tts_cache"; // Empty: memory tier only
+        size_t max_chars = 240;        // Longer responses are one-offs
+        int disk_after_uses = 2;
+    };
+
+    // Immutable once published; owns its samples or the mapping they live in
+    struct Audio {
+        const int16_t* pcm = nullptr;
+        size_t samples = 0;
+        int sample_rate = 0;
+        std::vector<int16_t> owned;
+        MappedFile file;
+    };
+    using AudioPtr = std::shared_ptr<const Audio>;
+
+    struct Stats {
+        uint64_t memory_hits = 0;
+        uint64_t disk_hits = 0;
+        uint64_t misses = 0;
+        uint64_t inserts = 0;
+        size_t memory_bytes = 0;
+        size_t disk_bytes = 0;
+    };
+
+    ResponseCache();
+    explicit ResponseCache(const Config& config);
+
+    // The cache key's text part: exactly what Piper is given (TextNormalizer),
+    // case and all -- "Dr. Smith" and "dr. smith" don't sound the same
+    static std::string normalize(const std::string& text);
+    bool cacheable(const std::string& normalized) const;
+
+    // null on a miss
+    AudioPtr lookup(const std::string& normalized, const std::string& voice);
+    void insert(const std::string& normalized, const std::string& voice, std::vector<int16_t> pcm, int sample_rate);
+
+    Stats stats() const;
+    std::string statsLine() const;
+
+private:
+    struct Entry {
+        std::string key;
+        AudioPtr audio;
+        size_t bytes = 0;
+        int uses = 0;
+        bool on_disk = false;
+    };
+
+    Config config;
+    mutable std::mutex mtx;
+    std::list<Entry> lru; // Most recent first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t memory_used = 0;
+    size_t disk_used = 0;
+    Stats counters;
+
+    static std::string makeKey(const std::string& normalized, const std::string& voice);
+    std::string pathFor(const std::string& key) const;
+
+    // mtx held
+    void remember(const std::string& key, AudioPtr audio, bool on_disk);
+    void trimMemory();
+
+    AudioPtr readDisk(const std::string& key) const;
+    bool writeDisk(const std::string& key, const Audio& audio);
+    void trimDisk();
+};
+
+#endif // RESPONSE_CACHE_H
@@ -1,4 +1,8 @@
 #include "simple_tts.h"
+#include "text_normalizer.h"
+#include "../utils/perf_monitor.h"
+#include "../audio/playback_buffer.h"
+#include "../audio/resampler.h"
 #include <iostream>
 #include <cstdlib>
 #include <cstdio>
@@ -9,9 +13,13 @@
 #ifdef _WIN32
 #define POPEN _popen
 #define PCLOSE _pclose
+#define POPEN_READ "rb"
+static const std::string CAT_CMD = "type ";
 #else
 #define POPEN popen
 #define PCLOSE pclose
+#define POPEN_READ "r"
+static const std::string CAT_CMD = "cat ";
 #endif
 
 namespace fs = std::filesystem;
@@ -30,6 +38,8 @@ SimpleTTS::~SimpleTTS() {
 }
 
 void SimpleTTS::stop() {
+    stopRequested = true;
+    if (playbackOutput) playbackOutput->flush();
 #ifdef _WIN32
     system("taskkill /F /IM ffplay.exe /T > NUL 2>&1");
     // We don't kill piper because it usually exits after input. 
@@ -38,66 +48,40 @@ void SimpleTTS::stop() {
 #endif
 }
 
-void SimpleTTS::speak(const std::string& text) {
-    if (text.empty()) return;
-    
-    // Clean text / preprocessing
-    // Clean text / preprocessing
-    std::string clean = text;
-
-    // 1. Truncate at common stop tokens (found early or late)
-    std::vector<std::string> stops = {"<|im_end|>", "<|im_end", "|im_end", "im_end", "assistant", "system", "user"};
-    for (const auto& s : stops) {
-        size_t p = clean.find(s);
-        if (p != std::string::npos) {
-            clean = clean.substr(0, p);
-        }
-    }
+std::string SimpleTTS::cleanText(const std::string& text) {
+    ScopedSpan normalize_span(0, "tts_normalize");
+    return TextNormalizer::normalize(text);
+}
 
-    // 2. Remove ANY remaining <|...|> or similar brackets if they somehow survived
-    size_t lt = clean.find("<");
-    if (lt != std::string::npos) {
-        clean = clean.substr(0, lt);
-    }
+std::string SimpleTTS::writeInputFile(const std::string& clean) {
+    // Write to a temp file and read from it to avoid shell escaping hell.
+    // One file per call so concurrent sessions don't overwrite each other.
+    static std::atomic<uint64_t> counter{0};
+    std::string tempTextFile = "tts_input_" + std::to_string(counter++ % 1024) + ".txt";
+    std::ofstream ofs(tempTextFile);
+    ofs << clean;
+    ofs.close();
+    return tempTextFile;
+}
 
-    // 2. Remove [tags] (e.g. [laughter], [metrics])
-    // Simple regex-like replacement: loop and remove
-    bool inside_bracket = false;
-    std::string no_brackets = "";
-    for (char c : clean) {
-        if (c == '[') inside_bracket = true;
-        else if (c == ']') inside_bracket = false;
-        else if (!inside_bracket) no_brackets += c;
-    }
-    clean = no_brackets;
-
-    // 3. Remove Hashtags? (User said "DONT ADD TAGS", assuming #funny should be removed or just the #)
-    // Let's remove words starting with # if they look like metadata tags
-    // Or just remove the # character itself so it speaks the word? 
-    // Usually metadata hashtags come at the end. 
-    // Simplest approach: Remove any '#' character.
-    clean.erase(std::remove(clean.begin(), clean.end(), '#'), clean.end());
-
-    // 4. Remove Non-ASCII (Emojis)
-    // Piper might choke on them or speak them weirdly.
-    std::string ascii_only = "";
-    for (char c : clean) {
-        // Allow basic ASCII printable (32-126) and newlines
-        if ((unsigned char)c < 128) {
-             ascii_only += c;
-        }
+void SimpleTTS::speak(const std::string& text, TraceId trace, std::vector<int16_t>* synthesized, bool normalized) {
+    if (text.empty()) return;
+    if (!playbackEnabled) {
+        // Headless: the audio "plays" as soon as Piper hands over its first chunk
+        bool first = true;
+        synthesize(text, trace, [&](const int16_t* pcm, size_t n) {
+            if (first) PerfMonitor::getInstance().mark(trace, "playback_start");
+            first = false;
+            if (synthesized) synthesized->insert(synthesized->end(), pcm, pcm + n);
+            return true;
+        }, 0.0f, normalized);
+        return;
     }
-    clean = ascii_only;
-
-    // Remove asterisks (*) often used for actions *waves*
-    clean.erase(std::remove(clean.begin(), clean.end(), '*'), clean.end());
-
-    // Basic quote escaping for command line
-    size_t pos = 0;
-    while ((pos = clean.find("\"", pos)) != std::string::npos) {
-        clean.replace(pos, 1, "\\\"");
-        pos += 2;
+    if (playbackOutput) {
+        speakToOutput(text, trace, synthesized, normalized);
+        return;
     }
+    std::string clean = normalized ? text : cleanText(text);
 
     // Prepare Piper Command
     // We use 22050Hz for Lessac Medium
@@ -105,25 +89,148 @@ void SimpleTTS::speak(const std::string& text) {
     
     // Construct the full command
     // We use a temporary file or just echo. Echo -e or similar isn't available on standard cmd.
-    // For Windows, echo "text" works reasonably well if text is simple.
-    // Better: write to a temp file and read from it to avoid shell escaping hell.
-    
-    std::string tempTextFile = "tts_input.txt";
-    std::ofstream ofs(tempTextFile);
-    ofs << clean;
-    ofs.close();
+    std::string tempTextFile = writeInputFile(clean);
 
-    cmd = "type " + tempTextFile + " | " + piperPath + 
-          " --model " + modelPath + " --output_raw | ffplay -f s16le -ar 22050 -nodisp - -autoexit";
+    cmd = CAT_CMD + tempTextFile + " | " + piperPath + " --model " + modelPath;
+    if (lengthScale > 0.0f) cmd += " --length_scale " + std::to_string(lengthScale);
+    cmd += " --output_raw | ffplay -f s16le -ar 22050 -nodisp - -autoexit";
 
     std::cout << "[SimpleTTS] Speaking: " << clean << std::endl;
     std::cout << "[SimpleTTS] Executing: " << cmd << std::endl;
     
     // Use system() instead of popen for the complex pipe to simplify
+    // (synthesis and playback both happen inside this pipeline, so this is
+    // as close to the first sample as we can see)
+    PerfMonitor::getInstance().mark(trace, "playback_start");
+    ScopedSpan synth_span(0, "piper_synth_playback");
     system(cmd.c_str());
 }
 
+void SimpleTTS::speakToOutput(const std::string& text, TraceId trace, std::vector<int16_t>* synthesized,
+                              bool normalized) {
+    stopRequested = false;
+    std::cout << "[SimpleTTS] Speaking: " << text << std::endl;
+
+    // Piper's chunks go straight into the speaker ring as they arrive; write()
+    // blocks while the ring is full, which paces Piper to real time
+    Resampler resampler(kSampleRate, playbackOutput->sampleRate());
+    std::vector<int16_t> resampled;
+    bool complete = true;
+    bool started = false;
+    ScopedSpan synth_span(0, "piper_synth_playback");
+    synthesize(text, trace, [&](const int16_t* pcm, size_t n) {
+        if (synthesized) synthesized->insert(synthesized->end(), pcm, pcm + n);
+        resampled.clear();
+        resampler.process(pcm, n, resampled);
+        bool first = !started;
+        complete = playbackOutput->write(resampled.data(), resampled.size(), stopRequested);
+        started = true;
+        // Queued for the next audio callback: what the user hears from
+        if (first && complete) PerfMonitor::getInstance().mark(trace, "playback_start");
+        return complete;
+    }, 0.0f, normalized);
+    if (synthesized && !complete) synthesized->clear();
+    playbackOutput->drain(stopRequested);
+}
+
+std::string SimpleTTS::voice() const {
+    return "piper:" + modelPath + "@" + std::to_string(lengthScale);
+}
+
+std::string SimpleTTS::voiceId() const {
+    if (playbackEnabled && !playbackOutput) return "";
+    return voice();
+}
+
+bool SimpleTTS::playPcm(const int16_t* pcm, size_t samples, TraceId trace) {
+    if (playbackEnabled && !playbackOutput) return false;
+    lastAudioSec = (double)samples / kSampleRate;
+    if (!playbackEnabled) {
+        PerfMonitor::getInstance().mark(trace, "playback_start");
+        return true;
+    }
+
+    stopRequested = false;
+    Resampler resampler(kSampleRate, playbackOutput->sampleRate());
+    std::vector<int16_t> resampled;
+    ScopedSpan play_span(0, "cached_playback");
+    // Chunked like Piper's output, so the first block plays right away
+    for (size_t pos = 0; pos < samples; pos += 1024) {
+        resampled.clear();
+        resampler.process(pcm + pos, std::min<size_t>(1024, samples - pos), resampled);
+        if (!playbackOutput->write(resampled.data(), resampled.size(), stopRequested)) return true;
+        if (pos == 0) PerfMonitor::getInstance().mark(trace, "playback_start");
+    }
+    playbackOutput->drain(stopRequested);
+    return true;
+}
+
+std::vector<int16_t> SimpleTTS::synthesize(const std::string& text, TraceId trace, ChunkCallback on_chunk,
+                                           float length_scale, bool normalized) {
+    std::vector<int16_t> pcm;
+    lastAudioSec = 0.0;
+    if (text.empty()) return pcm;
+
+    auto& monitor = PerfMonitor::getInstance();
+    std::string clean = normalized ? text : cleanText(text);
+    std::string cmd = CAT_CMD + writeInputFile(clean) + " | " + piperPath +
+                      " --model " + modelPath + " --output_raw";
+    if (length_scale <= 0.0f) length_scale = lengthScale;
+    if (length_scale > 0.0f) cmd += " --length_scale " + std::to_string(length_scale);
+
+    Span first_sample = monitor.startSpan(trace, "tts_first_sample");
+    ScopedSpan synth_span(trace, "piper_synth");
+    FILE* pipe = POPEN(cmd.c_str(), POPEN_READ);
+    if (!pipe) {
+        std::cerr << "[SimpleTTS] Could not start piper" << std::endl;
+        return pcm;
+    }
+
+    // Small reads when streaming so the first chunk leaves as early as possible
+    int16_t buf[4096];
+    size_t want = on_chunk ? 1024 : 4096;
+    size_t n;
+    size_t samples = 0;
+    bool first = true;
+    while ((n = fread(buf, sizeof(int16_t), want, pipe)) > 0) {
+        if (first) {
+            monitor.endSpan(first_sample);
+            first = false;
+        }
+        samples += n;
+        if (on_chunk) {
+            if (!on_chunk(buf, n)) break;
+        } else {
+            pcm.insert(pcm.end(), buf, buf + n);
+        }
+    }
+    PCLOSE(pipe);
+
+    lastAudioSec = (double)samples / kSampleRate;
+    return pcm;
+}
+
+size_t SimpleTTS::loadClips(const std::string& dir) {
+    if (!playbackOutput) return 0;
+    int rate = playbackOutput->sampleRate();
+    return clips.load(dir, rate, [this, rate](const std::string& text, float length_scale) {
+        std::vector<int16_t> pcm = synthesize(text, 0, nullptr, length_scale);
+        std::vector<int16_t> out;
+        Resampler resampler(kSampleRate, rate);
+        resampler.process(pcm.data(), pcm.size(), out);
+        return out;
+    });
+}
+
+bool SimpleTTS::playClip(const std::string& type, bool crossfade) {
+    if (!playbackOutput || !playbackEnabled) return false;
+    const std::vector<int16_t>* clip = clips.pick(type);
+    return clip && playbackOutput->mix(clip->data(), clip->size(), crossfade);
+}
+
 void SimpleTTS::playBackchannel(const std::string& type) {
+    if (playClip(clips.has(type) ? type : "generic")) return;
+
     std::string text = "uh-huh";
     if (type == "agreement") text = "yeah";
     if (type == "thinking") text = "hmm";
@@ -1,23 +1,85 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
+#include "tts_backend.h"
+#include "clip_cache.h"
+#include "../utils/perf_monitor.h"
 
-class SimpleTTS {
+class PlaybackBuffer;
+
+class SimpleTTS : public TTSBackend {
 public:
     SimpleTTS();
     ~SimpleTTS();
 
+    static const int kSampleRate = 22050; // Lessac Medium
+
     // Text-to-Speech execution (fire and forget or blocking depending on implementation)
-    void speak(const std::string& text);
+    void speak(const std::string& text, TraceId trace = 0, std::vector<int16_t>* synthesized = nullptr,
+               bool normalized = false) override;
+
+    // Receives PCM as Piper produces it; return false to stop early
+    using ChunkCallback = std::function<bool(const int16_t* pcm, size_t samples)>;
+
+    // Runs Piper and returns the raw 16-bit PCM instead of playing it.
+    // Records the turn's "tts_first_sample" span when the first audio arrives.
+    // With on_chunk the audio is streamed to it and nothing is returned.
+    // Safe to call from several threads at once (one Piper process per call).
+    // length_scale > 0 overrides the speed set with setLengthScale().
+    // normalized: skip cleanText(), the caller already normalized the text.
+    std::vector<int16_t> synthesize(const std::string& text, TraceId trace = 0, ChunkCallback on_chunk = nullptr,
+                                    float length_scale = 0.0f, bool normalized = false);
+
+    // Play through the duplex audio stream instead of ffplay, resampled to its
+    // rate. The microphone side then has the exact playback signal as the echo
+    // canceller reference, and stop() cuts the audio within one callback.
+    void setPlaybackOutput(PlaybackBuffer* output) { playbackOutput = output; }
+
+    // Backchannels from pre-synthesized clips (see ClipCache), mixed into the
+    // playback output. Needs setPlaybackOutput() first; synthesizes whatever
+    // dir doesn't have yet, so the first run takes a few seconds.
+    size_t loadClips(const std::string& dir);
+    ClipCache& clipCache() { return clips; }
+
+    // With playback off, speak() only synthesizes (benchmarks, headless runs)
+    void setPlaybackEnabled(bool enabled) override { playbackEnabled = enabled; }
+    double lastAudioSeconds() const override { return lastAudioSec; }
+
+    // Piper --length_scale (0 = the voice's default)
+    void setLengthScale(float scale) { lengthScale = scale; }
+    // Model and speed: what the audio sounds like, for cache keys
+    std::string voice() const;
+
+    // Cacheable unless playing through ffplay, which never hands back the audio
+    std::string voiceId() const override;
+    int sampleRate() const override { return kSampleRate; }
+    bool playPcm(const int16_t* pcm, size_t samples, TraceId trace = 0) override;
+
+    // Stop tokens, tags, emojis and markdown out; numbers, abbreviations and
+    // units spelled out (see TextNormalizer)
+    std::string cleanText(const std::string& text);
     
-    // Quick backchannel response
-    void playBackchannel(const std::string& type);
+    // Quick backchannel response: a cached clip when there is one, else Piper + ffplay
+    void playBackchannel(const std::string& type) override;
+    // Cached clips only (needs loadClips())
+    bool playClip(const std::string& type, bool crossfade = false) override;
     
     // Stop current playback
-    void stop();
+    void stop() override;
 
 private:
      std::string piperPath;
      std::string modelPath;
+     bool playbackEnabled = true;
+     float lengthScale = 0.0f;
+     PlaybackBuffer* playbackOutput = nullptr;
+     ClipCache clips;
+     std::atomic<bool> stopRequested{false};
+     std::atomic<double> lastAudioSec{0.0};
      void execute_command(const std::string& cmd);
+     void speakToOutput(const std::string& text, TraceId trace, std::vector<int16_t>* synthesized, bool normalized);
+     std::string writeInputFile(const std::string& clean);
 };
@@ -0,0 +1,569 @@
+#include "text_normalizer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+const char kDegree = '\x01'; // Stands in for UTF-8 '°' inside a word
+
+const char* kOnes[] = {"zero",    "one",     "two",       "three",    "four",     "five",    "six",
+                       "seven",   "eight",   "nine",      "ten",      "eleven",   "twelve",  "thirteen",
+                       "fourteen", "fifteen", "sixteen",  "seventeen", "eighteen", "nineteen"};
+const char* kTens[] = {"", "", "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety"};
+const char* kScales[] = {"", " thousand", " million", " billion", " trillion"};
+
+struct Unit {
+    const char* symbol; // Case matters: "5G" isn't five grams
+    const char* one;
+    const char* many;
+    bool standalone;    // Also as a word of its own ("5 km"); single letters only attached ("5m")
+};
+
+const Unit kUnits[] = {
+    {"km", "kilometer", "kilometers", true},
+    {"m", "meter", "meters", false},
+    {"cm", "centimeter", "centimeters", true},
+    {"mm", "millimeter", "millimeters", true},
+    {"mi", "mile", "miles", true},
+    {"ft", "foot", "feet", true},
+    {"kg", "kilogram", "kilograms", true},
+    {"g", "gram", "grams", false},
+    {"mg", "milligram", "milligrams", true},
+    {"lb", "pound", "pounds", true},
+    {"lbs", "pound", "pounds", true},
+    {"oz", "ounce", "ounces", true},
+    {"L", "liter", "liters", false},
+    {"ml", "milliliter", "milliliters", true},
+    {"mL", "milliliter", "milliliters", true},
+    {"ms", "millisecond", "milliseconds", true},
+    {"s", "second", "seconds", false},
+    {"sec", "second", "seconds", true},
+    {"min", "minute", "minutes", true},
+    {"h", "hour", "hours", false},
+    {"hr", "hour", "hours", true},
+    {"hrs", "hour", "hours", true},
+    {"mph", "mile per hour", "miles per hour", true},
+    {"km/h", "kilometer per hour", "kilometers per hour", true},
+    {"kph", "kilometer per hour", "kilometers per hour", true},
+    {"KB", "kilobyte", "kilobytes", true},
+    {"kB", "kilobyte", "kilobytes", true},
+    {"MB", "megabyte", "megabytes", true},
+    {"GB", "gigabyte", "gigabytes", true},
+    {"TB", "terabyte", "terabytes", true},
+    {"Hz", "hertz", "hertz", true},
+    {"kHz", "kilohertz", "kilohertz", true},
+    {"MHz", "megahertz", "megahertz", true},
+    {"GHz", "gigahertz", "gigahertz", true},
+    {"W", "watt", "watts", false},
+    {"kW", "kilowatt", "kilowatts", true},
+    {"kWh", "kilowatt hour", "kilowatt hours", true},
+    {"am", "A M", "A M", true},
+    {"pm", "P M", "P M", true},
+    {"AM", "A M", "A M", true},
+    {"PM", "P M", "P M", true},
+    {"\x01", "degree", "degrees", true},
+    {"\x01" "C", "degree Celsius", "degrees Celsius", true},
+    {"\x01" "F", "degree Fahrenheit", "degrees Fahrenheit", true},
+};
+
+struct Abbreviation {
+    const char* text;  // A trailing '.' matches the word's period
+    const char* spoken;
+    bool keep_period;  // The period may also end the sentence
+};
+
+const Abbreviation kAbbreviations[] = {
+    {"e.g.", "for example", false},
+    {"E.g.", "For example", false},
+    {"i.e.", "that is", false},
+    {"I.e.", "That is", false},
+    {"etc.", "et cetera", true},
+    {"vs.", "versus", false},
+    {"vs", "versus", false},
+    {"approx.", "approximately", false},
+    {"a.m.", "A M", false},
+    {"p.m.", "P M", false},
+    {"Dr.", "Doctor", false},
+    {"Mr.", "Mister", false},
+    {"Mrs.", "Missus", false},
+    {"Ms.", "Miz", false},
+    {"Prof.", "Professor", false},
+    {"Jr.", "Junior", true},
+    {"&", "and", false},
+    {"w/", "with", false},
+    {"w/o", "without", false},
+};
+
+// Character classes, so the per-character loop is one lookup
+enum CharKind : uint8_t { kWordChar, kSpace, kNewline, kDrop, kEnd, kOpenTag, kHigh };
+enum PunctFlag : uint8_t { kLead = 1, kTail = 2, kStrip = 4 };
+
+struct CharTable {
+    uint8_t kind[256];
+    uint8_t punct[256];
+    CharTable() {
+        for (int c = 0; c < 256; ++c) {
+            kind[c] = c >= 0x80 ? kHigh : (c <= ' ' || c == 0x7f) ? kSpace : kWordChar;
+            punct[c] = 0;
+        }
+        kind[(int)'\n'] = kNewline;
+        kind[(int)'#'] = kDrop; // Hashtags
+        kind[(int)'*'] = kDrop; // Markdown emphasis
+        kind[(int)'<'] = kEnd;  // <|im_end|>, <|endoftext|>...
+        kind[(int)'['] = kOpenTag;
+        for (const char* p = "\"'([{"; *p; ++p) punct[(unsigned char)*p] |= kLead;
+        for (const char* p = ".,!?;:\"')]}"; *p; ++p) punct[(unsigned char)*p] |= kTail;
+        for (const char* p = "_|`~^\\\x01"; *p; ++p) punct[(unsigned char)*p] |= kStrip;
+    }
+};
+const CharTable kChars;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const Unit* findUnit(const char* b, size_t n, bool standalone) {
+    for (const Unit& u : kUnits) {
+        if (u.symbol[0] != *b || (standalone && !u.standalone) || std::strlen(u.symbol) != n) continue;
+        if (std::memcmp(u.symbol, b, n) == 0) return &u;
+    }
+    return nullptr;
+}
+
+void appendBelowThousand(unsigned n, std::string& out) {
+    if (n >= 100) {
+        out += kOnes[n / 100];
+        out += " hundred";
+        n %= 100;
+        if (n == 0) return;
+        out += ' ';
+    }
+    if (n >= 20) {
+        out += kTens[n / 10];
+        if (n % 10) {
+            out += '-';
+            out += kOnes[n % 10];
+        }
+    } else {
+        out += kOnes[n];
+    }
+}
+
+void appendCardinal(uint64_t n, std::string& out) {
+    if (n == 0) {
+        out += "zero";
+        return;
+    }
+    unsigned groups[5];
+    int count = 0;
+    while (n && count < 5) {
+        groups[count++] = (unsigned)(n % 1000);
+        n /= 1000;
+    }
+    bool first = true;
+    for (int i = count - 1; i >= 0; --i) {
+        if (groups[i] == 0) continue;
+        if (!first) out += ' ';
+        appendBelowThousand(groups[i], out);
+        out += kScales[i];
+        first = false;
+    }
+}
+
+// "1990" nineteen ninety, "1905" nineteen oh five, "1900" nineteen hundred
+void appendYear(unsigned n, std::string& out) {
+    appendBelowThousand(n / 100, out);
+    unsigned low = n % 100;
+    if (low == 0) {
+        out += " hundred";
+    } else if (low < 10) {
+        out += " oh ";
+        out += kOnes[low];
+    } else {
+        out += ' ';
+        appendBelowThousand(low, out);
+    }
+}
+
+bool isYear(uint64_t n) {
+    return (n >= 1100 && n <= 1999) || (n >= 2010 && n <= 2099);
+}
+
+// Turns the last number word in out into its ordinal
+void makeOrdinal(std::string& out) {
+    static const char* irregular[][2] = {{"one", "first"},  {"two", "second"}, {"three", "third"}, {"five", "fifth"},
+                                         {"eight", "eighth"}, {"nine", "ninth"}, {"twelve", "twelfth"}};
+    size_t start = out.find_last_of(" -");
+    start = start == std::string::npos ? 0 : start + 1;
+    for (const auto& pair : irregular) {
+        if (out.compare(start, std::string::npos, pair[0]) == 0) {
+            out.replace(start, std::string::npos, pair[1]);
+            return;
+        }
+    }
+    if (!out.empty() && out.back() == 'y') {
+        out.back() = 'i';
+        out += "eth";
+    } else {
+        out += "th";
+    }
+}
+
+// "ninety" -> "nineties", "nineteen hundred" -> "nineteen hundreds"
+void makePlural(std::string& out) {
+    if (!out.empty() && out.back() == 'y') {
+        out.back() = 'i';
+        out += "es";
+    } else {
+        out += 's';
+    }
+}
+
+// After the '-' of a range that starts with a year: "1990-2021", "1990-95"
+bool yearRangeEnd(const char* p, const char* e) {
+    uint64_t value = 0;
+    int digits = 0;
+    for (; p < e && isDigit(*p); ++p, ++digits) value = value * 10 + (uint64_t)(*p - '0');
+    if (p < e && (*p == ',' || *p == '.' || *p == ':')) return false;
+    return digits == 2 || (digits == 4 && isYear(value));
+}
+
+void appendDigits(const char* b, const char* e, std::string& out) {
+    bool first = true;
+    for (; b < e; ++b) {
+        if (!isDigit(*b)) continue;
+        if (!first) out += ' ';
+        out += kOnes[*b - '0'];
+        first = false;
+    }
+}
+
+// Plain word: markdown and code leftovers dropped, snake_case spaced out
+void appendRaw(const char* b, const char* e, std::string& out) {
+    while (b < e) {
+        const char* run = b;
+        while (b < e && !(kChars.punct[(unsigned char)*b] & kStrip)) b++;
+        out.append(run, b - run);
+        if (b == e) break;
+        if (*b++ == '_') out += ' ';
+    }
+}
+
+bool isRoleHeader(const char* w, size_t n, char delimiter) {
+    bool colon = n > 0 && w[n - 1] == ':';
+    if (colon) n--;
+    if (!colon && delimiter != '\n' && delimiter != 0) return false;
+    static const char* roles[] = {"user", "assistant", "system"};
+    for (const char* role : roles) {
+        if (std::strlen(role) != n) continue;
+        bool same = true;
+        for (size_t i = 0; i < n && same; ++i) same = std::tolower((unsigned char)w[i]) == role[i];
+        if (same) return true;
+    }
+    return false;
+}
+} // namespace
+
+bool TextNormalizer::push(const char* text, size_t n, std::string& out) {
+    for (size_t i = 0; i < n && !done; ++i) {
+        unsigned char c = (unsigned char)text[i];
+        if (in_bracket) { // [laughter], [metrics]
+            if (c == ']') in_bracket = false;
+            continue;
+        }
+        uint8_t kind = kChars.kind[c];
+        if (kind == kWordChar) {
+            // The whole run of word characters at once
+            size_t end = i + 1;
+            while (end < n && kChars.kind[(unsigned char)text[end]] == kWordChar) end++;
+            while (i < end) {
+                if (word_len == kWordMax) endWord(' ', out); // URL or similar: said in pieces
+                size_t take = std::min(end - i, kWordMax - word_len);
+                std::memcpy(word + word_len, text + i, take);
+                word_len += take;
+                i += take;
+            }
+            i--;
+            utf8_c2 = false;
+            continue;
+        }
+        switch (kind) {
+            case kHigh:
+                // Non-ASCII (emojis, mostly) is dropped; Piper says odd things for it
+                if (utf8_c2 && c == 0xB0) {
+                    if (word_len == kWordMax) endWord(' ', out);
+                    word[word_len++] = kDegree;
+                }
+                utf8_c2 = c == 0xC2;
+                continue;
+            case kSpace:
+                endWord((char)c, out);
+                if (!pending_space) pending_space = ' ';
+                break;
+            case kNewline:
+                endWord('\n', out);
+                line_start = true;
+                pending_space = '\n';
+                break;
+            case kEnd: // The response is over
+                endWord(0, out);
+                done = true;
+                break;
+            case kOpenTag:
+                endWord(' ', out);
+                in_bracket = true;
+                break;
+        }
+        utf8_c2 = false;
+    }
+    return !done;
+}
+
+void TextNormalizer::finish(std::string& out) {
+    if (!done) endWord(0, out);
+    pending_space = 0;
+}
+
+void TextNormalizer::reset() {
+    word_len = 0;
+    done = false;
+    in_bracket = false;
+    line_start = true;
+    utf8_c2 = false;
+    emitted = false;
+    pending_space = 0;
+    prev = Prev::Other;
+}
+
+std::string TextNormalizer::normalize(const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 4);
+    TextNormalizer normalizer;
+    normalizer.push(text, out);
+    normalizer.finish(out);
+    return out;
+}
+
+void TextNormalizer::space(std::string& out) {
+    if (pending_space && emitted) out += pending_space;
+    pending_space = 0;
+    emitted = true;
+}
+
+void TextNormalizer::endWord(char delimiter, std::string& out) {
+    if (word_len == 0) return;
+    size_t n = word_len;
+    word_len = 0;
+
+    static const char kImEnd[] = "im_end";
+    const char* hit = std::memchr(word, '_', n) ? std::search(word, word + n, kImEnd, kImEnd + 6) : word + n;
+    if (hit != word + n) {
+        size_t keep = hit - word;
+        while (keep > 0 && word[keep - 1] == '|') keep--;
+        if (keep > 0) speakWord(word, keep, out);
+        done = true;
+        return;
+    }
+    if (line_start && isRoleHeader(word, n, delimiter)) { // Model ran on into the next turn
+        done = true;
+        return;
+    }
+    speakWord(word, n, out);
+    line_start = false;
+}
+
+void TextNormalizer::speakWord(const char* w, size_t n, std::string& out) {
+    Prev before = prev;
+    prev = Prev::Other;
+    if (*w == '-' && std::all_of(w, w + n, [](char c) { return c == '-'; })) return; // List bullet, dash
+
+    // Punctuation around the word passes through as is
+    const char* b = w;
+    const char* e = w + n;
+    while (b < e && (kChars.punct[(unsigned char)*b] & kLead)) b++;
+    while (e > b && (kChars.punct[(unsigned char)e[-1]] & kTail)) e--;
+    const char* tail = e;
+
+    if (b == e) {
+        // Punctuation on its own sticks to the previous word
+        pending_space = 0;
+        emitted = true;
+        out.append(w, n);
+        return;
+    }
+
+    space(out);
+    size_t lead = b - w;
+    if (lead > 0 && b[-1] == '\'' && isDigit(*b)) lead--; // "'90s": the apostrophe isn't said
+    if (lead) out.append(w, lead);
+
+    const Unit* unit = nullptr;
+    bool spoken = false;
+    if (isDigit(*b) || (e - b > 1 && (*b == '$' || *b == '-') && (isDigit(b[1]) || b[1] == '$'))) {
+        spoken = speakNumber(b, e, out);
+    }
+    if (!spoken && before != Prev::Other && (unit = findUnit(b, e - b, true))) {
+        out += before == Prev::NumberOne ? unit->one : unit->many;
+        spoken = true;
+    }
+    bool period = tail < w + n && *tail == '.';
+    if (!spoken && (period || *b == '&' || *b == 'v' || *b == 'w')) { // Dotted, or one of the few without
+        for (const Abbreviation& a : kAbbreviations) {
+            if (a.text[0] != *b) continue;
+            size_t len = std::strlen(a.text);
+            bool dotted = a.text[len - 1] == '.';
+            if (dotted && (!period || (size_t)(e - b) != len - 1)) continue;
+            if (!dotted && (size_t)(e - b) != len) continue;
+            if (std::memcmp(a.text, b, e - b) != 0) continue;
+            out += a.spoken;
+            if (dotted && !a.keep_period) tail++;
+            spoken = true;
+            break;
+        }
+    }
+    if (!spoken) appendRaw(b, e, out);
+    if (tail != w + n) {
+        out.append(tail, w + n - tail);
+        prev = Prev::Other; // "5, km" isn't a measurement
+    }
+}
+
+bool TextNormalizer::speakNumber(const char* b, const char* e, std::string& out, bool allowYear) {
+    const char* p = b;
+    bool negative = false, currency = false;
+    if (p < e && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p < e && *p == '$') {
+        currency = true;
+        p++;
+    }
+    if (p == e || !isDigit(*p)) return false;
+
+    // Integer part, with thousands separators
+    const char* intBegin = p;
+    uint64_t value = 0;
+    int digits = 0;
+    bool grouped = false;
+    while (p < e) {
+        if (isDigit(*p)) {
+            if (digits < 18) value = value * 10 + (uint64_t)(*p - '0');
+            digits++;
+            p++;
+        } else if (*p == ',' && e - p >= 4 && isDigit(p[1]) && isDigit(p[2]) && isDigit(p[3]) &&
+                   (p + 4 == e || !isDigit(p[4]))) {
+            grouped = true;
+            p++;
+        } else {
+            break;
+        }
+    }
+    const char* intEnd = p;
+
+    // Fraction or clock time
+    const char* fracBegin = nullptr;
+    const char* fracEnd = nullptr;
+    int minutes = -1;
+    if (p + 1 < e && *p == '.' && isDigit(p[1])) {
+        fracBegin = ++p;
+        while (p < e && isDigit(*p)) p++;
+        fracEnd = p;
+    } else if (!grouped && value <= 24 && e - p >= 3 && *p == ':' && isDigit(p[1]) && isDigit(p[2]) &&
+               (p + 3 == e || !isDigit(p[3])) && (p[1] - '0') < 6) {
+        minutes = (p[1] - '0') * 10 + (p[2] - '0');
+        p += 3;
+    }
+    bool fraction = fracBegin != nullptr;
+    bool cents = currency && fraction && fracEnd - fracBegin == 2;
+
+    // Whatever follows says what kind of number it is
+    size_t sn = e - p;
+    bool percent = false, ordinal = false, range = false, decade = false;
+    const char* scale = nullptr;
+    const Unit* unit = nullptr;
+    if (sn > 0) {
+        char s0 = (char)std::tolower((unsigned char)p[0]);
+        char s1 = sn > 1 ? (char)std::tolower((unsigned char)p[1]) : 0;
+        if (sn == 1 && *p == '%') {
+            percent = true;
+        } else if (sn == 2 && !fraction && minutes < 0 &&
+                   ((s0 == 's' && s1 == 't') || (s0 == 'n' && s1 == 'd') || (s0 == 'r' && s1 == 'd') ||
+                    (s0 == 't' && s1 == 'h'))) {
+            ordinal = true;
+        } else if (*p == '-' && sn > 1 && (isDigit(p[1]) || p[1] == '$')) {
+            range = true;
+        } else if (((sn == 1 && s0 == 's') || (sn == 2 && *p == '\'' && s1 == 's')) && (digits == 2 || digits == 4) &&
+                   value >= 10 && value % 10 == 0 && !grouped && !currency && !negative && !fraction && minutes < 0) {
+            decade = true; // "the 1990s", "her 20s", "the '90s": not seconds
+        } else if (currency && sn == 1 && (*p == 'k' || *p == 'K')) {
+            scale = "thousand";
+        } else if (currency && sn == 1 && *p == 'M') {
+            scale = "million";
+        } else if (currency && ((sn == 1 && *p == 'B') || (sn == 2 && s0 == 'b' && s1 == 'n'))) {
+            scale = "billion";
+        } else if (!(unit = findUnit(p, sn, false))) {
+            return false; // "3D", "4x4": Piper can have those
+        }
+    }
+
+    bool year = false;
+    if (negative) out += "minus ";
+    if (digits > 15 || (digits > 1 && *intBegin == '0' && !grouped && minutes < 0)) {
+        appendDigits(intBegin, intEnd, out); // Codes, long IDs, "007"
+    } else if (minutes >= 0) {
+        appendCardinal(value, out);
+        if (minutes == 0 && !unit) {
+            out += " o'clock";
+        } else if (minutes > 0 && minutes < 10) {
+            out += " oh ";
+            out += kOnes[minutes];
+        } else if (minutes >= 10) {
+            out += ' ';
+            appendBelowThousand((unsigned)minutes, out);
+        }
+    } else if (digits == 4 && !grouped && !negative && !currency && !fraction && allowYear &&
+               (sn == 0 || decade || (range && yearRangeEnd(p + 1, e))) && isYear(value)) {
+        appendYear((unsigned)value, out);
+        year = true;
+    } else {
+        appendCardinal(value, out);
+    }
+    if (ordinal) makeOrdinal(out);
+    if (decade) makePlural(out);
+    if (fraction && !cents) {
+        out += " point";
+        for (const char* d = fracBegin; d < fracEnd; ++d) {
+            out += ' ';
+            out += kOnes[*d - '0'];
+        }
+    }
+    if (scale) {
+        out += ' ';
+        out += scale;
+    }
+    bool one = value == 1 && (!fraction || cents) && minutes < 0; // "$1.50" is one dollar and fifty cents
+    if (currency) {
+        out += one && !scale ? " dollar" : " dollars";
+        int c = cents ? (fracBegin[0] - '0') * 10 + (fracBegin[1] - '0') : 0;
+        if (c > 0) {
+            out += " and ";
+            appendBelowThousand((unsigned)c, out);
+            out += c == 1 ? " cent" : " cents";
+        }
+    }
+    if (percent) out += " percent";
+    if (unit) {
+        out += ' ';
+        out += one ? unit->one : unit->many;
+    }
+    if (range) {
+        // Both ends read alike: years only when the range starts with one
+        out += " to ";
+        if (!speakNumber(p + 1, e, out, year)) appendRaw(p + 1, e, out);
+    }
+
+    // A plain number: the next word may be its unit
+    if (sn == 0 && !currency) prev = one ? Prev::NumberOne : Prev::Number;
+    return true;
+}
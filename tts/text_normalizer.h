@@ -0,0 +1,60 @@
+#ifndef TEXT_NORMALIZER_H
+#define TEXT_NORMALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// LLM output -> what Piper should say, in one pass over the characters.
+// Works on token fragments as they stream in: a word (or number, abbreviation,
+// stop token) split across fragments is held back until it completes, at most
+// kWordMax bytes, so the cost per token is constant. Output is appended to a
+// caller-owned buffer; reuse it and nothing is allocated once it has grown.
+//
+// What it does:
+//  - ends the response at '<' (<|im_end|> and friends), "im_end", or a leaked
+//    role header ("user" alone on a line)
+//  - drops [tags], '#', '*', markdown odds and ends, and non-ASCII (emojis)
+//  - speaks numbers: "42" forty-two, "1,500" one thousand five hundred,
+//    "3.5" three point five, "$4.99", "20%", "3rd", "3:30", "1990", "-5",
+//    "the 1990s" nineteen nineties, "2020-2021" twenty twenty to twenty twenty-one
+//  - expands abbreviations ("e.g.", "Dr.", "vs.") and units after a number
+//    ("5 km", "200ms", "25°C")
+// Not thread-safe; one per stream.
+class TextNormalizer {
+public:
+    static const size_t kWordMax = 64;
+
+    // Appends the speakable part of text to out. False once the response has
+    // ended; everything after that is ignored.
+    bool push(const char* text, size_t n, std::string& out);
+    bool push(const std::string& text, std::string& out) { return push(text.data(), text.size(), out); }
+    // End of input: emits the word held back
+    void finish(std::string& out);
+    void reset();
+
+    bool ended() const { return done; }
+
+    // Whole text at once
+    static std::string normalize(const std::string& text);
+
+private:
+    enum class Prev { Other, Number, NumberOne }; // What the last word was, for units
+
+    char word[kWordMax];
+    size_t word_len = 0;
+    bool done = false;
+    bool in_bracket = false;
+    bool line_start = true;  // Nothing but whitespace since the last newline
+    bool utf8_c2 = false;    // Lead byte of a possible '°' (C2 B0)
+    bool emitted = false;    // Anything written yet (out may have been consumed)
+    char pending_space = 0;  // ' ' or '\n' owed before the next word
+    Prev prev = Prev::Other;
+
+    void endWord(char delimiter, std::string& out);
+    void speakWord(const char* w, size_t n, std::string& out);
+    bool speakNumber(const char* b, const char* e, std::string& out, bool allowYear = true);
+    void space(std::string& out);
+};
+
+#endif // TEXT_NORMALIZER_H
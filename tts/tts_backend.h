@@ -0,0 +1,49 @@
+#ifndef TTS_BACKEND_H
+#define TTS_BACKEND_H
+
+#include "../utils/perf_monitor.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Speech synthesis + playback behind TTSEngine.
+// SimpleTTS (Piper + ffplay) is the real one; MockTTS stands in for load tests.
+class TTSBackend {
+public:
+    virtual ~TTSBackend() = default;
+
+    // Blocks until the text has been spoken (or synthesized, with playback off).
+    // With synthesized set, also hands back the full audio at sampleRate(); left
+    // empty if synthesis was cut short. normalized: text is already
+    // TextNormalizer output, don't run it again.
+    virtual void speak(const std::string& text, TraceId trace = 0, std::vector<int16_t>* synthesized = nullptr,
+                       bool normalized = false) = 0;
+    virtual void playBackchannel(const std::string& type) = 0;
+    // Mixes a pre-synthesized clip of type over the output at once, without
+    // blocking; false if there isn't one (see PlaybackBuffer::mix for crossfade)
+    virtual bool playClip(const std::string& type, bool crossfade = false) {
+        (void)type;
+        (void)crossfade;
+        return false;
+    }
+    virtual void stop() = 0;
+
+    virtual void setPlaybackEnabled(bool enabled) = 0;
+    // Length of the audio produced by the last speak()
+    virtual double lastAudioSeconds() const = 0;
+
+    // Response cache support (see ResponseCache). Identifies what the audio
+    // sounds like (model, speed); empty means this backend's audio isn't cached.
+    virtual std::string voiceId() const { return ""; }
+    virtual int sampleRate() const { return 22050; }
+    // Plays audio that speak() produced earlier, blocking like speak().
+    // False if this backend can't, and the text has to be spoken instead.
+    virtual bool playPcm(const int16_t* pcm, size_t samples, TraceId trace = 0) {
+        (void)pcm;
+        (void)samples;
+        (void)trace;
+        return false;
+    }
+};
+
+#endif // TTS_BACKEND_H
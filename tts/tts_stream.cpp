@@ -5,18 +5,62 @@ TTSEngine::TTSEngine() {
     impl = new SimpleTTS();
 }
 
+TTSEngine::TTSEngine(TTSBackend* backend) : impl(backend) {}
+
 TTSEngine::~TTSEngine() {
     if (impl) delete impl;
 }
 
-void TTSEngine::speak(const std::string& text) {
-    if (impl) impl->speak(text);
+void TTSEngine::speak(const std::string& text, TraceId trace, bool normalized) {
+    if (!impl || !synthesisEnabled) {
+        PerfMonitor::getInstance().mark(trace, "playback_start"); // Turn ends at the LLM
+        return;
+    }
+    std::string voice = cache ? impl->voiceId() : "";
+    if (voice.empty()) {
+        impl->speak(text, trace, nullptr, normalized);
+        return;
+    }
+    // The key is the normalized text, which is also what the backend is given:
+    // nothing gets normalized twice
+    std::string key = normalized ? text : ResponseCache::normalize(text);
+    if (!cache->cacheable(key)) {
+        impl->speak(key, trace, nullptr, true);
+        return;
+    }
+
+    ResponseCache::AudioPtr hit;
+    {
+        ScopedSpan cache_span(trace, "tts_cache");
+        hit = cache->lookup(key, voice);
+    }
+    if (hit && hit->sample_rate == impl->sampleRate()) {
+        PerfMonitor::getInstance().mark(trace, "tts_first_sample");
+        std::cout << "[TTS] Cached: " << text << std::endl;
+        if (impl->playPcm(hit->pcm, hit->samples, trace)) return;
+    }
+
+    std::vector<int16_t> pcm;
+    impl->speak(key, trace, &pcm, true);
+    if (!pcm.empty()) cache->insert(key, voice, std::move(pcm), impl->sampleRate());
+}
+
+void TTSEngine::setPlaybackEnabled(bool enabled) {
+    if (impl) impl->setPlaybackEnabled(enabled);
+}
+
+double TTSEngine::lastAudioSeconds() const {
+    return (impl && synthesisEnabled) ? impl->lastAudioSeconds() : 0.0;
 }
 
 void TTSEngine::playBackchannel(const std::string& type) {
     if (impl) impl->playBackchannel(type);
 }
 
+bool TTSEngine::playFiller() {
+    return impl && synthesisEnabled && impl->playClip("filler", true);
+}
+
 void TTSEngine::flush() {
     // check
 }
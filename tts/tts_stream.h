@@ -3,19 +3,38 @@
 
 #include <string>
 #include "simple_tts.h"
+#include "response_cache.h"
+#include "../utils/perf_monitor.h"
 
 class TTSEngine {
 public:
-    TTSEngine();
+    TTSEngine();                            // Piper via SimpleTTS
+    explicit TTSEngine(TTSBackend* backend); // Takes ownership
     ~TTSEngine();
     
-    void speak(const std::string& text);
+    // normalized: text already went through TextNormalizer (the controller runs
+    // it over the token stream), so it is the cache key as is and the backend
+    // doesn't normalize it again
+    void speak(const std::string& text, TraceId trace = 0, bool normalized = false);
     void flush();
     void stop();
     void playBackchannel(const std::string& type = "generic");
+    // A cached thinking filler ("Let me think."), handed over to by the next
+    // speak(); false if the backend has none
+    bool playFiller();
+
+    // Headless mode: synthesize without playing (see SimpleTTS::setPlaybackEnabled)
+    void setPlaybackEnabled(bool enabled);
+    void setSynthesisEnabled(bool enabled) { synthesisEnabled = enabled; }
+    double lastAudioSeconds() const;
+
+    // Checked before every synthesis; not owned, and may be shared between engines
+    void setCache(ResponseCache* responseCache) { cache = responseCache; }
 
 private:
-    SimpleTTS* impl = nullptr;
+    TTSBackend* impl = nullptr;
+    ResponseCache* cache = nullptr;
+    bool synthesisEnabled = true;
 };
 
 #endif // TTS_STREAM_H
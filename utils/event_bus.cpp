@@ -0,0 +1,92 @@
+#include "event_bus.h"
+#include "perf_monitor.h"
+#include <atomic>
+#include <iostream>
+
+const char* eventTypeName(EventType type) {
+    switch (type) {
+        case EventType::SpeechStart:       return "SpeechStart";
+        case EventType::SpeechEnd:         return "SpeechEnd";
+        case EventType::PartialTranscript: return "PartialTranscript";
+        case EventType::FinalTranscript:   return "FinalTranscript";
+        case EventType::TokenChunk:        return "TokenChunk";
+        case EventType::AudioStarted:      return "AudioStarted";
+        case EventType::Interrupt:         return "Interrupt";
+        default:                           return "Unknown";
+    }
+}
+
+EventBus::EventBus() : running(false), idle(false) {}
+
+EventBus::~EventBus() {
+    stop();
+}
+
+void EventBus::subscribe(EventType type, Handler handler) {
+    std::lock_guard<std::mutex> lock(handlers_mtx);
+    handlers[(int)type].push_back(std::move(handler));
+}
+
+bool EventBus::publish(EventType type, uint64_t trace_id, const std::string& text, double latency_ms) {
+    PipelineEvent event;
+    event.type = type;
+    event.trace_id = trace_id;
+    event.text = text;
+    event.latency_ms = latency_ms;
+    return publish(std::move(event));
+}
+
+bool EventBus::publish(PipelineEvent event) {
+    EventType type = event.type;
+    event.timestamp = std::chrono::steady_clock::now();
+    if (!queue.push(std::move(event))) {
+        std::cerr << "[EventBus] Queue full, dropping " << eventTypeName(type) << std::endl;
+        return false;
+    }
+    // Orders the push before the idle check (store -> load); pairs with the
+    // fence in dispatchLoop, so one of the two sides sees the other
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (idle.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(wake_mtx);
+        wake_cv.notify_one();
+    }
+    return true;
+}
+
+void EventBus::start() {
+    if (running.exchange(true)) return;
+    dispatcher = std::thread(&EventBus::dispatchLoop, this);
+}
+
+void EventBus::stop() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(wake_mtx);
+        wake_cv.notify_one();
+    }
+    if (dispatcher.joinable()) dispatcher.join();
+}
+
+void EventBus::dispatchLoop() {
+    PerfMonitor::getInstance().setThreadName("event_bus");
+    PipelineEvent event;
+    while (running) {
+        if (queue.pop(event)) {
+            std::lock_guard<std::mutex> lock(handlers_mtx);
+            for (auto& handler : handlers[(int)event.type]) {
+                handler(event);
+            }
+            continue;
+        }
+
+        // Nothing queued: sleep until a producer wakes us. idle is set, then a
+        // full fence, then the queue re-checked (in the wait predicate); with
+        // the matching fence in publish() either the producer sees idle ==
+        // true and notifies, or we see its event. The timeout is only a backstop.
+        std::unique_lock<std::mutex> lock(wake_mtx);
+        idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake_cv.wait_for(lock, std::chrono::milliseconds(50), [this] { return !queue.empty() || !running; });
+        idle.store(false, std::memory_order_relaxed);
+    }
+}
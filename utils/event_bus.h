@@ -0,0 +1,74 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "mpsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Everything the pipeline threads tell each other goes through here.
+enum class EventType {
+    SpeechStart,        // VAD: user started talking
+    SpeechEnd,          // VAD: end of user turn (endpoint)
+    PartialTranscript,  // ASR: hypothesis while the user is still talking
+    FinalTranscript,    // ASR: transcript of a finished turn
+    TokenChunk,         // LLM: generated token
+    AudioStarted,       // TTS: agent audio is starting
+    Interrupt,          // Barge-in: stop the agent
+    Count
+};
+
+const char* eventTypeName(EventType type);
+
+struct PipelineEvent {
+    EventType type = EventType::SpeechStart;
+    std::chrono::steady_clock::time_point timestamp; // Stamped by EventBus::publish
+    uint64_t trace_id = 0;                           // PerfMonitor turn trace (0 = none)
+    std::string text;                                // Transcript / token payload
+    double latency_ms = 0.0;                         // Producer-side latency (e.g. ASR time)
+};
+
+// Typed MPSC event bus. publish() is lock-free and safe from any thread;
+// a single dispatcher thread delivers events to subscribers in publish order.
+// Handlers run on the dispatcher thread and must not block - hand long work
+// (LLM generation, TTS) off to another thread.
+class EventBus {
+public:
+    using Handler = std::function<void(const PipelineEvent&)>;
+
+    EventBus();
+    ~EventBus();
+
+    void subscribe(EventType type, Handler handler);
+
+    // Returns false if the queue overflowed and the event was dropped.
+    bool publish(EventType type, uint64_t trace_id = 0, const std::string& text = "", double latency_ms = 0.0);
+    bool publish(PipelineEvent event);
+
+    void start();
+    void stop();
+
+private:
+    void dispatchLoop();
+
+    MpscQueue<PipelineEvent, 1024> queue;
+    std::vector<Handler> handlers[(int)EventType::Count];
+    std::mutex handlers_mtx;
+
+    std::thread dispatcher;
+    std::atomic<bool> running;
+
+    // Only touched when the dispatcher goes idle; producers take the lock
+    // solely to wake a sleeping dispatcher.
+    std::atomic<bool> idle;
+    std::mutex wake_mtx;
+    std::condition_variable wake_cv;
+};
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,94 @@
+#include "latency_histogram.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+int highestBit(uint64_t v) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, v);
+    return (int)idx;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+} // namespace
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+int LatencyHistogram::indexFor(uint64_t us) {
+    if (us < (uint64_t)kSubCount) return (int)us;
+    int msb = highestBit(us);
+    if (msb > kMaxMsb) return kBuckets - 1;
+    int shift = msb - kSubBits + 1;
+    int sub = (int)(us >> shift); // in [kHalfCount, kSubCount)
+    return kSubCount + (msb - kSubBits) * kHalfCount + (sub - kHalfCount);
+}
+
+uint64_t LatencyHistogram::valueFor(int index) {
+    if (index < kSubCount) return (uint64_t)index;
+    int octave = (index - kSubCount) / kHalfCount;
+    int sub = (index - kSubCount) % kHalfCount + kHalfCount;
+    int shift = octave + 1;
+    return (((uint64_t)sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(double ms) {
+    if (ms < 0) ms = 0;
+    uint64_t us = (uint64_t)(ms * 1000.0 + 0.5);
+    counts[indexFor(us)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prev = max_us.load(std::memory_order_relaxed);
+    while (us > prev && !max_us.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    total.store(0);
+    sum_us.store(0);
+    max_us.store(0);
+}
+
+uint64_t LatencyHistogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? (double)sum_us.load(std::memory_order_relaxed) / n / 1000.0 : 0.0;
+}
+
+double LatencyHistogram::sum() const {
+    return sum_us.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double LatencyHistogram::max() const {
+    return max_us.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double LatencyHistogram::percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0) return 0.0;
+    if (p < 0) p = 0;
+    if (p > 100) p = 100;
+
+    // Rank of the requested sample (1-based), then walk the buckets
+    uint64_t rank = (uint64_t)(p / 100.0 * n + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t v = valueFor(i);
+            uint64_t m = max_us.load(std::memory_order_relaxed);
+            return (v < m ? v : m) / 1000.0;
+        }
+    }
+    return max();
+}
@@ -0,0 +1,41 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+
+// HDR-style log-linear histogram of latencies, recorded in microseconds.
+// Each power-of-two range is split into 128 linear sub-buckets, so any
+// reported percentile is within ~0.8% of the true value from 1 us up to
+// ~12 days, in a fixed 35 KB of counters. record() is lock-free and can be
+// called from any thread; reads are a consistent-enough snapshot for export.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(double ms);
+    void reset();
+
+    uint64_t count() const;
+    double mean() const;   // ms
+    double sum() const;    // ms
+    double max() const;    // ms
+    double percentile(double p) const; // p in [0, 100], ms
+
+private:
+    static const int kSubBits = 8;                    // 256 direct buckets, then 128 per octave
+    static const int kSubCount = 1 << kSubBits;
+    static const int kHalfCount = kSubCount / 2;
+    static const int kMaxMsb = 40;                    // 2^41 us
+    static const int kBuckets = kSubCount + (kMaxMsb - kSubBits + 1) * kHalfCount;
+
+    static int indexFor(uint64_t us);
+    static uint64_t valueFor(int index);              // Upper edge of the bucket
+
+    std::atomic<uint64_t> counts[kBuckets];
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> sum_us;
+    std::atomic<uint64_t> max_us;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,231 @@
+#include "metrics_server.h"
+#include "socket_compat.h"
+#include "perf_monitor.h"
+#include "json_util.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+// Recent turn events, fanned out to every connected SSE client.
+// Outlives the server if PerfMonitor still holds the listener.
+struct SseHub {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::pair<uint64_t, std::string>> events; // (id, data)
+    uint64_t next_id = 1;
+    bool closed = false;
+
+    static const size_t kBacklog = 64;
+
+    void publish(std::string data) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            events.emplace_back(next_id++, std::move(data));
+            if (events.size() > kBacklog) events.pop_front();
+        }
+        cv.notify_all();
+    }
+};
+
+namespace {
+std::string turnEventJson(const TurnTrace& t) {
+    std::ostringstream out;
+    out << "{\"row\":" << interactionMetricsJson(t.metrics) << ",\"spans\":[";
+    for (size_t i = 0; i < t.spans.size(); ++i) {
+        const SpanRecord& s = t.spans[i];
+        if (i) out << ",";
+        out << "{\"name\":\"" << jsonEscape(s.name) << "\""
+            << ",\"span\":" << s.span_id
+            << ",\"parent\":" << s.parent_id
+            << ",\"thread\":" << s.thread_index
+            << ",\"start_ms\":" << (s.start_us - t.origin_us) / 1000.0
+            << ",\"dur_ms\":" << (s.end_us - s.start_us) / 1000.0 << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+std::string httpResponse(const std::string& status, const std::string& contentType, const std::string& body) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << status << "\r\n"
+        << "Content-Type: " << contentType << "\r\n"
+        << "Content-Length: " << body.size() << "\r\n"
+        << "Access-Control-Allow-Origin: *\r\n"
+        << "Connection: close\r\n\r\n"
+        << body;
+    return out.str();
+}
+} // namespace
+
+MetricsServer::MetricsServer(const std::string& h, int p)
+    : host(h), port(p), listener((uintptr_t)INVALID_SOCKET), running(false), active_clients(0),
+      stream_clients(0), hub(std::make_shared<SseHub>()) {
+    std::shared_ptr<SseHub> sse = hub;
+    PerfMonitor::getInstance().addTurnListener([sse](const TurnTrace& t) {
+        sse->publish(turnEventJson(t));
+    });
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    if (running) return true;
+    socket_t s = listenTcp(host, port);
+    if (s == INVALID_SOCKET) {
+        std::cerr << "[Metrics] Could not listen on " << host << ":" << port << std::endl;
+        return false;
+    }
+    listener = (uintptr_t)s;
+    running = true;
+    accept_thread = std::thread(&MetricsServer::acceptLoop, this);
+    std::cout << "[Metrics] Serving /metrics and /events on http://" << host << ":" << port << std::endl;
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(hub->mtx);
+        hub->closed = true;
+    }
+    hub->cv.notify_all();
+    if (accept_thread.joinable()) accept_thread.join();
+    CLOSE_SOCKET((socket_t)listener);
+
+    // Connection threads are detached; wait for them to notice shutdown
+    while (active_clients > 0) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+void MetricsServer::acceptLoop() {
+    PerfMonitor::getInstance().setThreadName("metrics_http");
+    socket_t ls = (socket_t)listener;
+    while (running) {
+        // Poll so stop() doesn't depend on closing a socket under a blocked accept()
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(ls, &readable);
+        timeval tv{0, 200 * 1000};
+        if (select((int)ls + 1, &readable, nullptr, nullptr, &tv) <= 0) continue;
+
+        socket_t client = accept(ls, nullptr, nullptr);
+        if (client == INVALID_SOCKET) continue;
+        setRecvTimeout(client, 5000); // Don't let an idle connection pin a thread
+        active_clients++;
+        std::thread([this, client]() {
+            handleClient((uintptr_t)client);
+            CLOSE_SOCKET(client);
+            active_clients--;
+        }).detach();
+    }
+}
+
+void MetricsServer::handleClient(uintptr_t client) {
+    socket_t s = (socket_t)client;
+
+    // Read the request head; we only care about the request line
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        int n = (int)recv(s, buf, sizeof(buf), 0);
+        if (n <= 0) return;
+        request.append(buf, n);
+    }
+
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, path;
+    line >> method >> path;
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET") {
+        sendAll(s, httpResponse("405 Method Not Allowed", "text/plain", "GET only\n"));
+    } else if (path == "/metrics") {
+        sendAll(s, httpResponse("200 OK", "text/plain; version=0.0.4", prometheusText()));
+    } else if (path == "/summary") {
+        sendAll(s, httpResponse("200 OK", "application/json", PerfMonitor::getInstance().summaryJson()));
+    } else if (path == "/events") {
+        serveEvents(client);
+    } else {
+        sendAll(s, httpResponse("404 Not Found", "text/plain", "Try /metrics, /summary or /events\n"));
+    }
+}
+
+void MetricsServer::serveEvents(uintptr_t client) {
+    socket_t s = (socket_t)client;
+    const std::string head =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Connection: keep-alive\r\n\r\n"
+        "retry: 2000\n\n";
+    if (!sendAll(s, head)) return;
+
+    struct StreamCount {
+        std::atomic<int>& n;
+        explicit StreamCount(std::atomic<int>& c) : n(c) { n++; }
+        ~StreamCount() { n--; }
+    } counted(stream_clients);
+
+    // New subscribers only get turns finished from now on
+    uint64_t cursor;
+    {
+        std::lock_guard<std::mutex> lock(hub->mtx);
+        cursor = hub->next_id;
+    }
+
+    while (running) {
+        std::vector<std::pair<uint64_t, std::string>> batch;
+        {
+            std::unique_lock<std::mutex> lock(hub->mtx);
+            hub->cv.wait_for(lock, std::chrono::seconds(15), [&] {
+                return hub->closed || (!hub->events.empty() && hub->events.back().first >= cursor);
+            });
+            if (hub->closed) return;
+            for (const auto& e : hub->events) {
+                if (e.first >= cursor) batch.push_back(e);
+            }
+        }
+
+        if (batch.empty()) {
+            // Keep-alive comment so proxies and the browser don't time out
+            if (!sendAll(s, ": ping\n\n")) return;
+            continue;
+        }
+        for (const auto& e : batch) {
+            std::string frame = "event: turn\nid: " + std::to_string(e.first) + "\ndata: " + e.second + "\n\n";
+            if (!sendAll(s, frame)) return;
+            cursor = e.first + 1;
+        }
+    }
+}
+
+std::string MetricsServer::prometheusText() {
+    auto& monitor = PerfMonitor::getInstance();
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::ostringstream out;
+    out << "# HELP voice_agent_latency_ms Pipeline stage latency in milliseconds.\n"
+        << "# TYPE voice_agent_latency_ms summary\n";
+    for (int i = 0; i < (int)LatencyMetric::Count; ++i) {
+        const LatencyHistogram& h = monitor.histogram((LatencyMetric)i);
+        const char* stage = latencyMetricName((LatencyMetric)i);
+        for (double q : quantiles) {
+            out << "voice_agent_latency_ms{stage=\"" << stage << "\",quantile=\"" << q << "\"} "
+                << h.percentile(q * 100.0) << "\n";
+        }
+        out << "voice_agent_latency_ms_sum{stage=\"" << stage << "\"} " << h.sum() << "\n"
+            << "voice_agent_latency_ms_count{stage=\"" << stage << "\"} " << h.count() << "\n";
+    }
+    out << "# HELP voice_agent_turns_total Completed user turns.\n"
+        << "# TYPE voice_agent_turns_total counter\n"
+        << "voice_agent_turns_total " << monitor.turnsLogged() << "\n"
+        << "# HELP voice_agent_event_stream_clients Connected /events subscribers.\n"
+        << "# TYPE voice_agent_event_stream_clients gauge\n"
+        << "voice_agent_event_stream_clients " << stream_clients.load() << "\n";
+    return out.str();
+}
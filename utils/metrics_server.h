@@ -0,0 +1,43 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+struct SseHub;
+
+// Tiny embedded HTTP/1.1 server for live monitoring of the running agent.
+//   GET /metrics  Prometheus text exposition (latency summaries, turn counter)
+//   GET /summary  latency_summary.json document
+//   GET /events   Server-Sent Events stream, one "turn" event per finished turn
+//                 carrying the turn's metrics row and all of its spans
+// One accept thread plus one short-lived thread per connection; SSE clients
+// keep their thread for the life of the stream.
+class MetricsServer {
+public:
+    MetricsServer(const std::string& host = "127.0.0.1", int port = 9464);
+    ~MetricsServer();
+
+    bool start();
+    void stop();
+
+private:
+    void acceptLoop();
+    void handleClient(uintptr_t client);
+    void serveEvents(uintptr_t client);
+    std::string prometheusText();
+
+    std::string host;
+    int port;
+    uintptr_t listener;
+    std::atomic<bool> running;
+    std::atomic<int> active_clients;
+    std::atomic<int> stream_clients;
+    std::thread accept_thread;
+    std::shared_ptr<SseHub> hub; // Shared with the PerfMonitor turn listener
+};
+
+#endif // METRICS_SERVER_H
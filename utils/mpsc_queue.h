@@ -0,0 +1,78 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free multi-producer / single-consumer queue.
+// Based on Dmitry Vyukov's bounded MPMC design: every cell carries a sequence
+// number, producers claim a slot with a CAS on the tail and the (single)
+// consumer walks the head without any atomic RMW.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    MpscQueue() : head(0), tail(0) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Safe to call from any thread. Returns false if the queue is full.
+    bool push(T value) {
+        Cell* cell;
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &cells[pos & (Capacity - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only.
+    bool pop(T& out) {
+        Cell* cell = &cells[head & (Capacity - 1)];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        if ((intptr_t)seq - (intptr_t)(head + 1) < 0) return false; // Empty
+        out = std::move(cell->value);
+        cell->sequence.store(head + Capacity, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    // Consumer thread only.
+    bool empty() const {
+        const Cell& cell = cells[head & (Capacity - 1)];
+        return (intptr_t)cell.sequence.load(std::memory_order_acquire) - (intptr_t)(head + 1) < 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Keep producer and consumer indices on separate cache lines
+    alignas(64) Cell cells[Capacity];
+    alignas(64) size_t head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // MPSC_QUEUE_H
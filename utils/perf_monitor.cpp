@@ -1,58 +1,467 @@
 #include "perf_monitor.h"
+#include "spsc_ring.h"
+#include "json_util.h"
 #include <iomanip>
 #include <ctime>
 #include <sstream>
+#include <cstdio>
+#include <filesystem>
 
-void PerfMonitor::startTimer(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx);
-    timers[key] = std::chrono::high_resolution_clock::now();
+// One per thread that records spans. Only the owning thread pushes;
+// the collector (under PerfMonitor::mtx) pops.
+struct ThreadSpanBuffer {
+    SpscRing<SpanRecord> ring{4096};
+    uint32_t thread_index = 0;
+    std::atomic<bool> retired{false};   // Owning thread has exited
+    std::atomic<uint64_t> dropped{0};   // Spans lost to a full ring
+};
+
+namespace {
+struct ThreadBufferHandle {
+    std::shared_ptr<ThreadSpanBuffer> buffer;
+    ~ThreadBufferHandle() {
+        if (buffer) buffer->retired = true;
+    }
+};
+thread_local ThreadBufferHandle tls_spans;
+
+const SpanRecord* findSpan(const std::vector<SpanRecord>& spans, const char* name) {
+    for (const auto& s : spans) {
+        if (std::string(s.name) == name) return &s;
+    }
+    return nullptr;
 }
 
-double PerfMonitor::stopTimer(const std::string& key) {
-    std::lock_guard<std::mutex> lock(mtx);
-    if (timers.find(key) == timers.end()) return 0.0;
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double, std::milli> ms = end - timers[key];
-    return ms.count();
+double spanMs(const SpanRecord* s) {
+    return s ? (s->end_us - s->start_us) / 1000.0 : 0.0;
 }
 
-void PerfMonitor::logTurn(InteractionMetrics metrics) {
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // Auto-timestamp
+std::string localTimestamp() {
     auto t = std::time(nullptr);
     auto tm = *std::localtime(&t);
     std::ostringstream oss;
     oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    metrics.timestamp = oss.str();
-    
-    history.push_back(metrics);
-    
-    // Real-time console log for the researcher
-    std::cout << "\n[METRICS] Turn " << metrics.turn_id << " Stats:" << std::endl;
-    std::cout << "  - ASR : " << metrics.asr_latency_ms << " ms" << std::endl;
-    std::cout << "  - LLM (TTFT) : " << metrics.llm_ttft_ms << " ms" << std::endl;
-    std::cout << "  - Total E2E  : " << metrics.total_e2e_ms << " ms" << std::endl;
-    std::cout << "  - Tokens : " << metrics.token_count << std::endl;
-}
-
-void PerfMonitor::saveCSV(const std::string& filename) {
-    std::lock_guard<std::mutex> lock(mtx);
-    std::ofstream file(filename);
-    
-    file << "TurnID,Timestamp,VAD_Latency,ASR_Latency,LLM_TTFT,TTS_Latency,Total_E2E,Tokens,UserText\n";
-    
-    for(const auto& m : history) {
-        file << m.turn_id << ","
-             << m.timestamp << ","
-             << m.vad_latency_ms << ","
-             << m.asr_latency_ms << ","
-             << m.llm_ttft_ms << ","
-             << m.tts_latency_ms << ","
-             << m.total_e2e_ms << ","
-             << m.token_count << ",\""
-             << m.user_text << "\"\n";
-    }
-    std::cout << "[RESEARCH] Data exported to " << filename << std::endl;
+    return oss.str();
+}
+} // namespace
+
+PerfMonitor::PerfMonitor()
+    : epoch(std::chrono::steady_clock::now()), next_trace(1), next_span(1), exporting(false) {}
+
+PerfMonitor::~PerfMonitor() {
+    stopTraceExport();
+}
+
+int64_t PerfMonitor::nowUs() const {
+    return toUs(std::chrono::steady_clock::now());
+}
+
+int64_t PerfMonitor::toUs(std::chrono::steady_clock::time_point t) const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t - epoch).count();
+}
+
+ThreadSpanBuffer& PerfMonitor::localBuffer() {
+    if (!tls_spans.buffer) {
+        auto buffer = std::make_shared<ThreadSpanBuffer>();
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        buffer->thread_index = next_thread_index++;
+        buffers.push_back(buffer);
+        tls_spans.buffer = buffer;
+    }
+    return *tls_spans.buffer;
+}
+
+void PerfMonitor::pushSpan(const SpanRecord& record) {
+    // Spans outside a turn (audio callback, per-frame VAD, decode steps) only matter for the trace file
+    if (record.trace_id == 0 && !exporting) return;
+
+    ThreadSpanBuffer& buffer = localBuffer();
+    SpanRecord r = record;
+    r.thread_index = buffer.thread_index;
+    if (!buffer.ring.push(r)) buffer.dropped++;
+}
+
+TraceId PerfMonitor::beginTurn(std::chrono::steady_clock::time_point origin, uint32_t session) {
+    TraceId trace = next_trace++;
+    std::lock_guard<std::mutex> lock(mtx);
+    turns[trace] = TurnState{toUs(origin), session};
+    return trace;
+}
+
+Span PerfMonitor::startSpan(TraceId trace, const char* name, SpanId parent) {
+    Span span;
+    span.trace_id = trace;
+    span.span_id = next_span++;
+    span.parent_id = parent;
+    span.name = name;
+    span.start_us = nowUs();
+    return span;
+}
+
+double PerfMonitor::endSpan(const Span& span) {
+    int64_t end = nowUs();
+    pushSpan(SpanRecord{span.trace_id, span.span_id, span.parent_id, span.name, span.start_us, end, 0});
+    return (end - span.start_us) / 1000.0;
+}
+
+void PerfMonitor::recordSpan(TraceId trace, const char* name,
+                             std::chrono::steady_clock::time_point start,
+                             std::chrono::steady_clock::time_point end,
+                             SpanId parent) {
+    pushSpan(SpanRecord{trace, next_span++, parent, name, toUs(start), toUs(end), 0});
+}
+
+void PerfMonitor::mark(TraceId trace, const char* name, SpanId parent) {
+    int64_t now = nowUs();
+    pushSpan(SpanRecord{trace, next_span++, parent, name, now, now, 0});
+}
+
+void PerfMonitor::collectLocked() {
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    SpanRecord r;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        ThreadSpanBuffer& buffer = **it;
+        while (buffer.ring.pop(r)) {
+            if (trace_file.is_open()) writeTraceEventLocked(r);
+            // Spans of turns that were already finished or dropped are discarded
+            if (turns.count(r.trace_id)) pending[r.trace_id].push_back(r);
+        }
+        if (buffer.retired && buffer.ring.size() == 0) {
+            it = buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PerfMonitor::finishTurn(TraceId trace, const std::string& user_text, int token_count) {
+    TurnTrace turnTrace{};
+    InteractionMetrics& m = turnTrace.metrics;
+    std::vector<TurnListener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto turn = turns.find(trace);
+        if (turn == turns.end()) return;
+        int64_t origin = turn->second.origin_us;
+        uint32_t session = turn->second.session_id;
+
+        // Root span of the turn, so the trace shows it end to end
+        pushSpan(SpanRecord{trace, next_span++, 0, "turn", origin, nowUs(), 0});
+        collectLocked();
+
+        std::vector<SpanRecord> spans = std::move(pending[trace]);
+        pending.erase(trace);
+        turns.erase(turn);
+
+        const SpanRecord* llm = findSpan(spans, "llm");
+        const SpanRecord* first_sentence = findSpan(spans, "first_sentence");
+        const SpanRecord* playback = findSpan(spans, "playback_start");
+
+        m.turn_id = trace;
+        m.session_id = session;
+        m.vad_latency_ms = spanMs(findSpan(spans, "vad_endpoint"));
+        m.asr_latency_ms = spanMs(findSpan(spans, "asr"));
+        m.llm_ttft_ms = spanMs(findSpan(spans, "prefill"));
+        m.first_sentence_ms = (llm && first_sentence) ? (first_sentence->start_us - llm->start_us) / 1000.0 : 0.0;
+        m.tts_latency_ms = spanMs(findSpan(spans, "tts_first_sample"));
+        m.total_e2e_ms = playback ? (playback->start_us - origin) / 1000.0 : 0.0;
+        m.token_count = token_count;
+        m.user_text = user_text;
+        m.timestamp = localTimestamp();
+
+        turnTrace.origin_us = origin;
+        turnTrace.spans = std::move(spans);
+        for (auto& entry : turn_listeners) listeners.push_back(entry.second);
+    }
+
+    logTurn(m);
+    for (auto& listener : listeners) listener(turnTrace);
+}
+
+uint64_t PerfMonitor::addTurnListener(TurnListener listener) {
+    std::lock_guard<std::mutex> lock(mtx);
+    uint64_t id = next_listener++;
+    turn_listeners[id] = std::move(listener);
+    return id;
+}
+
+void PerfMonitor::removeTurnListener(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    turn_listeners.erase(id);
+}
+
+uint64_t PerfMonitor::turnsLogged() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return turns_logged;
+}
+
+void PerfMonitor::dropTurn(TraceId trace) {
+    std::lock_guard<std::mutex> lock(mtx);
+    turns.erase(trace);
+    pending.erase(trace);
+}
+
+void PerfMonitor::setThreadName(const std::string& name) {
+    ThreadSpanBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    thread_names[buffer.thread_index] = name;
+}
+
+void PerfMonitor::startTraceExport(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (exporting) return;
+
+    trace_file.open(filename, std::ios::out | std::ios::trunc);
+    if (!trace_file.is_open()) {
+        std::cerr << "[PerfMonitor] Could not open trace file: " << filename << std::endl;
+        return;
+    }
+    // JSON Array Format; the closing bracket is optional, so a crashed run still loads
+    trace_file << "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"voice_agent\"}}";
+    trace_first_event = false;
+    trace_named_threads.clear();
+    exporting = true;
+    export_thread = std::thread(&PerfMonitor::exportLoop, this);
+    std::cout << "[RESEARCH] Streaming pipeline trace to " << filename << std::endl;
+}
+
+void PerfMonitor::stopTraceExport() {
+    {
+        std::lock_guard<std::mutex> lock(export_mtx);
+        if (!exporting) return;
+        exporting = false;
+    }
+    export_cv.notify_all();
+    if (export_thread.joinable()) export_thread.join();
+
+    // Final drain: write what is left, then close the array
+    std::lock_guard<std::mutex> lock(mtx);
+    collectLocked();
+    writeThreadNamesLocked();
+    trace_file << "\n]\n";
+    trace_file.close();
+}
+
+void PerfMonitor::exportLoop() {
+    setThreadName("trace_export");
+    std::unique_lock<std::mutex> wait_lock(export_mtx);
+    while (exporting) {
+        export_cv.wait_for(wait_lock, std::chrono::milliseconds(200));
+        if (!exporting) break;
+        std::lock_guard<std::mutex> lock(mtx);
+        collectLocked();
+        writeThreadNamesLocked();
+        trace_file.flush();
+    }
+}
+
+void PerfMonitor::writeThreadNamesLocked() {
+    std::lock_guard<std::mutex> lock(registry_mtx);
+    for (const auto& kv : thread_names) {
+        if (trace_named_threads.count(kv.first)) continue;
+        trace_named_threads.insert(kv.first);
+        trace_file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << kv.first
+                   << ",\"args\":{\"name\":\"" << kv.second << "\"}}";
+    }
+}
+
+void PerfMonitor::writeTraceEventLocked(const SpanRecord& r) {
+    if (!trace_first_event) trace_file << ",\n";
+    trace_first_event = false;
+
+    const char* category = r.trace_id ? "turn" : "pipeline";
+    trace_file << "{\"name\":\"" << r.name << "\",\"cat\":\"" << category << "\"";
+    if (r.end_us == r.start_us) {
+        trace_file << ",\"ph\":\"i\",\"s\":\"t\"";
+    } else {
+        trace_file << ",\"ph\":\"X\",\"dur\":" << (r.end_us - r.start_us);
+    }
+    trace_file << ",\"ts\":" << r.start_us << ",\"pid\":1,\"tid\":" << r.thread_index
+               << ",\"args\":{\"trace\":" << r.trace_id << ",\"span\":" << r.span_id
+               << ",\"parent\":" << r.parent_id << "}}";
+}
+
+void PerfMonitor::logTurn(InteractionMetrics metrics) {
+    // Auto-timestamp
+    if (metrics.timestamp.empty()) metrics.timestamp = localTimestamp();
+
+    recordLatency(LatencyMetric::VadEndpoint, metrics.vad_latency_ms);
+    recordLatency(LatencyMetric::ASR, metrics.asr_latency_ms);
+    recordLatency(LatencyMetric::TTFT, metrics.llm_ttft_ms);
+    recordLatency(LatencyMetric::FirstSentence, metrics.first_sentence_ms);
+    recordLatency(LatencyMetric::FirstAudio, metrics.tts_latency_ms);
+    recordLatency(LatencyMetric::E2E, metrics.total_e2e_ms);
+
+    std::string summary;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        appendTurnLogLocked(metrics);
+        summary = summary_path;
+    }
+
+    if (turn_console) {
+        // Real-time console log for the researcher
+        std::cout << "\n[METRICS] Turn " << metrics.turn_id << " Stats:" << std::endl;
+        std::cout << "  - VAD Endpoint : " << metrics.vad_latency_ms << " ms" << std::endl;
+        std::cout << "  - ASR : " << metrics.asr_latency_ms << " ms" << std::endl;
+        std::cout << "  - LLM (TTFT) : " << metrics.llm_ttft_ms << " ms" << std::endl;
+        std::cout << "  - First Sentence : " << metrics.first_sentence_ms << " ms" << std::endl;
+        std::cout << "  - Total E2E  : " << metrics.total_e2e_ms << " ms" << std::endl;
+        std::cout << "  - Tokens : " << metrics.token_count << std::endl;
+        const LatencyHistogram& e2e = histogram(LatencyMetric::E2E);
+        std::cout << "  - E2E P50/P90/P99 : " << e2e.percentile(50) << " / " << e2e.percentile(90)
+                  << " / " << e2e.percentile(99) << " ms (n=" << e2e.count() << ")" << std::endl;
+    }
+
+    if (!summary.empty()) writeSummary(summary);
+}
+
+void PerfMonitor::setTurnSummary(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(mtx);
+    summary_path = filename;
+}
+
+const char* latencyMetricName(LatencyMetric metric) {
+    switch (metric) {
+        case LatencyMetric::VadEndpoint:        return "vad_endpoint";
+        case LatencyMetric::ASR:                return "asr";
+        case LatencyMetric::TTFT:               return "llm_ttft";
+        case LatencyMetric::FirstSentence:      return "first_sentence";
+        case LatencyMetric::FirstAudio:         return "tts_first_audio";
+        case LatencyMetric::E2E:                return "e2e";
+        case LatencyMetric::InterruptToSilence: return "interrupt_to_silence";
+        default:                                return "unknown";
+    }
+}
+
+void PerfMonitor::recordLatency(LatencyMetric metric, double ms) {
+    // 0 means "not measured on this turn" (e.g. text injection has no ASR)
+    if (ms <= 0.0) return;
+    histograms[(int)metric].record(ms);
+}
+
+const LatencyHistogram& PerfMonitor::histogram(LatencyMetric metric) const {
+    return histograms[(int)metric];
+}
+
+void PerfMonitor::printPercentiles() {
+    std::cout << "\n[METRICS] Latency percentiles (ms):" << std::endl;
+    for (int i = 0; i < (int)LatencyMetric::Count; ++i) {
+        const LatencyHistogram& h = histograms[i];
+        if (h.count() == 0) continue;
+        std::cout << "  - " << latencyMetricName((LatencyMetric)i)
+                  << " : n=" << h.count()
+                  << " P50=" << h.percentile(50)
+                  << " P90=" << h.percentile(90)
+                  << " P99=" << h.percentile(99)
+                  << " P99.9=" << h.percentile(99.9) << std::endl;
+    }
+}
+
+std::string PerfMonitor::summaryJson() {
+    std::ostringstream out;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        out << "{\"turns\":" << turns_logged << ",\"metrics\":{";
+    }
+    for (int i = 0; i < (int)LatencyMetric::Count; ++i) {
+        const LatencyHistogram& h = histograms[i];
+        if (i) out << ",";
+        out << "\"" << latencyMetricName((LatencyMetric)i) << "\":{"
+            << "\"count\":" << h.count()
+            << ",\"mean\":" << h.mean()
+            << ",\"p50\":" << h.percentile(50)
+            << ",\"p90\":" << h.percentile(90)
+            << ",\"p99\":" << h.percentile(99)
+            << ",\"p999\":" << h.percentile(99.9)
+            << ",\"max\":" << h.max() << "}";
+    }
+    out << "}}";
+    return out.str();
+}
+
+void PerfMonitor::writeSummary(const std::string& filename) {
+    std::string json = summaryJson();
+    // Write to a temp file and rename, so readers never see a half-written summary
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        file << json << "\n";
+        if (!file) return;
+    }
+    // Replaces the target in one step (MoveFileEx with REPLACE_EXISTING on Windows)
+    std::error_code ec;
+    std::filesystem::rename(tmp, filename, ec);
+    if (ec) std::cerr << "[PerfMonitor] Could not replace " << filename << ": " << ec.message() << std::endl;
+}
+
+std::string interactionMetricsJson(const InteractionMetrics& m) {
+    std::ostringstream out;
+    out << "{\"TurnID\":" << m.turn_id
+        << ",\"Session\":" << m.session_id
+        << ",\"Timestamp\":\"" << m.timestamp << "\""
+        << ",\"VAD_Latency\":" << m.vad_latency_ms
+        << ",\"ASR_Latency\":" << m.asr_latency_ms
+        << ",\"LLM_TTFT\":" << m.llm_ttft_ms
+        << ",\"First_Sentence\":" << m.first_sentence_ms
+        << ",\"TTS_Latency\":" << m.tts_latency_ms
+        << ",\"Total_E2E\":" << m.total_e2e_ms
+        << ",\"Tokens\":" << m.token_count
+        << ",\"UserText\":\"" << jsonEscape(m.user_text) << "\"}";
+    return out.str();
+}
+
+namespace {
+std::string csvEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out;
+}
+} // namespace
+
+void PerfMonitor::setTurnLog(const std::string& csv, const std::string& jsonl) {
+    std::lock_guard<std::mutex> lock(mtx);
+    csv_path = csv;
+    jsonl_path = jsonl;
+    // Next turn opens (and truncates) the new files
+    csv_log.close();
+    jsonl_log.close();
+    turn_log_opened = false;
+}
+
+void PerfMonitor::appendTurnLogLocked(const InteractionMetrics& m) {
+    turns_logged++;
+
+    // First turn of the run starts fresh files; after that we only append
+    if (!turn_log_opened) {
+        turn_log_opened = true;
+        if (!csv_path.empty()) {
+            csv_log.open(csv_path, std::ios::out | std::ios::trunc);
+            csv_log << "TurnID,Timestamp,VAD_Latency,ASR_Latency,LLM_TTFT,TTS_Latency,Total_E2E,Tokens,UserText\n";
+        }
+        if (!jsonl_path.empty()) jsonl_log.open(jsonl_path, std::ios::out | std::ios::trunc);
+    }
+
+    if (csv_log.is_open()) {
+        csv_log << m.turn_id << ","
+                << m.timestamp << ","
+                << m.vad_latency_ms << ","
+                << m.asr_latency_ms << ","
+                << m.llm_ttft_ms << ","
+                << m.tts_latency_ms << ","
+                << m.total_e2e_ms << ","
+                << m.token_count << ",\""
+                << csvEscape(m.user_text) << "\"\n";
+        csv_log.flush();
+    }
+
+    // Same columns as the CSV so consumers can switch formats without remapping
+    if (jsonl_log.is_open()) {
+        jsonl_log << interactionMetricsJson(m) << "\n";
+        jsonl_log.flush();
+    }
 }
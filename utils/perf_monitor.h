@@ -1,19 +1,32 @@
 #ifndef PERF_MONITOR_H
 #define PERF_MONITOR_H
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <mutex>
 #include <map>
+#include <memory>
+#include <set>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include "latency_histogram.h"
+
+using TraceId = uint64_t;
+using SpanId = uint64_t;
 
 struct InteractionMetrics {
-    int turn_id;
+    TraceId turn_id;
+    uint32_t session_id = 0;    // Server mode: which client session (0 = local agent)
     double vad_latency_ms;      // Time from speech end to VAD trigger
     double asr_latency_ms;      // Time for whisper to transcribe
     double llm_ttft_ms;         // Time to First Token
+    double first_sentence_ms;   // Time from LLM start to first complete sentence
     double tts_latency_ms;      // Time to first audio chunk
     double total_e2e_ms;        // Total Voice-to-Audio latency
     int token_count;
@@ -21,6 +34,53 @@ struct InteractionMetrics {
     std::string user_text;      // The phrase used for the test
 };
 
+// A finished span as stored in the per-thread buffers.
+// Times are microseconds since PerfMonitor start.
+struct SpanRecord {
+    TraceId trace_id;
+    SpanId span_id;
+    SpanId parent_id;   // 0 = child of the turn root
+    const char* name;   // Must be a string literal (never freed)
+    int64_t start_us;
+    int64_t end_us;
+    uint32_t thread_index;
+};
+
+// An open span. Plain value: can be started on one thread and ended on another.
+struct Span {
+    TraceId trace_id = 0;
+    SpanId span_id = 0;
+    SpanId parent_id = 0;
+    const char* name = "";
+    int64_t start_us = 0;
+};
+
+// Everything known about a finished turn, handed to turn listeners
+struct TurnTrace {
+    InteractionMetrics metrics;
+    int64_t origin_us;              // Turn start (endpoint), same clock as the spans
+    std::vector<SpanRecord> spans;
+};
+
+struct ThreadSpanBuffer;
+
+// Latencies kept as live HDR histograms (P50/P90/P99/P99.9 at any time)
+enum class LatencyMetric {
+    VadEndpoint,
+    ASR,
+    TTFT,
+    FirstSentence,
+    FirstAudio,
+    E2E,
+    InterruptToSilence,
+    Count
+};
+
+const char* latencyMetricName(LatencyMetric metric);
+
+// One turn as a JSON object with the CSV column names (the JSONL line format)
+std::string interactionMetricsJson(const InteractionMetrics& m);
+
 class PerfMonitor {
 public:
     static PerfMonitor& getInstance() {
@@ -28,16 +88,126 @@ public:
         return instance;
     }
 
-    void startTimer(const std::string& key);
-    double stopTimer(const std::string& key);
+    // --- Tracing ---
+    // Every user turn gets its own trace; spans of overlapping turns never collide.
+    // The turn root starts at `origin` (the endpoint) and ends at finishTurn().
+    TraceId beginTurn(std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now(),
+                      uint32_t session = 0);
+
+    Span startSpan(TraceId trace, const char* name, SpanId parent = 0);
+    double endSpan(const Span& span); // Returns duration in ms
+    void recordSpan(TraceId trace, const char* name,
+                    std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end,
+                    SpanId parent = 0);
+    void mark(TraceId trace, const char* name, SpanId parent = 0); // Zero-length span
+
+    // Collects the turn's spans, derives InteractionMetrics, logs and saves them
+    void finishTurn(TraceId trace, const std::string& user_text, int token_count);
+    // Turn produced no response (filtered ASR, backchannel, aborted)
+    void dropTurn(TraceId trace);
+
+    // Names the calling thread's track in the exported trace
+    void setThreadName(const std::string& name);
+
+    // --- Chrome Trace Event / Perfetto export ---
+    // Streams every span (turn or not) to a JSON array file that chrome://tracing
+    // and ui.perfetto.dev load directly. A background thread drains the span
+    // buffers every 200 ms, so the file is append-only and memory stays flat.
+    void startTraceExport(const std::string& filename = "pipeline_trace.json");
+    void stopTraceExport();
+    bool traceExportActive() const { return exporting; }
+
+    // --- Latency statistics ---
+    // logTurn() records the turn into the histograms and appends one line to
+    // the turn logs (benchmark_results.csv / .jsonl, truncated once per run),
+    // then rewrites the fixed-size latency_summary.json. Cost per turn is O(1), not O(turns).
     void logTurn(InteractionMetrics metrics);
-    void saveCSV(const std::string& filename = "benchmark_results.csv");
+    // Where logTurn appends; an empty path turns that file off. Set before the first turn
+    // (benches point these elsewhere so they don't clobber the agent's logs).
+    void setTurnLog(const std::string& csv_path, const std::string& jsonl_path);
+    // Summary rewritten after every turn ("" = never; call writeSummary() yourself) and the
+    // [METRICS] console block. The load test turns both off so turns don't serialize on them.
+    void setTurnSummary(const std::string& filename);
+    void setTurnConsole(bool enabled) { turn_console = enabled; }
+    void recordLatency(LatencyMetric metric, double ms);
+    const LatencyHistogram& histogram(LatencyMetric metric) const;
+    void printPercentiles();
+    void writeSummary(const std::string& filename = "latency_summary.json");
+    std::string summaryJson();      // Same document as latency_summary.json
+    uint64_t turnsLogged();
+
+    // Called on the finishing thread after every logged turn (e.g. live SSE export).
+    // A removed listener may still see a turn that was finishing while it was removed.
+    using TurnListener = std::function<void(const TurnTrace&)>;
+    uint64_t addTurnListener(TurnListener listener);
+    void removeTurnListener(uint64_t id);
 
 private:
-    PerfMonitor() {}
-    std::map<std::string, std::chrono::high_resolution_clock::time_point> timers;
-    std::vector<InteractionMetrics> history;
+    PerfMonitor();
+    ~PerfMonitor();
+
+    int64_t nowUs() const;
+    int64_t toUs(std::chrono::steady_clock::time_point t) const;
+    ThreadSpanBuffer& localBuffer();
+    void pushSpan(const SpanRecord& record);
+    void collectLocked(); // Drain thread-local buffers into pending (mtx held)
+    void appendTurnLogLocked(const InteractionMetrics& m);
+    void writeTraceEventLocked(const SpanRecord& r);
+    void writeThreadNamesLocked();
+    void exportLoop();
+
+    struct TurnState {
+        int64_t origin_us;
+        uint32_t session_id;
+    };
+
+    std::chrono::steady_clock::time_point epoch;
+    std::atomic<TraceId> next_trace;
+    std::atomic<SpanId> next_span;
+
+    std::mutex registry_mtx;
+    std::vector<std::shared_ptr<ThreadSpanBuffer>> buffers;
+    uint32_t next_thread_index = 0;
+    std::map<uint32_t, std::string> thread_names;
+
+    std::atomic<bool> exporting;
+    std::ofstream trace_file;
+    bool trace_first_event = true;
+    std::set<uint32_t> trace_named_threads;
+    std::thread export_thread;
+    std::mutex export_mtx;
+    std::condition_variable export_cv;
+
+    std::map<TraceId, TurnState> turns;
+    std::map<TraceId, std::vector<SpanRecord>> pending;
+    LatencyHistogram histograms[(int)LatencyMetric::Count];
+    std::string csv_path = "benchmark_results.csv";
+    std::string jsonl_path = "benchmark_results.jsonl";
+    bool turn_log_opened = false;
+    std::string summary_path = "latency_summary.json";
+    std::atomic<bool> turn_console{true};
+    std::ofstream csv_log;
+    std::ofstream jsonl_log;
+    uint64_t turns_logged = 0;
+    std::map<uint64_t, TurnListener> turn_listeners;
+    uint64_t next_listener = 1;
     std::mutex mtx;
 };
 
+// RAII helper: span covers the enclosing scope
+class ScopedSpan {
+public:
+    ScopedSpan(TraceId trace, const char* name, SpanId parent = 0)
+        : span(PerfMonitor::getInstance().startSpan(trace, name, parent)) {}
+    ~ScopedSpan() { PerfMonitor::getInstance().endSpan(span); }
+    SpanId id() const { return span.span_id; }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    Span span;
+};
+
 #endif // PERF_MONITOR_H
@@ -0,0 +1,118 @@
+#ifndef SOCKET_COMPAT_H
+#define SOCKET_COMPAT_H
+
+// Minimal Winsock / BSD sockets shim. Include from .cpp files only:
+// winsock2.h has to come before windows.h, which main.cpp pulls in first.
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#define CLOSE_SOCKET closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int socket_t;
+#ifndef INVALID_SOCKET
+#define INVALID_SOCKET (-1)
+#endif
+#define CLOSE_SOCKET close
+#endif
+
+#include <string>
+
+// WSAStartup on Windows; no-op elsewhere. Safe to call more than once.
+inline bool socketInit() {
+#ifdef _WIN32
+    static bool ok = [] {
+        WSADATA wsa;
+        return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+    }();
+    return ok;
+#else
+    return true;
+#endif
+}
+
+// Sends the whole buffer; false if the peer went away
+inline bool sendAll(socket_t s, const char* data, size_t len) {
+    while (len > 0) {
+#ifdef _WIN32
+        int n = send(s, data, (int)len, 0);
+#else
+        ssize_t n = send(s, data, len, MSG_NOSIGNAL);
+#endif
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+inline bool sendAll(socket_t s, const std::string& data) {
+    return sendAll(s, data.data(), data.size());
+}
+
+// Reads exactly len bytes; false on EOF or error
+inline bool recvAll(socket_t s, char* data, size_t len) {
+    while (len > 0) {
+#ifdef _WIN32
+        int n = recv(s, data, (int)len, 0);
+#else
+        ssize_t n = recv(s, data, len, 0);
+#endif
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+// Bounds how long recv() may block on this socket
+inline void setRecvTimeout(socket_t s, int ms) {
+#ifdef _WIN32
+    DWORD tv = (DWORD)ms;
+#else
+    timeval tv{ms / 1000, (ms % 1000) * 1000};
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+}
+
+// Same for send: a client that stops reading can't block a writer forever
+inline void setSendTimeout(socket_t s, int ms) {
+#ifdef _WIN32
+    DWORD tv = (DWORD)ms;
+#else
+    timeval tv{ms / 1000, (ms % 1000) * 1000};
+#endif
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+}
+
+// Listening TCP socket on host:port, INVALID_SOCKET on failure
+inline socket_t listenTcp(const std::string& host, int port, int backlog = 16) {
+    if (!socketInit()) return INVALID_SOCKET;
+    socket_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) return INVALID_SOCKET;
+
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+        bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(s, backlog) != 0) {
+        CLOSE_SOCKET(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+#endif // SOCKET_COMPAT_H
@@ -0,0 +1,82 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Lock-free single-producer / single-consumer ring buffer.
+// Storage is allocated once in the constructor; push/pop never allocate.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t min_capacity) : head(0), tail(0) {
+        size_t cap = 2;
+        while (cap < min_capacity) cap <<= 1;
+        buffer.resize(cap);
+        mask = cap - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return buffer.size(); }
+
+    // Approximate when called from a third thread; exact from producer/consumer.
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    // Producer only. Returns false if full.
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == buffer.size()) return false;
+        buffer[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Writes as many items as fit, returns the count written.
+    size_t push(const T* data, size_t count) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t free_slots = buffer.size() - (t - head.load(std::memory_order_acquire));
+        size_t n = std::min(count, free_slots);
+        for (size_t i = 0; i < n; ++i) buffer[(t + i) & mask] = data[i];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only.
+    bool pop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = buffer[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Reads up to count items, returns the count read.
+    size_t pop(T* out, size_t count) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t available = tail.load(std::memory_order_acquire) - h;
+        size_t n = std::min(count, available);
+        for (size_t i = 0; i < n; ++i) out[i] = buffer[(h + i) & mask];
+        head.store(h + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer only. Drops everything currently queued.
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // SPSC_RING_H